@@ -0,0 +1,229 @@
+#include "Test.h"
+#include <Engine/Entities/BoundingVolumeHierarchy.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace dx = DirectX;
+
+namespace
+{
+	// boxes scattered through a cube at a fixed density, so a query sees about as many of them
+	// whatever the count; sizes spread over an order of magnitude like a scene's meshes
+	float SceneSize(size_t count) noexcept
+	{
+		return 8.0f * std::cbrt(float(count));
+	}
+	std::vector<dx::BoundingBox> MakeBoxes(size_t count, std::mt19937& rng)
+	{
+		const auto half = SceneSize(count) * 0.5f;
+		std::uniform_real_distribution<float> position{ -half,half };
+		std::uniform_real_distribution<float> extent{ 0.1f,1.5f };
+		std::vector<dx::BoundingBox> boxes(count);
+		for (auto& box : boxes)
+		{
+			box.Center = { position(rng),position(rng),position(rng) };
+			box.Extents = { extent(rng),extent(rng),extent(rng) };
+		}
+		return boxes;
+	}
+	// what an animated subtree does to its meshes between a build and a refit
+	void Move(std::vector<dx::BoundingBox>& boxes, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> offset{ -4.0f,4.0f };
+		for (size_t i = rng() % 8u; i < boxes.size(); i += 8u)
+		{
+			boxes[i].Center.x += offset(rng);
+			boxes[i].Center.y += offset(rng);
+			boxes[i].Center.z += offset(rng);
+		}
+	}
+	// the view of a camera somewhere in the scene looking a random way, as Graphics::GetFrustum makes it
+	dx::BoundingFrustum MakeFrustum(float sceneSize, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> position{ -sceneSize * 0.5f,sceneSize * 0.5f };
+		std::uniform_real_distribution<float> angle{ -3.14159265f,3.14159265f };
+		dx::BoundingFrustum frustum;
+		dx::BoundingFrustum::CreateFromMatrix(frustum, dx::XMMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.5f, 60.0f));
+		const auto camera = dx::XMMatrixRotationRollPitchYaw(angle(rng) * 0.5f, angle(rng), 0.0f) *
+			dx::XMMatrixTranslation(position(rng), position(rng), position(rng));
+		frustum.Transform(frustum, camera);
+		return frustum;
+	}
+	struct Ray
+	{
+		dx::XMVECTOR origin;
+		dx::XMVECTOR direction;
+	};
+	Ray MakeRay(float sceneSize, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> position{ -sceneSize * 0.5f,sceneSize * 0.5f };
+		std::uniform_real_distribution<float> d{ -1.0f,1.0f };
+		return {
+			dx::XMVectorSet(position(rng),position(rng),position(rng),1.0f),
+			dx::XMVector3Normalize(dx::XMVectorSet(d(rng),d(rng),d(rng),0.0f))
+		};
+	}
+
+	// the visited primitives the per primitive test callers apply lets through, sorted; a
+	// primitive visited twice shows up twice
+	std::vector<uint32_t> QueryFrustum(const BoundingVolumeHierarchy& bvh, const std::vector<dx::BoundingBox>& boxes, const dx::BoundingFrustum& frustum)
+	{
+		std::vector<uint32_t> visible;
+		bvh.QueryFrustum(frustum, [&](uint32_t i)
+		{
+			if (frustum.Contains(boxes[i]) != dx::DISJOINT)
+			{
+				visible.push_back(i);
+			}
+		});
+		std::sort(visible.begin(), visible.end());
+		return visible;
+	}
+	std::vector<uint32_t> BruteForceFrustum(const std::vector<dx::BoundingBox>& boxes, const dx::BoundingFrustum& frustum)
+	{
+		std::vector<uint32_t> visible;
+		for (uint32_t i = 0; i < boxes.size(); i++)
+		{
+			if (frustum.Contains(boxes[i]) != dx::DISJOINT)
+			{
+				visible.push_back(i);
+			}
+		}
+		return visible;
+	}
+	// the distance to the nearest box along the ray, 0 for boxes the ray starts in
+	float QueryRay(const BoundingVolumeHierarchy& bvh, const std::vector<dx::BoundingBox>& boxes, const Ray& ray)
+	{
+		return bvh.QueryRay(ray.origin, ray.direction, FLT_MAX, [&](uint32_t i, float nearest)
+		{
+			float distance;
+			return boxes[i].Intersects(ray.origin, ray.direction, distance) ? std::min(std::max(distance, 0.0f), nearest) : nearest;
+		});
+	}
+	float BruteForceRay(const std::vector<dx::BoundingBox>& boxes, const Ray& ray)
+	{
+		float nearest = FLT_MAX;
+		for (const auto& box : boxes)
+		{
+			float distance;
+			if (box.Intersects(ray.origin, ray.direction, distance))
+			{
+				nearest = std::min(nearest, std::max(distance, 0.0f));
+			}
+		}
+		return nearest;
+	}
+}
+
+TEST(BvhQueryFrustumMatchesBruteForce)
+{
+	std::mt19937 rng{ 5u };
+	auto boxes = MakeBoxes(20000u, rng);
+	BoundingVolumeHierarchy bvh;
+	bvh.Build(boxes);
+	REQUIRE(bvh.GetPrimitiveCount() == boxes.size());
+	// once as built, then after boxes moved and the tree was refit
+	for (int pass = 0; pass < 2; pass++)
+	{
+		size_t nonEmpty = 0u;
+		for (int f = 0; f < 32; f++)
+		{
+			const auto frustum = MakeFrustum(SceneSize(boxes.size()), rng);
+			const auto expected = BruteForceFrustum(boxes, frustum);
+			nonEmpty += expected.empty() ? 0u : 1u;
+			if (QueryFrustum(bvh, boxes, frustum) != expected)
+			{
+				Test::Fail(__FILE__, __LINE__, "frustum " + std::to_string(f) + (pass == 0 ? " as built" : " after refit")
+					+ " doesn't see the boxes brute force does");
+			}
+		}
+		CHECK(nonEmpty > 16u);
+		Move(boxes, rng);
+		bvh.Refit(boxes);
+	}
+}
+
+TEST(BvhQueryRayMatchesBruteForce)
+{
+	std::mt19937 rng{ 9u };
+	auto boxes = MakeBoxes(20000u, rng);
+	BoundingVolumeHierarchy bvh;
+	bvh.Build(boxes);
+	for (int pass = 0; pass < 2; pass++)
+	{
+		size_t hits = 0u;
+		for (int r = 0; r < 512; r++)
+		{
+			const auto ray = MakeRay(SceneSize(boxes.size()), rng);
+			const auto expected = BruteForceRay(boxes, ray);
+			hits += expected < FLT_MAX ? 1u : 0u;
+			if (QueryRay(bvh, boxes, ray) != expected)
+			{
+				Test::Fail(__FILE__, __LINE__, "ray " + std::to_string(r) + (pass == 0 ? " as built" : " after refit")
+					+ " finds another nearest hit than brute force");
+			}
+		}
+		CHECK(hits > 128u);
+		Move(boxes, rng);
+		bvh.Refit(boxes);
+	}
+}
+
+BENCHMARK(BvhBuildRefitQuery)
+{
+	using Clock = std::chrono::steady_clock;
+	const auto seconds = [](Clock::time_point begin)
+	{
+		return std::chrono::duration<double>(Clock::now() - begin).count();
+	};
+	for (const size_t count : { 1000u,10000u,100000u,1000000u })
+	{
+		std::mt19937 rng{ 1u };
+		auto boxes = MakeBoxes(count, rng);
+		const auto sceneSize = SceneSize(count);
+		const auto label = std::to_string(count / 1000u) + "k primitives, ";
+		BoundingVolumeHierarchy bvh;
+
+		auto begin = Clock::now();
+		bvh.Build(boxes);
+		Test::Report(label + "build", seconds(begin) * 1e3, "ms");
+
+		Move(boxes, rng);
+		begin = Clock::now();
+		bvh.Refit(boxes);
+		Test::Report(label + "refit", seconds(begin) * 1e3, "ms");
+
+		constexpr int frustumCount = 64;
+		std::vector<dx::BoundingFrustum> frustums;
+		for (int f = 0; f < frustumCount; f++)
+		{
+			frustums.push_back(MakeFrustum(sceneSize, rng));
+		}
+		size_t visited = 0u;
+		begin = Clock::now();
+		for (const auto& frustum : frustums)
+		{
+			bvh.QueryFrustum(frustum, [&](uint32_t) { visited++; });
+		}
+		Test::Report(label + "frustum query", seconds(begin) / frustumCount * 1e6, "us");
+		Test::Report(label + "primitives per frustum", double(visited) / frustumCount, "");
+
+		constexpr int rayCount = 4096;
+		std::vector<Ray> rays;
+		for (int r = 0; r < rayCount; r++)
+		{
+			rays.push_back(MakeRay(sceneSize, rng));
+		}
+		begin = Clock::now();
+		for (const auto& ray : rays)
+		{
+			QueryRay(bvh, boxes, ray);
+		}
+		Test::Report(label + "nearest hit ray query", seconds(begin) / rayCount * 1e6, "us");
+	}
+}
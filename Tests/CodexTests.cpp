@@ -0,0 +1,362 @@
+#include "Test.h"
+#include <Engine/Architecture/Codex.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+	// the codex only hands gfx on to the bindables it builds, and the stubs never touch it
+	Graphics& NoDevice() noexcept
+	{
+		alignas(Graphics) static unsigned char storage[sizeof(Graphics)];
+		return *reinterpret_cast<Graphics*>(storage);
+	}
+
+	unsigned ThreadCount() noexcept
+	{
+		return std::max(std::thread::hardware_concurrency(), 8u);
+	}
+
+	// a bindable with no device object; Tag keeps the tests' keys apart in the shared codex
+	template<int Tag>
+	class StubBindable : public Bindable
+	{
+	public:
+		enum class Behavior
+		{
+			Build,
+			Slow,
+			// the first construction for an id throws, later ones succeed
+			FailOnce,
+		};
+	public:
+		StubBindable(Graphics&, int id_in, Behavior behavior = Behavior::Build, size_t footprint_in = 0u)
+			:
+			id(id_in)
+		{
+			constructions++;
+			if (behavior == Behavior::Slow)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+			}
+			if (behavior == Behavior::FailOnce && !failed[size_t(id) % failed.size()].exchange(true))
+			{
+				throw std::runtime_error("stub construction failed");
+			}
+			footprint = footprint_in;
+		}
+		void Bind(Graphics&, CommandStream&) noexcept override
+		{}
+		BindableKey GetUID() const noexcept override
+		{
+			return GenerateUID(id);
+		}
+		template<typename...Ignore>
+		static BindableKey GenerateUID(int id, Ignore&&...)
+		{
+			return BindableKey::Of<StubBindable>().Mix(id);
+		}
+	public:
+		const int id;
+		static inline std::atomic<int> constructions = 0;
+		static inline std::array<std::atomic<bool>, 64> failed = {};
+	};
+
+	// built from a payload, like the mesh buffers are from their vertices and indices
+	class PayloadStub : public Bindable
+	{
+	public:
+		PayloadStub(Graphics&, int id, const std::vector<int>& payload)
+			:
+			size(payload.size())
+		{}
+		void Bind(Graphics&, CommandStream&) noexcept override
+		{}
+		template<typename...Ignore>
+		static BindableKey GenerateUID(int id, Ignore&&...)
+		{
+			return BindableKey::Of<PayloadStub>().Mix(id);
+		}
+	public:
+		const size_t size;
+	};
+
+	// keyed by a path like the shaders and textures are
+	class PathStub : public Bindable
+	{
+	public:
+		PathStub(Graphics&, const std::string& path_in)
+			:
+			path(path_in)
+		{}
+		void Bind(Graphics&, CommandStream&) noexcept override
+		{}
+		static BindableKey GenerateUID(const std::string& path)
+		{
+			return BindableKey::Of<PathStub>().Mix(path);
+		}
+		// what the key used to be before BindableKey
+		static std::string GenerateStringUID(const std::string& path)
+		{
+			using namespace std::string_literals;
+			return typeid(PathStub).name() + "#"s + path;
+		}
+	public:
+		const std::string path;
+	};
+
+	// the codex as it was before sharding and hashed keys, for the benchmark to compare against
+	class StringCodex
+	{
+	public:
+		template<class T, typename ...Params>
+		std::shared_ptr<T> Resolve(Graphics& gfx, Params&& ...p)
+		{
+			const auto key = T::GenerateStringUID(p...);
+			const auto i = binds.find(key);
+			if (i == binds.end())
+			{
+				auto bind = std::make_shared<T>(gfx, std::forward<Params>(p)...);
+				binds[key] = bind;
+				return bind;
+			}
+			return std::static_pointer_cast<T>(i->second);
+		}
+	private:
+		std::unordered_map<std::string, std::shared_ptr<Bindable>> binds;
+	};
+
+	template<typename T>
+	size_t EntriesOf()
+	{
+		const auto stats = Codex::GetStats();
+		for (const auto& t : stats.types)
+		{
+			if (std::strcmp(t.typeName, typeid(T).name()) == 0)
+			{
+				return t.entries;
+			}
+		}
+		return 0u;
+	}
+}
+
+TEST(CodexResolveSameKeyBuildsOnce)
+{
+	using Stub = StubBindable<0>;
+	const auto threads = ThreadCount();
+	std::vector<std::shared_ptr<Stub>> results(threads);
+	Test::Hammer(threads, [&](unsigned t)
+	{
+		results[t] = Codex::Resolve<Stub>(NoDevice(), 7, Stub::Behavior::Slow);
+	});
+	CHECK(Stub::constructions == 1);
+	for (const auto& p : results)
+	{
+		REQUIRE(p != nullptr);
+		CHECK(p == results.front());
+		CHECK(p->id == 7);
+	}
+}
+
+TEST(CodexResolveManyKeysFromManyThreads)
+{
+	using Stub = StubBindable<1>;
+	constexpr int keyCount = 256;
+	const auto threads = ThreadCount();
+	std::vector<std::vector<std::shared_ptr<Stub>>> results(threads);
+	Test::Hammer(threads, [&](unsigned t)
+	{
+		// every thread asks for every key, each in its own order
+		std::vector<int> ids(keyCount);
+		std::iota(ids.begin(), ids.end(), 0);
+		std::shuffle(ids.begin(), ids.end(), std::mt19937{ t });
+		results[t].resize(keyCount);
+		for (const auto id : ids)
+		{
+			results[t][size_t(id)] = Codex::Resolve<Stub>(NoDevice(), id);
+		}
+	});
+	CHECK(Stub::constructions == keyCount);
+	CHECK(EntriesOf<Stub>() == keyCount);
+	for (int id = 0; id < keyCount; id++)
+	{
+		const auto& first = results[0][size_t(id)];
+		REQUIRE(first != nullptr);
+		CHECK(first->id == id);
+		for (const auto& r : results)
+		{
+			CHECK(r[size_t(id)] == first);
+		}
+	}
+}
+
+TEST(CodexFailedConstructionDoesNotPoisonKey)
+{
+	using Stub = StubBindable<2>;
+	const auto threads = ThreadCount();
+	std::atomic<int> thrown = 0;
+	std::atomic<int> built = 0;
+	Test::Hammer(threads, [&](unsigned)
+	{
+		try
+		{
+			const auto p = Codex::Resolve<Stub>(NoDevice(), 3, Stub::Behavior::FailOnce);
+			CHECK(p != nullptr && p->id == 3);
+			built++;
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown++;
+		}
+	});
+	// the failed construction reaches its own caller and whoever waited on it, nobody else
+	CHECK(thrown >= 1);
+	CHECK(thrown + built == int(threads));
+	// the key was dropped with the failure, so this resolve retries instead of rethrowing
+	const auto p = Codex::Resolve<Stub>(NoDevice(), 3, Stub::Behavior::FailOnce);
+	REQUIRE(p != nullptr);
+	CHECK(p->id == 3);
+	CHECK(EntriesOf<Stub>() == 1u);
+}
+
+TEST(CodexEvictionRacesResolve)
+{
+	using Stub = StubBindable<3>;
+	constexpr int keyCount = 64;
+	constexpr size_t footprint = 1024u;
+	// room for a quarter of the keys, the rest keeps getting evicted while being resolved
+	Codex::SetBudget(footprint * keyCount / 4u);
+	const auto threads = ThreadCount();
+	std::atomic<int> resolvers = int(threads) - 1;
+	Test::Hammer(threads, [&](unsigned t)
+	{
+		if (t == 0u)
+		{
+			while (resolvers > 0)
+			{
+				Codex::Trim();
+			}
+			return;
+		}
+		std::mt19937 rng{ t };
+		std::vector<std::shared_ptr<Stub>> held;
+		for (int i = 0; i < 2000; i++)
+		{
+			const int id = int(rng() % keyCount);
+			auto p = Codex::Resolve<Stub>(NoDevice(), id, Stub::Behavior::Build, footprint);
+			CHECK(p != nullptr && p->id == id);
+			// some are kept a while, which makes them unevictable
+			if (rng() % 4u == 0u)
+			{
+				held.push_back(std::move(p));
+			}
+			if (held.size() > 8u)
+			{
+				held.erase(held.begin());
+			}
+		}
+		resolvers--;
+	});
+	// held bindables may have kept it over budget, once they are released a trim gets it back under
+	Codex::Trim();
+	const auto stats = Codex::GetStats();
+	CHECK(stats.bytes <= stats.budget);
+	CHECK(stats.evictions > 0u);
+	// nothing outside holds them any more, with the budget lifted a trim drops them all
+	Codex::SetBudget(0u);
+	CHECK(EntriesOf<Stub>() == 0u);
+}
+
+TEST(CodexTypeTagSurvivesStats)
+{
+	using Stub = StubBindable<4>;
+	const auto p = Codex::Resolve<Stub>(NoDevice(), 1);
+	const auto q = Codex::Resolve<Stub>(NoDevice(), 1);
+	CHECK(p == q);
+	CHECK(EntriesOf<Stub>() == 1u);
+}
+
+TEST(CodexFindNeverBuilds)
+{
+	using Stub = StubBindable<5>;
+	const auto key = Stub::GenerateUID(2);
+	CHECK(Codex::Find<Stub>(key) == nullptr);
+	CHECK(Stub::constructions == 0);
+	const auto p = Codex::Resolve<Stub>(NoDevice(), 2);
+	CHECK(Codex::Find<Stub>(key) == p);
+	// another type under the same key is a collision, not a hit
+	CHECK(Codex::Find<StubBindable<6>>(key) == nullptr);
+	CHECK(Stub::constructions == 1);
+}
+
+TEST(CodexDeferredPayloadOnlyMadeOnMiss)
+{
+	int made = 0;
+	const auto makePayload = [&made]
+	{
+		made++;
+		return std::vector<int>(5u);
+	};
+	const auto p = Codex::Resolve<PayloadStub>(NoDevice(), 1, Codex::Defer(makePayload));
+	const auto q = Codex::Resolve<PayloadStub>(NoDevice(), 1, Codex::Defer(makePayload));
+	REQUIRE(p != nullptr);
+	CHECK(p == q);
+	CHECK(p->size == 5u);
+	CHECK(made == 1);
+}
+
+BENCHMARK(CodexResolveThroughput)
+{
+	using Clock = std::chrono::steady_clock;
+	constexpr size_t pathCount = 512u;
+	constexpr size_t resolveCount = 1u << 20;
+	std::vector<std::string> paths;
+	for (size_t i = 0; i < pathCount; i++)
+	{
+		paths.push_back("Models\\sponza\\textures\\material_" + std::to_string(i) + "_diffuse.png");
+	}
+	const auto measure = [&](const char* what, unsigned threads, auto&& resolve)
+	{
+		// first pass builds every entry, the measured one only hits
+		for (const auto& path : paths)
+		{
+			resolve(path);
+		}
+		const auto begin = Clock::now();
+		Test::Hammer(threads, [&](unsigned t)
+		{
+			for (size_t i = t; i < resolveCount; i += threads)
+			{
+				resolve(paths[(i * 7u) % pathCount]);
+			}
+		});
+		const std::chrono::duration<double> elapsed = Clock::now() - begin;
+		Test::Report(what, resolveCount / elapsed.count(), "resolves/s");
+	};
+
+	StringCodex before;
+	measure("string keys, one map (before)", 1u, [&](const std::string& path)
+	{
+		return before.Resolve<PathStub>(NoDevice(), path);
+	});
+	measure("hashed keys, sharded (after)", 1u, [&](const std::string& path)
+	{
+		return Codex::Resolve<PathStub>(NoDevice(), path);
+	});
+	// the string codex wasn't safe to share between threads, so there is nothing to compare this with
+	measure("hashed keys, sharded, all threads", std::thread::hardware_concurrency(), [&](const std::string& path)
+	{
+		return Codex::Resolve<PathStub>(NoDevice(), path);
+	});
+	Codex::Trim();
+}
@@ -0,0 +1,266 @@
+#include "Test.h"
+#include <Engine/CommandStream.h>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	// what a backend call received, payloads copied out since they only live for the call
+	struct Call
+	{
+		CommandStream::Op op;
+		uint32_t a = 0u;
+		uint32_t b = 0u;
+		uint32_t c = 0u;
+		int32_t base = 0;
+		const void* object = nullptr;
+		std::vector<unsigned char> payload;
+		bool operator==(const Call& rhs) const noexcept
+		{
+			return op == rhs.op && a == rhs.a && b == rhs.b && c == rhs.c && base == rhs.base &&
+				object == rhs.object && payload == rhs.payload;
+		}
+	};
+
+	class RecordingBackend : public CommandBackend
+	{
+		using Op = CommandStream::Op;
+	public:
+		void SetTopology(D3D11_PRIMITIVE_TOPOLOGY type) noexcept override
+		{
+			calls.push_back({ Op::SetTopology,uint32_t(type) });
+		}
+		void SetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format) noexcept override
+		{
+			calls.push_back({ Op::SetIndexBuffer,uint32_t(format),0u,0u,0,pBuffer });
+		}
+		void SetVertexBuffer(ID3D11Buffer* pBuffer, UINT stride) noexcept override
+		{
+			calls.push_back({ Op::SetVertexBuffer,stride,0u,0u,0,pBuffer });
+		}
+		void SetInputLayout(ID3D11InputLayout* pLayout) noexcept override
+		{
+			calls.push_back({ Op::SetInputLayout,0u,0u,0u,0,pLayout });
+		}
+		void SetVertexShader(ID3D11VertexShader* pShader) noexcept override
+		{
+			calls.push_back({ Op::SetVertexShader,0u,0u,0u,0,pShader });
+		}
+		void SetPixelShader(ID3D11PixelShader* pShader) noexcept override
+		{
+			calls.push_back({ Op::SetPixelShader,0u,0u,0u,0,pShader });
+		}
+		void SetVertexConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept override
+		{
+			calls.push_back({ Op::SetVertexConstantBuffer,slot,0u,0u,0,pBuffer });
+		}
+		void SetPixelConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept override
+		{
+			calls.push_back({ Op::SetPixelConstantBuffer,slot,0u,0u,0,pBuffer });
+		}
+		void SetPixelResource(UINT slot, ID3D11ShaderResourceView* pView) noexcept override
+		{
+			calls.push_back({ Op::SetPixelResource,slot,0u,0u,0,pView });
+		}
+		void SetPixelSampler(UINT slot, ID3D11SamplerState* pSampler) noexcept override
+		{
+			calls.push_back({ Op::SetPixelSampler,slot,0u,0u,0,pSampler });
+		}
+		void SetBlend(ID3D11BlendState* pState) noexcept override
+		{
+			calls.push_back({ Op::SetBlend,0u,0u,0u,0,pState });
+		}
+		void SetDepthStencil(ID3D11DepthStencilState* pState) noexcept override
+		{
+			calls.push_back({ Op::SetDepthStencil,0u,0u,0u,0,pState });
+		}
+		void SetRasterizer(ID3D11RasterizerState* pState) noexcept override
+		{
+			calls.push_back({ Op::SetRasterizer,0u,0u,0u,0,pState });
+		}
+		void UpdateBuffer(ID3D11Buffer* pBuffer, const void* pData, size_t size) noxnd override
+		{
+			const auto p = static_cast<const unsigned char*>(pData);
+			misaligned += (uintptr_t(pData) & 15u) != 0u;
+			calls.push_back({ Op::UpdateBuffer,uint32_t(size),0u,0u,0,pBuffer,{ p,p + size } });
+		}
+		void DrawIndexed(UINT count, UINT startIndex, INT baseVertex) noxnd override
+		{
+			calls.push_back({ Op::DrawIndexed,count,startIndex,0u,baseVertex });
+		}
+		void DrawIndexedInstanced(UINT count, UINT instances, UINT startIndex, INT baseVertex) noxnd override
+		{
+			calls.push_back({ Op::DrawIndexedInstanced,count,instances,startIndex,baseVertex });
+		}
+	public:
+		std::vector<Call> calls;
+		size_t misaligned = 0u;
+	};
+
+	// only counts, so the benchmark measures the stream and not the mock
+	class CountingBackend : public CommandBackend
+	{
+	public:
+		void SetTopology(D3D11_PRIMITIVE_TOPOLOGY) noexcept override { count++; }
+		void SetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT) noexcept override { count++; }
+		void SetVertexBuffer(ID3D11Buffer*, UINT) noexcept override { count++; }
+		void SetInputLayout(ID3D11InputLayout*) noexcept override { count++; }
+		void SetVertexShader(ID3D11VertexShader*) noexcept override { count++; }
+		void SetPixelShader(ID3D11PixelShader*) noexcept override { count++; }
+		void SetVertexConstantBuffer(UINT, ID3D11Buffer*) noexcept override { count++; }
+		void SetPixelConstantBuffer(UINT, ID3D11Buffer*) noexcept override { count++; }
+		void SetPixelResource(UINT, ID3D11ShaderResourceView*) noexcept override { count++; }
+		void SetPixelSampler(UINT, ID3D11SamplerState*) noexcept override { count++; }
+		void SetBlend(ID3D11BlendState*) noexcept override { count++; }
+		void SetDepthStencil(ID3D11DepthStencilState*) noexcept override { count++; }
+		void SetRasterizer(ID3D11RasterizerState*) noexcept override { count++; }
+		void UpdateBuffer(ID3D11Buffer*, const void* pData, size_t size) noxnd override
+		{
+			count++;
+			checksum += static_cast<const unsigned char*>(pData)[size - 1u];
+		}
+		void DrawIndexed(UINT, UINT, INT) noxnd override { count++; }
+		void DrawIndexedInstanced(UINT, UINT, UINT, INT) noxnd override { count++; }
+	public:
+		size_t count = 0u;
+		size_t checksum = 0u;
+	};
+
+	// stand-ins for device objects, the stream never dereferences what it records
+	template<typename T>
+	T* Fake(uintptr_t n) noexcept
+	{
+		return reinterpret_cast<T*>(n * 16u);
+	}
+
+	// the commands one draw of a phong mesh records
+	void RecordDraw(CommandStream& cmd, uint32_t n)
+	{
+		const float transforms[32] = { float(n) };
+		cmd.SetVertexBuffer(Fake<ID3D11Buffer>(1u + n % 8u), 32u);
+		cmd.SetIndexBuffer(Fake<ID3D11Buffer>(9u + n % 8u), DXGI_FORMAT_R16_UINT);
+		cmd.SetTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		cmd.SetInputLayout(Fake<ID3D11InputLayout>(20u));
+		cmd.SetVertexShader(Fake<ID3D11VertexShader>(21u));
+		cmd.SetPixelShader(Fake<ID3D11PixelShader>(22u));
+		cmd.SetPixelResource(0u, Fake<ID3D11ShaderResourceView>(23u + n % 4u));
+		cmd.SetPixelSampler(0u, Fake<ID3D11SamplerState>(30u));
+		cmd.UpdateBuffer(Fake<ID3D11Buffer>(31u), transforms, sizeof(transforms));
+		cmd.SetVertexConstantBuffer(0u, Fake<ID3D11Buffer>(31u));
+		cmd.DrawIndexed(36u, 0u, 0);
+	}
+}
+
+TEST(CommandStreamReplaysInRecordingOrder)
+{
+	using Op = CommandStream::Op;
+	CommandStream cmd;
+	const uint32_t lights[3] = { 1u,2u,3u };
+	const unsigned char odd[5] = { 9u,8u,7u,6u,5u };
+	cmd.SetTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	cmd.SetIndexBuffer(Fake<ID3D11Buffer>(1u), DXGI_FORMAT_R32_UINT);
+	cmd.SetVertexBuffer(Fake<ID3D11Buffer>(2u), 24u);
+	cmd.SetInputLayout(Fake<ID3D11InputLayout>(3u));
+	cmd.SetVertexShader(Fake<ID3D11VertexShader>(4u));
+	cmd.SetPixelShader(Fake<ID3D11PixelShader>(5u));
+	// odd sized first so the next block has to be realigned
+	cmd.UpdateBuffer(Fake<ID3D11Buffer>(6u), odd, sizeof(odd));
+	cmd.UpdateBuffer(Fake<ID3D11Buffer>(7u), lights, sizeof(lights));
+	cmd.SetVertexConstantBuffer(1u, Fake<ID3D11Buffer>(6u));
+	cmd.SetPixelConstantBuffer(2u, Fake<ID3D11Buffer>(7u));
+	cmd.SetPixelResource(3u, Fake<ID3D11ShaderResourceView>(8u));
+	cmd.SetPixelSampler(4u, Fake<ID3D11SamplerState>(9u));
+	cmd.SetBlend(Fake<ID3D11BlendState>(10u));
+	cmd.SetDepthStencil(Fake<ID3D11DepthStencilState>(11u));
+	cmd.SetRasterizer(Fake<ID3D11RasterizerState>(12u));
+	cmd.DrawIndexed(36u, 6u, -2);
+	cmd.DrawIndexedInstanced(12u, 40u, 3u, 5);
+	// filled in place after recording, what gets replayed is what was written last
+	auto pFilled = static_cast<float*>(cmd.UpdateBuffer(Fake<ID3D11Buffer>(13u), sizeof(float)));
+	*pFilled = 0.5f;
+
+	RecordingBackend backend;
+	cmd.Replay(backend);
+
+	const auto bytes = [](const void* p, size_t size)
+	{
+		const auto b = static_cast<const unsigned char*>(p);
+		return std::vector<unsigned char>{ b,b + size };
+	};
+	const float half = 0.5f;
+	const std::vector<Call> expected = {
+		{ Op::SetTopology,uint32_t(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST) },
+		{ Op::SetIndexBuffer,uint32_t(DXGI_FORMAT_R32_UINT),0u,0u,0,Fake<ID3D11Buffer>(1u) },
+		{ Op::SetVertexBuffer,24u,0u,0u,0,Fake<ID3D11Buffer>(2u) },
+		{ Op::SetInputLayout,0u,0u,0u,0,Fake<ID3D11InputLayout>(3u) },
+		{ Op::SetVertexShader,0u,0u,0u,0,Fake<ID3D11VertexShader>(4u) },
+		{ Op::SetPixelShader,0u,0u,0u,0,Fake<ID3D11PixelShader>(5u) },
+		{ Op::UpdateBuffer,uint32_t(sizeof(odd)),0u,0u,0,Fake<ID3D11Buffer>(6u),bytes(odd,sizeof(odd)) },
+		{ Op::UpdateBuffer,uint32_t(sizeof(lights)),0u,0u,0,Fake<ID3D11Buffer>(7u),bytes(lights,sizeof(lights)) },
+		{ Op::SetVertexConstantBuffer,1u,0u,0u,0,Fake<ID3D11Buffer>(6u) },
+		{ Op::SetPixelConstantBuffer,2u,0u,0u,0,Fake<ID3D11Buffer>(7u) },
+		{ Op::SetPixelResource,3u,0u,0u,0,Fake<ID3D11ShaderResourceView>(8u) },
+		{ Op::SetPixelSampler,4u,0u,0u,0,Fake<ID3D11SamplerState>(9u) },
+		{ Op::SetBlend,0u,0u,0u,0,Fake<ID3D11BlendState>(10u) },
+		{ Op::SetDepthStencil,0u,0u,0u,0,Fake<ID3D11DepthStencilState>(11u) },
+		{ Op::SetRasterizer,0u,0u,0u,0,Fake<ID3D11RasterizerState>(12u) },
+		{ Op::DrawIndexed,36u,6u,0u,-2 },
+		{ Op::DrawIndexedInstanced,12u,40u,3u,5 },
+		{ Op::UpdateBuffer,uint32_t(sizeof(float)),0u,0u,0,Fake<ID3D11Buffer>(13u),bytes(&half,sizeof(half)) },
+	};
+	CHECK(cmd.GetCommandCount() == expected.size());
+	REQUIRE(backend.calls.size() == expected.size());
+	for (size_t i = 0; i < expected.size(); i++)
+	{
+		CHECK(backend.calls[i] == expected[i]);
+	}
+	CHECK(backend.misaligned == 0u);
+}
+
+TEST(CommandStreamClearKeepsNothing)
+{
+	CommandStream cmd;
+	RecordDraw(cmd, 0u);
+	cmd.Clear();
+	CHECK(cmd.GetCommandCount() == 0u);
+	RecordingBackend backend;
+	cmd.Replay(backend);
+	CHECK(backend.calls.empty());
+	// recording again after a clear starts the payload over, blocks still replay their own data
+	RecordDraw(cmd, 5u);
+	cmd.Replay(backend);
+	REQUIRE(backend.calls.size() == cmd.GetCommandCount());
+	float first;
+	std::memcpy(&first, backend.calls[8].payload.data(), sizeof(first));
+	CHECK(first == 5.0f);
+}
+
+BENCHMARK(CommandStreamThroughput)
+{
+	using Clock = std::chrono::steady_clock;
+	constexpr uint32_t drawCount = 20000u;
+	constexpr int frameCount = 50;
+	CommandStream cmd;
+	CountingBackend backend;
+	double recordSeconds = 0.0;
+	double replaySeconds = 0.0;
+	size_t commands = 0u;
+	for (int f = 0; f < frameCount; f++)
+	{
+		cmd.Clear();
+		const auto begin = Clock::now();
+		for (uint32_t n = 0; n < drawCount; n++)
+		{
+			RecordDraw(cmd, n);
+		}
+		const auto recorded = Clock::now();
+		cmd.Replay(backend);
+		const auto replayed = Clock::now();
+		recordSeconds += std::chrono::duration<double>(recorded - begin).count();
+		replaySeconds += std::chrono::duration<double>(replayed - recorded).count();
+		commands += cmd.GetCommandCount();
+	}
+	CHECK(backend.count == commands);
+	Test::Report("record", commands / recordSeconds, "commands/s");
+	Test::Report("replay through CommandBackend", commands / replaySeconds, "commands/s");
+}
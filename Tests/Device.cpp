@@ -0,0 +1,55 @@
+#include "Device.h"
+#include "Test.h"
+#include <Engine/Entities/ImGUIManager.h>
+#include <cstdio>
+#include <memory>
+
+namespace
+{
+	class Fixture
+	{
+	public:
+		Fixture()
+		{
+			WNDCLASSEXA wc = { sizeof(wc) };
+			wc.lpfnWndProc = DefWindowProcA;
+			wc.hInstance = GetModuleHandleA(nullptr);
+			wc.lpszClassName = "WinD3D Tests";
+			RegisterClassExA(&wc);
+			// never shown, the swap chain only needs something to belong to
+			hWnd = CreateWindowExA(0, wc.lpszClassName, "", WS_OVERLAPPEDWINDOW,
+				0, 0, int(width), int(height), nullptr, nullptr, wc.hInstance, nullptr);
+			std::filesystem::current_path(Test::AppRoot());
+			try
+			{
+				pGfx = std::make_unique<Graphics>(hWnd, width, height);
+			}
+			catch (const Exception& e)
+			{
+				std::printf("  no device: %s\n", e.what());
+			}
+		}
+		~Fixture()
+		{
+			pGfx.reset();
+			DestroyWindow(hWnd);
+		}
+		Graphics* Get() noexcept
+		{
+			return pGfx.get();
+		}
+	private:
+		static constexpr unsigned width = 320u;
+		static constexpr unsigned height = 192u;
+		// Graphics sets up the imgui backend, it needs a context to do that in
+		ImGUIManager imgui;
+		HWND hWnd = nullptr;
+		std::unique_ptr<Graphics> pGfx;
+	};
+}
+
+Graphics* Test::Device()
+{
+	static Fixture fixture;
+	return fixture.Get();
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <Engine/Graphics.h>
+
+namespace Test
+{
+	// a hardware device on a hidden window, created on first use and kept for the whole run.
+	// the working directory moves to the app's, so shaders and models resolve as they do there.
+	// nullptr if there is no device to be had, the tests that need one fail
+	Graphics* Device();
+}
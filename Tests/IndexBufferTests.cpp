@@ -0,0 +1,144 @@
+#include "Test.h"
+#include "Device.h"
+#include <Engine/Architecture/IndexBuffer.h>
+#include <Engine/Architecture/Material.h>
+#include <Engine/Entities/Mesh.h>
+#include <Engine/Entities/ModelSource.h>
+#include <assimp/scene.h>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// a flat grid of side * side vertices in one object, past what 16 bit indices reach;
+	// written twice so the split and the whole import don't share codex tags
+	class LargeGrid
+	{
+	public:
+		static constexpr unsigned side = 300u;
+	public:
+		LargeGrid()
+			:
+			dir(std::filesystem::temp_directory_path() / "IndexBufferTests")
+		{
+			std::filesystem::remove_all(dir);
+			std::filesystem::create_directories(dir);
+			std::string obj = "o grid\n";
+			for (unsigned z = 0; z < side; z++)
+			{
+				for (unsigned x = 0; x < side; x++)
+				{
+					obj += "v " + std::to_string(x) + " 0 " + std::to_string(z) + "\n";
+				}
+			}
+			for (unsigned z = 0; z + 1u < side; z++)
+			{
+				for (unsigned x = 0; x + 1u < side; x++)
+				{
+					const auto i = z * side + x + 1u;
+					obj += "f " + std::to_string(i) + " " + std::to_string(i + side) + " " + std::to_string(i + 1u) + "\n";
+					obj += "f " + std::to_string(i + 1u) + " " + std::to_string(i + side) + " " + std::to_string(i + side + 1u) + "\n";
+				}
+			}
+			std::ofstream{ dir / "whole.obj" } << obj;
+			std::ofstream{ dir / "split.obj" } << obj;
+		}
+		~LargeGrid()
+		{
+			std::error_code error;
+			std::filesystem::remove_all(dir, error);
+		}
+		std::string Path(bool split) const
+		{
+			return (dir / (split ? "split.obj" : "whole.obj")).string();
+		}
+	private:
+		std::filesystem::path dir;
+	};
+
+	DXGI_FORMAT FormatOf(Graphics& gfx, std::vector<uint32_t> indices)
+	{
+		return IndexBuffer{ gfx,indices }.GetFormat();
+	}
+}
+
+TEST(IndexBufferFormatFollowsHighestIndex)
+{
+	const auto pGfx = Test::Device();
+	REQUIRE(pGfx != nullptr);
+	auto& gfx = *pGfx;
+	CHECK(FormatOf(gfx, {}) == DXGI_FORMAT_R16_UINT);
+	CHECK(FormatOf(gfx, { 0u,1u,2u }) == DXGI_FORMAT_R16_UINT);
+	CHECK(FormatOf(gfx, { 0u,0xFFFFu,1u }) == DXGI_FORMAT_R16_UINT);
+	CHECK(FormatOf(gfx, { 0u,0x10000u,1u }) == DXGI_FORMAT_R32_UINT);
+	CHECK(FormatOf(gfx, { 0xFFFFFFFFu,0u,1u }) == DXGI_FORMAT_R32_UINT);
+	CHECK(IndexBuffer(gfx, std::vector<unsigned short>{ 0u,1u,0xFFFFu }).GetFormat() == DXGI_FORMAT_R16_UINT);
+	// narrowing keeps the count, the width only changes how the buffer stores them
+	const std::vector<uint32_t> indices = { 7u,8u,9u,9u,8u,10u };
+	CHECK(IndexBuffer(gfx, indices).GetCount() == indices.size());
+}
+
+// splitting cuts the grid into parts 16 bit indices reach, each under its own name; the import
+// alone needs no device
+TEST(ModelSourceSplitsLargeMeshes)
+{
+	const LargeGrid grid;
+	const ModelSource whole{ grid.Path(false) };
+	REQUIRE(whole.GetScene() != nullptr);
+	REQUIRE(whole.GetMeshCount() == 1u);
+	CHECK(whole.GetScene()->mMeshes[0]->mNumVertices > ModelSource::splitVertexLimit);
+
+	const ModelSource split{ grid.Path(true), 1.0f, true };
+	const auto pScene = split.GetScene();
+	REQUIRE(pScene != nullptr);
+	CHECK(split.GetMeshCount() > 1u);
+	std::set<std::string> names;
+	size_t vertexCount = 0u;
+	for (unsigned int i = 0; i < pScene->mNumMeshes; i++)
+	{
+		const auto& mesh = *pScene->mMeshes[i];
+		if (mesh.mNumVertices > ModelSource::splitVertexLimit)
+		{
+			Test::Fail(__FILE__, __LINE__, "part " + std::to_string(i) + " has " + std::to_string(mesh.mNumVertices) + " vertices");
+		}
+		if (!names.insert(mesh.mName.C_Str()).second)
+		{
+			Test::Fail(__FILE__, __LINE__, std::string("part name ") + mesh.mName.C_Str() + " is taken twice");
+		}
+		vertexCount += mesh.mNumVertices;
+	}
+	// parts share the vertices along their cuts, none go missing
+	CHECK(vertexCount >= LargeGrid::side * LargeGrid::side);
+}
+
+// what the meshes made from either import draw with: the whole grid needs the wide format,
+// every part gets by with the narrow one
+TEST(ModelSourceSplitMeshesUse16BitIndices)
+{
+	const auto pGfx = Test::Device();
+	REQUIRE(pGfx != nullptr);
+	auto& gfx = *pGfx;
+	const LargeGrid grid;
+	const auto formats = [&](bool splitLargeMeshes)
+	{
+		ModelSource source{ grid.Path(splitLargeMeshes), 1.0f, splitLargeMeshes };
+		std::vector<DXGI_FORMAT> result;
+		for (size_t i = 0; i < source.GetMeshCount(); i++)
+		{
+			const auto pMaterial = source.MakeMaterial(gfx, source.GetMeshMaterial(i));
+			const auto pMesh = source.MakeMesh(gfx, *pMaterial, i);
+			result.push_back(pMesh->GetIndexBuffer()->GetFormat());
+		}
+		return result;
+	};
+	CHECK(formats(false) == std::vector<DXGI_FORMAT>{ DXGI_FORMAT_R32_UINT });
+	const auto parts = formats(true);
+	CHECK(parts.size() > 1u);
+	for (const auto format : parts)
+	{
+		CHECK(format == DXGI_FORMAT_R16_UINT);
+	}
+}
@@ -0,0 +1,87 @@
+#include "Test.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+namespace
+{
+	size_t failures = 0u;
+}
+
+std::vector<Test::Case>& Test::Registry()
+{
+	static std::vector<Case> cases;
+	return cases;
+}
+
+void Test::Fail(const char* file, int line, std::string_view what)
+{
+	failures++;
+	std::printf("  %s(%d): failed %.*s\n", file, line, int(what.size()), what.data());
+}
+
+void Test::Report(std::string_view what, double value, std::string_view unit)
+{
+	std::printf("  %-48.*s %14.3f %.*s\n", int(what.size()), what.data(), value, int(unit.size()), unit.data());
+}
+
+const std::filesystem::path& Test::Root()
+{
+	// built with full paths (/FC), so this file's path finds the directory wherever it was checked out
+	static const auto root = std::filesystem::path{ __FILE__ }.parent_path();
+	return root;
+}
+
+std::filesystem::path Test::AppRoot()
+{
+	return Root().parent_path() / "WinD3D";
+}
+
+// runs every test, or those whose name contains one of the arguments; --bench runs the benchmarks instead
+int main(int argc, char** argv)
+{
+	bool benchmarks = false;
+	std::vector<const char*> filters;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--bench") == 0)
+		{
+			benchmarks = true;
+		}
+		else
+		{
+			filters.push_back(argv[i]);
+		}
+	}
+	size_t run = 0u;
+	size_t failed = 0u;
+	for (const auto& c : Test::Registry())
+	{
+		if (c.benchmark != benchmarks)
+		{
+			continue;
+		}
+		if (!filters.empty() && std::none_of(filters.begin(), filters.end(), [&c](const char* f) { return std::strstr(c.name, f) != nullptr; }))
+		{
+			continue;
+		}
+		std::printf("%s\n", c.name);
+		const auto before = failures;
+		try
+		{
+			c.pRun();
+		}
+		catch (const std::exception& e)
+		{
+			Test::Fail(__FILE__, __LINE__, std::string("threw ") + e.what());
+		}
+		run++;
+		if (failures != before)
+		{
+			failed++;
+		}
+	}
+	std::printf("%zu of %zu %s passed\n", run - failed, run, benchmarks ? "benchmarks" : "tests");
+	return failed == 0u ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#include "Test.h"
+#include "Device.h"
+#include <Engine/Architecture/Material.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+
+namespace
+{
+	// one per phong shader variant, maps relative to the model like an import gives them
+	std::vector<Material::Description> Variants()
+	{
+		std::vector<Material::Description> variants(6u);
+		variants[0].name = "plain";
+		variants[1].name = "dif";
+		variants[1].diffuseMap = "arm_dif.png";
+		variants[2].name = "difspc";
+		variants[2].diffuseMap = "body_dif.png";
+		variants[2].specularMap = "body_showroom_spec.png";
+		variants[3].name = "difnrm";
+		variants[3].diffuseMap = "hand_dif.png";
+		variants[3].normalMap = "hand_showroom_ddn.png";
+		variants[4].name = "difspcnrm";
+		variants[4].diffuseMap = "leg_dif.png";
+		variants[4].specularMap = "leg_showroom_spec.png";
+		variants[4].normalMap = "leg_showroom_ddn.png";
+		variants[5].name = "masked";
+		variants[5].diffuseMap = "..\\brick_wall\\sponza_thorn_diff.png";
+		variants[5].specularMap = "..\\brick_wall\\sponza_thorn_spec.png";
+		variants[5].normalMap = "..\\brick_wall\\sponza_thorn_ddn.png";
+		return variants;
+	}
+}
+
+// models build their materials on several threads; everything a material creates that is shared
+// (the codex entries, the layout codex, the transform cbufs' static buffers) is created by
+// whichever thread gets there first. the statics are only raced the first time they are made in
+// the process, so this test means the most when it runs on its own
+TEST(MaterialConcurrentConstruction)
+{
+	const auto pGfx = Test::Device();
+	REQUIRE(pGfx != nullptr);
+	const auto variants = Variants();
+	const std::filesystem::path model = "Models\\nano_textured\\nanosuit.obj";
+	const auto threads = std::max(std::thread::hardware_concurrency(), 8u);
+	std::vector<std::unique_ptr<Material>> materials(threads * variants.size());
+	Test::Hammer(threads, [&](unsigned t)
+	{
+		// each thread starts at another variant, so every variant is first built by several at once
+		for (size_t i = 0; i < variants.size(); i++)
+		{
+			const auto v = (t + i) % variants.size();
+			materials[t * variants.size() + v] = std::make_unique<Material>(*pGfx, variants[v], model);
+		}
+	});
+	for (size_t v = 0; v < variants.size(); v++)
+	{
+		const Material reference{ *pGfx,variants[v],model };
+		for (unsigned t = 0; t < threads; t++)
+		{
+			const auto& pMaterial = materials[t * variants.size() + v];
+			REQUIRE(pMaterial != nullptr);
+			CHECK(pMaterial->GetVertexLayout().GetCode() == reference.GetVertexLayout().GetCode());
+			CHECK(pMaterial->IsMasked() == reference.IsMasked());
+			CHECK(pMaterial->GetTechniques().size() == reference.GetTechniques().size());
+		}
+	}
+}
@@ -0,0 +1,167 @@
+#include "Test.h"
+#include <Engine/Entities/MeshOptimizer.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <string>
+
+namespace dx = DirectX;
+
+namespace
+{
+	struct MeshData
+	{
+		std::vector<dx::XMFLOAT3> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	// the same vertex identity the engine optimizes, its import flags decide which vertices are shared
+	std::vector<MeshData> Import(const std::filesystem::path& path)
+	{
+		Assimp::Importer importer;
+		const auto pScene = importer.ReadFile(path.string(),
+			aiProcess_Triangulate |
+			aiProcess_JoinIdenticalVertices |
+			aiProcess_ConvertToLeftHanded |
+			aiProcess_GenNormals |
+			aiProcess_CalcTangentSpace
+		);
+		std::vector<MeshData> meshes;
+		if (pScene == nullptr)
+		{
+			return meshes;
+		}
+		for (unsigned int m = 0; m < pScene->mNumMeshes; m++)
+		{
+			const auto& mesh = *pScene->mMeshes[m];
+			auto& data = meshes.emplace_back();
+			for (unsigned int i = 0; i < mesh.mNumVertices; i++)
+			{
+				const auto& v = mesh.mVertices[i];
+				data.positions.push_back({ v.x,v.y,v.z });
+			}
+			for (unsigned int f = 0; f < mesh.mNumFaces; f++)
+			{
+				const auto& face = mesh.mFaces[f];
+				if (face.mNumIndices == 3u)
+				{
+					data.indices.insert(data.indices.end(), face.mIndices, face.mIndices + 3u);
+				}
+			}
+		}
+		return meshes;
+	}
+
+	// triangles as the vertices they were imported with, each rotated to start at its lowest
+	// vertex so the winding is kept but not where it starts, sorted
+	std::vector<std::array<uint32_t, 3u>> Triangles(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& original)
+	{
+		std::vector<std::array<uint32_t, 3u>> triangles;
+		for (size_t i = 0; i + 2u < indices.size(); i += 3u)
+		{
+			std::array<uint32_t, 3u> t = { original[indices[i]],original[indices[i + 1u]],original[indices[i + 2u]] };
+			std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+			triangles.push_back(t);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// Optimize reorders triangles and vertices; every vertex carries its import index in its
+	// texcoord so the triangles can be traced back to what was imported
+	void CheckSameTriangles(const std::filesystem::path& path)
+	{
+		const auto meshes = Import(path);
+		REQUIRE(!meshes.empty());
+		// triangle weighted sums
+		double acmrBefore = 0.0;
+		double acmrAfter = 0.0;
+		for (const auto& mesh : meshes)
+		{
+			DV::VertexBuffer vertices{ DV::VertexLayout{} + DV::Type::Position3D + DV::Type::Texture2D };
+			std::vector<uint32_t> identity;
+			for (uint32_t i = 0; i < mesh.positions.size(); i++)
+			{
+				vertices.EmplaceBack(mesh.positions[i], dx::XMFLOAT2{ float(i),0.0f });
+				identity.push_back(i);
+			}
+			auto indices = mesh.indices;
+			MeshOptimizer::Optimize(vertices, indices);
+			std::vector<uint32_t> original;
+			for (size_t i = 0; i < vertices.Count(); i++)
+			{
+				const auto& v = vertices[i].Attr<DV::Type::Texture2D>();
+				original.push_back(uint32_t(v.x));
+				// the positions went with their vertices
+				const auto& p = vertices[i].Attr<DV::Type::Position3D>();
+				const auto& q = mesh.positions[original.back()];
+				CHECK(p.x == q.x && p.y == q.y && p.z == q.z);
+			}
+			CHECK(indices.size() == mesh.indices.size());
+			CHECK(Triangles(indices, original) == Triangles(mesh.indices, identity));
+
+			const auto triangles = double(mesh.indices.size() / 3u);
+			acmrBefore += MeshOptimizer::Analyze(mesh.indices, mesh.positions.size()).acmr * triangles;
+			acmrAfter += MeshOptimizer::Analyze(indices, vertices.Count()).acmr * triangles;
+		}
+		// single meshes may come out a little worse, the model as a whole must not
+		CHECK(acmrAfter <= acmrBefore);
+	}
+
+	// acmr weighted by triangles and atvr by vertices over all of a model's meshes, before
+	// and after OptimizeTriangles and OptimizeFetch
+	void ReportCacheStats(const std::string& name, const std::filesystem::path& path)
+	{
+		using Clock = std::chrono::steady_clock;
+		const auto meshes = Import(path);
+		REQUIRE(!meshes.empty());
+		double acmrBefore = 0.0;
+		double acmrAfter = 0.0;
+		double atvrBefore = 0.0;
+		double atvrAfter = 0.0;
+		size_t triangleCount = 0u;
+		size_t vertexCount = 0u;
+		std::chrono::duration<double> elapsed{ 0.0 };
+		for (const auto& mesh : meshes)
+		{
+			const auto triangles = mesh.indices.size() / 3u;
+			const auto meshBefore = MeshOptimizer::Analyze(mesh.indices, mesh.positions.size());
+			const auto begin = Clock::now();
+			auto indices = MeshOptimizer::OptimizeTriangles(mesh.positions, mesh.indices);
+			MeshOptimizer::OptimizeFetch(indices, mesh.positions.size());
+			elapsed += Clock::now() - begin;
+			const auto meshAfter = MeshOptimizer::Analyze(indices, mesh.positions.size());
+			acmrBefore += meshBefore.acmr * triangles;
+			acmrAfter += meshAfter.acmr * triangles;
+			atvrBefore += meshBefore.atvr * mesh.positions.size();
+			atvrAfter += meshAfter.atvr * mesh.positions.size();
+			triangleCount += triangles;
+			vertexCount += mesh.positions.size();
+		}
+		Test::Report(name + " triangles", double(triangleCount), "");
+		Test::Report(name + " ACMR as imported", acmrBefore / triangleCount, "");
+		Test::Report(name + " ACMR optimized", acmrAfter / triangleCount, "");
+		Test::Report(name + " ATVR as imported", atvrBefore / vertexCount, "");
+		Test::Report(name + " ATVR optimized", atvrAfter / vertexCount, "");
+		Test::Report(name + " optimize", elapsed.count() * 1e3, "ms");
+	}
+}
+
+TEST(MeshOptimizerGoblinKeepsTriangles)
+{
+	CheckSameTriangles(Test::AppRoot() / "Models" / "gobber" / "GoblinX.obj");
+}
+
+TEST(MeshOptimizerNanosuitKeepsTriangles)
+{
+	CheckSameTriangles(Test::AppRoot() / "Models" / "nano_textured" / "nanosuit.obj");
+}
+
+BENCHMARK(MeshOptimizerCacheStats)
+{
+	ReportCacheStats("GoblinX", Test::AppRoot() / "Models" / "gobber" / "GoblinX.obj");
+	ReportCacheStats("nanosuit", Test::AppRoot() / "Models" / "nano_textured" / "nanosuit.obj");
+}
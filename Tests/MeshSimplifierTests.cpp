@@ -0,0 +1,158 @@
+#include "Test.h"
+#include <Engine/Entities/MeshSimplifier.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <string>
+
+namespace dx = DirectX;
+
+namespace
+{
+	struct MeshData
+	{
+		std::vector<dx::XMFLOAT3> positions;
+		std::vector<uint32_t> indices;
+		float radius = 0.0f;
+	};
+
+	// the same vertex identity the engine simplifies, its import flags decide which vertices are shared
+	std::vector<MeshData> Import(const std::filesystem::path& path)
+	{
+		Assimp::Importer importer;
+		const auto pScene = importer.ReadFile(path.string(),
+			aiProcess_Triangulate |
+			aiProcess_JoinIdenticalVertices |
+			aiProcess_ConvertToLeftHanded |
+			aiProcess_GenNormals |
+			aiProcess_CalcTangentSpace
+		);
+		std::vector<MeshData> meshes;
+		if (pScene == nullptr)
+		{
+			return meshes;
+		}
+		for (unsigned int m = 0; m < pScene->mNumMeshes; m++)
+		{
+			const auto& mesh = *pScene->mMeshes[m];
+			auto& data = meshes.emplace_back();
+			dx::XMFLOAT3 lo = { FLT_MAX,FLT_MAX,FLT_MAX };
+			dx::XMFLOAT3 hi = { -FLT_MAX,-FLT_MAX,-FLT_MAX };
+			for (unsigned int i = 0; i < mesh.mNumVertices; i++)
+			{
+				const auto& v = mesh.mVertices[i];
+				data.positions.push_back({ v.x,v.y,v.z });
+				lo = { std::min(lo.x, v.x),std::min(lo.y, v.y),std::min(lo.z, v.z) };
+				hi = { std::max(hi.x, v.x),std::max(hi.y, v.y),std::max(hi.z, v.z) };
+			}
+			for (unsigned int f = 0; f < mesh.mNumFaces; f++)
+			{
+				const auto& face = mesh.mFaces[f];
+				if (face.mNumIndices == 3u)
+				{
+					data.indices.insert(data.indices.end(), face.mIndices, face.mIndices + 3u);
+				}
+			}
+			// half the box diagonal, close enough to the bounding sphere the lod budget comes from
+			const dx::XMFLOAT3 size = { hi.x - lo.x,hi.y - lo.y,hi.z - lo.z };
+			data.radius = 0.5f * std::sqrt(size.x * size.x + size.y * size.y + size.z * size.z);
+		}
+		return meshes;
+	}
+
+	bool IsValid(const std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		return indices.size() % 3u == 0u &&
+			std::all_of(indices.begin(), indices.end(), [vertexCount](uint32_t i) { return i < vertexCount; });
+	}
+
+	// meshes under this many triangles get no lods in the engine (Mesh::minLodTriangles * 2)
+	constexpr size_t minTriangles = 128u;
+
+	// walks every mesh down its lod chain the way Mesh::BuildLods does (half the triangles per
+	// level, error budget doubling from a pixel at a quarter screen), simplifying each level twice
+	void CheckLods(const std::filesystem::path& path)
+	{
+		const auto meshes = Import(path);
+		REQUIRE(!meshes.empty());
+		for (const auto& mesh : meshes)
+		{
+			if (mesh.indices.size() / 3u < minTriangles)
+			{
+				continue;
+			}
+			auto coarsest = mesh.indices;
+			auto coverage = 0.25f;
+			for (int lod = 1; lod < 4; lod++)
+			{
+				const auto target = coarsest.size() / 6u * 3u;
+				const auto maxError = mesh.radius / (coverage * 360.0f);
+				float error = -1.0f;
+				float errorAgain = -1.0f;
+				const auto first = MeshSimplifier::Simplify(mesh.positions, coarsest, target, maxError, &error);
+				const auto second = MeshSimplifier::Simplify(mesh.positions, coarsest, target, maxError, &errorAgain);
+				CHECK(first == second);
+				CHECK(error == errorAgain);
+				CHECK(IsValid(first, mesh.positions.size()));
+				CHECK(error >= 0.0f && error <= maxError);
+				CHECK(first.size() <= coarsest.size());
+				// a mesh of any size has enough room for its first halving within a pixel
+				if (lod == 1 && mesh.indices.size() / 3u >= 4u * minTriangles)
+				{
+					CHECK(first.size() <= target);
+				}
+				// further down the error budget or borders that don't move stop it short
+				if (first.size() > target)
+				{
+					break;
+				}
+				coarsest = first;
+				coverage *= 0.5f;
+			}
+		}
+	}
+
+	// with no error budget to stop it, only open edges may keep a mesh from getting down to the target
+	void CheckTargetReached(const std::filesystem::path& path)
+	{
+		const auto meshes = Import(path);
+		REQUIRE(!meshes.empty());
+		for (const auto& mesh : meshes)
+		{
+			// the small ones are mostly border strips, nothing in them can collapse
+			if (mesh.indices.size() / 3u < minTriangles)
+			{
+				continue;
+			}
+			const auto target = mesh.indices.size() / 6u * 3u;
+			float error = -1.0f;
+			const auto simplified = MeshSimplifier::Simplify(mesh.positions, mesh.indices, target, mesh.radius * 4.0f, &error);
+			CHECK(simplified.size() <= target);
+			CHECK(simplified == MeshSimplifier::Simplify(mesh.positions, mesh.indices, target, mesh.radius * 4.0f));
+			CHECK(error >= 0.0f && error <= mesh.radius * 4.0f);
+		}
+	}
+}
+
+TEST(MeshSimplifierGoblinLods)
+{
+	CheckLods(Test::AppRoot() / "Models" / "gobber" / "GoblinX.obj");
+}
+
+TEST(MeshSimplifierNanosuitLods)
+{
+	CheckLods(Test::AppRoot() / "Models" / "nano_textured" / "nanosuit.obj");
+}
+
+TEST(MeshSimplifierGoblinReachesTarget)
+{
+	CheckTargetReached(Test::AppRoot() / "Models" / "gobber" / "GoblinX.obj");
+}
+
+TEST(MeshSimplifierNanosuitReachesTarget)
+{
+	CheckTargetReached(Test::AppRoot() / "Models" / "nano_textured" / "nanosuit.obj");
+}
@@ -0,0 +1,340 @@
+#include "Test.h"
+#include <Engine/Entities/ModelCache.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace dx = DirectX;
+
+namespace
+{
+	constexpr unsigned importFlags =
+		aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_ConvertToLeftHanded |
+		aiProcess_GenNormals |
+		aiProcess_CalcTangentSpace;
+	constexpr float scale = 1.0f;
+
+	// byte offsets into the file, as ModelCache lays out its header and node records
+	constexpr size_t headerNodesOffset = 32u;
+	constexpr size_t headerNodeCountOffset = 68u;
+	constexpr size_t nodeChildCountOffset = 72u;
+
+	// a quad with a material from a library next to it, so the import reads two files
+	class Scratch
+	{
+	public:
+		Scratch()
+			:
+			dir(std::filesystem::temp_directory_path() / "ModelCacheTests")
+		{
+			std::filesystem::remove_all(dir);
+			std::filesystem::create_directories(dir);
+			std::ofstream{ dir / "quad.mtl" } << "newmtl paint\nKd 0.5 0.25 0.125\nNs 16\n";
+			std::ofstream{ dir / "quad.obj" } <<
+				"mtllib quad.mtl\n"
+				"o quad\n"
+				"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+				"usemtl paint\n"
+				"f 1 2 3\nf 1 3 4\n";
+		}
+		~Scratch()
+		{
+			std::error_code error;
+			std::filesystem::remove_all(dir, error);
+		}
+		std::string Model() const
+		{
+			return (dir / "quad.obj").string();
+		}
+		std::filesystem::path Cache() const
+		{
+			return dir / "quad.obj.cache";
+		}
+		std::filesystem::path Library() const
+		{
+			return dir / "quad.mtl";
+		}
+	private:
+		std::filesystem::path dir;
+	};
+
+	std::vector<unsigned char> ReadBytes(const std::filesystem::path& path)
+	{
+		std::ifstream in{ path,std::ios::binary };
+		return { std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>() };
+	}
+	void WriteBytes(const std::filesystem::path& path, const std::vector<unsigned char>& bytes)
+	{
+		std::ofstream out{ path,std::ios::binary | std::ios::trunc };
+		out.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+	}
+	template<typename T>
+	void Patch(std::vector<unsigned char>& bytes, size_t offset, T value)
+	{
+		std::memcpy(bytes.data() + offset, &value, sizeof(value));
+	}
+	template<typename T>
+	T Peek(const std::vector<unsigned char>& bytes, size_t offset)
+	{
+		T value;
+		std::memcpy(&value, bytes.data() + offset, sizeof(value));
+		return value;
+	}
+
+	bool Opens(const Scratch& scratch)
+	{
+		ModelCache cache;
+		return cache.Open(scratch.Model(), importFlags, scale);
+	}
+
+	// what Model cooks, only with the positions as the vertices and two lods
+	struct Cooked
+	{
+		std::vector<Material::Description> materials;
+		std::vector<ModelCache::MeshData> meshes;
+	};
+	Cooked Cook(const aiScene& scene)
+	{
+		Cooked cooked;
+		for (unsigned int i = 0; i < scene.mNumMaterials; i++)
+		{
+			auto& description = cooked.materials.emplace_back();
+			description.name = "material " + std::to_string(i);
+			description.diffuseMap = "diffuse.png";
+			description.shininess = 16.0f;
+		}
+		for (unsigned int i = 0; i < scene.mNumMeshes; i++)
+		{
+			const auto& mesh = *scene.mMeshes[i];
+			auto& data = cooked.meshes.emplace_back();
+			data.name = mesh.mName.C_Str();
+			data.material = mesh.mMaterialIndex;
+			data.stride = sizeof(dx::XMFLOAT3);
+			data.quantization.origin = { -1.0f,-1.0f,-1.0f };
+			data.quantization.extent = 2.0f;
+			const auto pPositions = reinterpret_cast<const unsigned char*>(mesh.mVertices);
+			data.vertices.assign(pPositions, pPositions + mesh.mNumVertices * sizeof(aiVector3D));
+			std::vector<uint32_t> indices;
+			for (unsigned int f = 0; f < mesh.mNumFaces; f++)
+			{
+				indices.insert(indices.end(), mesh.mFaces[f].mIndices, mesh.mFaces[f].mIndices + mesh.mFaces[f].mNumIndices);
+			}
+			data.lods.emplace_back(indices.begin(), indices.begin() + 3u);
+			data.lods.insert(data.lods.begin(), std::move(indices));
+		}
+		return cooked;
+	}
+
+	// imports the scratch model and cooks it, with change applied to what gets written
+	template<typename F>
+	bool ImportAndWrite(const Scratch& scratch, F&& change)
+	{
+		Assimp::Importer importer;
+		ModelCache::TrackDependencies(importer);
+		const auto pScene = importer.ReadFile(scratch.Model(), importFlags);
+		if (pScene == nullptr)
+		{
+			return false;
+		}
+		auto cooked = Cook(*pScene);
+		change(cooked);
+		return ModelCache::Write(scratch.Model(), importFlags, scale, importer, cooked.materials, cooked.meshes);
+	}
+	bool ImportAndWrite(const Scratch& scratch)
+	{
+		return ImportAndWrite(scratch, [](Cooked&) {});
+	}
+
+	void CheckNodes(const ModelCache& cache, const aiNode& node, size_t& next)
+	{
+		const auto view = cache.GetNode(next++);
+		CHECK(view.name == node.mName.C_Str());
+		CHECK(view.childCount == node.mNumChildren);
+		CHECK(view.meshCount == node.mNumMeshes);
+		CHECK(std::memcmp(view.pTransform, &node.mTransformation, sizeof(dx::XMFLOAT4X4)) == 0);
+		for (unsigned int i = 0; i < node.mNumMeshes && i < view.meshCount; i++)
+		{
+			CHECK(view.pMeshes[i] == node.mMeshes[i]);
+		}
+		for (unsigned int i = 0; i < node.mNumChildren; i++)
+		{
+			CheckNodes(cache, *node.mChildren[i], next);
+		}
+	}
+}
+
+TEST(ModelCacheRoundTrip)
+{
+	const Scratch scratch;
+	Assimp::Importer importer;
+	ModelCache::TrackDependencies(importer);
+	const auto pScene = importer.ReadFile(scratch.Model(), importFlags);
+	REQUIRE(pScene != nullptr);
+	const auto cooked = Cook(*pScene);
+	REQUIRE(!cooked.meshes.empty());
+	REQUIRE(ModelCache::Write(scratch.Model(), importFlags, scale, importer, cooked.materials, cooked.meshes));
+
+	ModelCache cache;
+	REQUIRE(cache.Open(scratch.Model(), importFlags, scale));
+
+	// the nodes come back in the scene's preorder
+	size_t next = 0u;
+	REQUIRE(cache.GetNodeCount() > 0u);
+	CheckNodes(cache, *pScene->mRootNode, next);
+	CHECK(next == cache.GetNodeCount());
+
+	REQUIRE(cache.GetMaterialCount() == cooked.materials.size());
+	for (size_t i = 0; i < cooked.materials.size(); i++)
+	{
+		const auto material = cache.GetMaterial(i);
+		CHECK(material.name == cooked.materials[i].name);
+		CHECK(material.diffuseMap == cooked.materials[i].diffuseMap);
+		CHECK(material.specularMap.empty() && material.normalMap.empty());
+		CHECK(material.shininess == cooked.materials[i].shininess);
+	}
+
+	REQUIRE(cache.GetMeshCount() == cooked.meshes.size());
+	for (size_t i = 0; i < cooked.meshes.size(); i++)
+	{
+		const auto view = cache.GetMesh(i);
+		const auto expected = cooked.meshes[i].View();
+		CHECK(view.name == expected.name);
+		CHECK(view.material == expected.material);
+		CHECK(view.stride == expected.stride);
+		CHECK(view.quantization.extent == expected.quantization.extent);
+		// read in place, so the arrays have to be aligned for the types in them
+		CHECK(reinterpret_cast<uintptr_t>(view.pVertices) % 16u == 0u);
+		REQUIRE(view.vertexCount == expected.vertexCount);
+		CHECK(std::memcmp(view.pVertices, expected.pVertices, view.vertexCount * view.stride) == 0);
+		REQUIRE(view.lodCount == expected.lodCount);
+		for (size_t lod = 0; lod < view.lodCount; lod++)
+		{
+			REQUIRE(view.lods[lod].count == expected.lods[lod].count);
+			CHECK(reinterpret_cast<uintptr_t>(view.lods[lod].pIndices) % 16u == 0u);
+			CHECK(std::memcmp(view.lods[lod].pIndices, expected.lods[lod].pIndices, view.lods[lod].count * sizeof(uint32_t)) == 0);
+		}
+	}
+}
+
+TEST(ModelCacheRejectsStaleKey)
+{
+	const Scratch scratch;
+	REQUIRE(ImportAndWrite(scratch));
+	REQUIRE(Opens(scratch));
+	{
+		ModelCache cache;
+		CHECK(!cache.Open(scratch.Model(), importFlags & ~unsigned(aiProcess_CalcTangentSpace), scale));
+		CHECK(!cache.Open(scratch.Model(), importFlags, scale * 2.0f));
+	}
+	// the material library is a dependency as much as the model is
+	std::ofstream{ scratch.Library(),std::ios::app } << "Ks 1 1 1\n";
+	CHECK(!Opens(scratch));
+	REQUIRE(ImportAndWrite(scratch));
+	CHECK(Opens(scratch));
+	std::filesystem::remove(scratch.Library());
+	CHECK(!Opens(scratch));
+}
+
+TEST(ModelCacheRejectsTruncated)
+{
+	const Scratch scratch;
+	REQUIRE(ImportAndWrite(scratch));
+	const auto bytes = ReadBytes(scratch.Cache());
+	REQUIRE(bytes.size() > 64u);
+	for (const auto cut : { size_t(4u),bytes.size() / 2u,bytes.size() - 16u,bytes.size() - 1u })
+	{
+		WriteBytes(scratch.Cache(), { bytes.begin(),bytes.end() - cut });
+		if (Opens(scratch))
+		{
+			Test::Fail(__FILE__, __LINE__, "cache opens with its last " + std::to_string(cut) + " bytes cut off");
+		}
+	}
+	WriteBytes(scratch.Cache(), {});
+	CHECK(!Opens(scratch));
+	// rewriting the bytes as they were has to bring it back, or the rejections above prove nothing
+	WriteBytes(scratch.Cache(), bytes);
+	CHECK(Opens(scratch));
+}
+
+TEST(ModelCacheRejectsBadOffsets)
+{
+	const Scratch scratch;
+	REQUIRE(ImportAndWrite(scratch));
+	const auto bytes = ReadBytes(scratch.Cache());
+	REQUIRE(bytes.size() > 128u);
+	const auto nodes = Peek<uint64_t>(bytes, headerNodesOffset);
+	const auto nodeCount = Peek<uint32_t>(bytes, headerNodeCountOffset);
+	for (const uint64_t offset : { uint64_t(bytes.size()),uint64_t(bytes.size()) + 64u,nodes + 2u,~uint64_t(0u) - 7u })
+	{
+		auto patched = bytes;
+		Patch(patched, headerNodesOffset, offset);
+		WriteBytes(scratch.Cache(), patched);
+		if (Opens(scratch))
+		{
+			Test::Fail(__FILE__, __LINE__, "cache opens with its nodes at " + std::to_string(offset));
+		}
+	}
+	// in range, but more nodes than the file holds
+	auto patched = bytes;
+	Patch(patched, headerNodeCountOffset, uint32_t(nodeCount + bytes.size()));
+	WriteBytes(scratch.Cache(), patched);
+	CHECK(!Opens(scratch));
+	WriteBytes(scratch.Cache(), bytes);
+	CHECK(Opens(scratch));
+}
+
+TEST(ModelCacheRejectsOutOfRangeIndices)
+{
+	const Scratch scratch;
+	REQUIRE(ImportAndWrite(scratch, [](Cooked& cooked)
+	{
+		auto& mesh = cooked.meshes.front();
+		mesh.lods.back().back() = uint32_t(mesh.vertices.size() / mesh.stride);
+	}));
+	CHECK(!Opens(scratch));
+	REQUIRE(ImportAndWrite(scratch, [](Cooked& cooked)
+	{
+		cooked.meshes.front().material = uint32_t(cooked.materials.size());
+	}));
+	CHECK(!Opens(scratch));
+	REQUIRE(ImportAndWrite(scratch, [](Cooked& cooked)
+	{
+		cooked.meshes.front().quantization.extent = 0.0f;
+	}));
+	CHECK(!Opens(scratch));
+	REQUIRE(ImportAndWrite(scratch));
+	CHECK(Opens(scratch));
+}
+
+TEST(ModelCacheRejectsBadNodePreorder)
+{
+	const Scratch scratch;
+	REQUIRE(ImportAndWrite(scratch));
+	const auto bytes = ReadBytes(scratch.Cache());
+	const auto nodes = size_t(Peek<uint64_t>(bytes, headerNodesOffset));
+	REQUIRE(nodes + nodeChildCountOffset + sizeof(uint32_t) <= bytes.size());
+	const auto rootChildren = Peek<uint32_t>(bytes, nodes + nodeChildCountOffset);
+	// one child more than there are nodes after the root, and, if it has any, one fewer, which
+	// ends the walk with nodes left over
+	auto patched = bytes;
+	Patch(patched, nodes + nodeChildCountOffset, rootChildren + 1u);
+	WriteBytes(scratch.Cache(), patched);
+	CHECK(!Opens(scratch));
+	if (rootChildren > 0u)
+	{
+		patched = bytes;
+		Patch(patched, nodes + nodeChildCountOffset, rootChildren - 1u);
+		WriteBytes(scratch.Cache(), patched);
+		CHECK(!Opens(scratch));
+	}
+	WriteBytes(scratch.Cache(), bytes);
+	CHECK(Opens(scratch));
+}
@@ -0,0 +1,150 @@
+#include "Test.h"
+#include "Device.h"
+#include <Engine/Architecture/Codex.h>
+#include <Engine/Architecture/Material.h>
+#include <Engine/Entities/MeshOptimizer.h>
+#include <Engine/Entities/MeshSimplifier.h>
+#include <Engine/Entities/Model.h>
+#include <Framework/ParallelFor.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dx = DirectX;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// the per mesh and per material work Model::Model fans out, timed at every thread count;
+	// best of a few runs, each run does every index once
+	template<typename F>
+	void Sweep(const std::string& what, size_t count, F&& stage)
+	{
+		for (const unsigned threads : { 1u,2u,4u,8u,16u })
+		{
+			std::chrono::duration<double> fastest{ 1e30 };
+			for (int r = 0; r < 3; r++)
+			{
+				const auto begin = Clock::now();
+				ParallelFor(count, stage, threads);
+				fastest = std::min<std::chrono::duration<double>>(fastest, Clock::now() - begin);
+			}
+			Test::Report(what + ", " + std::to_string(threads) + (threads == 1u ? " thread" : " threads"), fastest.count() * 1e3, "ms");
+		}
+	}
+
+	// the device-free stages of a load: describing the materials, converting vertices, optimizing
+	// and simplifying; texture decode and buffer creation need the device and aren't in here
+	void SweepStages(const std::string& name, const std::filesystem::path& path)
+	{
+		Assimp::Importer importer;
+		const auto pScene = importer.ReadFile(path.string(),
+			aiProcess_Triangulate |
+			aiProcess_JoinIdenticalVertices |
+			aiProcess_ConvertToLeftHanded |
+			aiProcess_GenNormals |
+			aiProcess_CalcTangentSpace
+		);
+		REQUIRE(pScene != nullptr);
+		const size_t meshCount = pScene->mNumMeshes;
+
+		std::vector<Material::Description> descriptions(pScene->mNumMaterials);
+		Sweep(name + " Material::Describe", descriptions.size(), [&](size_t i)
+		{
+			descriptions[i] = Material::Describe(*pScene->mMaterials[i]);
+		});
+
+		// what Material::ExtractVertices and ExtractIndices make of every mesh
+		std::vector<std::unique_ptr<DV::VertexBuffer>> vertices(meshCount);
+		std::vector<std::vector<uint32_t>> indices(meshCount);
+		Sweep(name + " ExtractVertices", meshCount, [&](size_t i)
+		{
+			const auto& mesh = *pScene->mMeshes[i];
+			vertices[i] = std::make_unique<DV::VertexBuffer>(Material::MakeVertexLayout(descriptions[mesh.mMaterialIndex]), mesh);
+			indices[i].clear();
+			for (unsigned int f = 0; f < mesh.mNumFaces; f++)
+			{
+				const auto& face = mesh.mFaces[f];
+				if (face.mNumIndices == 3u)
+				{
+					indices[i].insert(indices[i].end(), face.mIndices, face.mIndices + 3u);
+				}
+			}
+		});
+
+		// on copies, so every run starts from the imported order; the copy is part of the time
+		Sweep(name + " MeshOptimizer::Optimize", meshCount, [&](size_t i)
+		{
+			auto optimizedVertices = *vertices[i];
+			auto optimizedIndices = indices[i];
+			MeshOptimizer::Optimize(optimizedVertices, optimizedIndices);
+		});
+
+		// the first lod level Mesh::BuildLods asks for: half the triangles within a pixel at a quarter screen
+		std::vector<std::vector<dx::XMFLOAT3>> positions(meshCount);
+		std::vector<float> maxErrors(meshCount);
+		for (size_t i = 0; i < meshCount; i++)
+		{
+			const auto& mesh = *pScene->mMeshes[i];
+			dx::XMFLOAT3 lo = { FLT_MAX,FLT_MAX,FLT_MAX };
+			dx::XMFLOAT3 hi = { -FLT_MAX,-FLT_MAX,-FLT_MAX };
+			for (unsigned int v = 0; v < mesh.mNumVertices; v++)
+			{
+				const auto& p = mesh.mVertices[v];
+				positions[i].push_back({ p.x,p.y,p.z });
+				lo = { std::min(lo.x, p.x),std::min(lo.y, p.y),std::min(lo.z, p.z) };
+				hi = { std::max(hi.x, p.x),std::max(hi.y, p.y),std::max(hi.z, p.z) };
+			}
+			const dx::XMFLOAT3 size = { hi.x - lo.x,hi.y - lo.y,hi.z - lo.z };
+			maxErrors[i] = 0.5f * std::sqrt(size.x * size.x + size.y * size.y + size.z * size.z) / (0.25f * 360.0f);
+		}
+		Sweep(name + " MeshSimplifier::Simplify", meshCount, [&](size_t i)
+		{
+			MeshSimplifier::Simplify(positions[i], indices[i], indices[i].size() / 6u * 3u, maxErrors[i]);
+		});
+	}
+}
+
+// scaling of the load stages Model::Model runs through ParallelFor, from 1 to 16 threads
+BENCHMARK(ModelLoadStageScaling)
+{
+	SweepStages("GoblinX", Test::AppRoot() / "Models" / "gobber" / "GoblinX.obj");
+	SweepStages("nanosuit", Test::AppRoot() / "Models" / "nano_textured" / "nanosuit.obj");
+}
+
+// a second instance of a model that is still loaded finds its materials' bindables and its
+// meshes' buffers in the codex: no vertex conversion, index extraction or lod building, only
+// the import or cache open and the node tree are left
+BENCHMARK(ModelSecondInstanceLoad)
+{
+	const auto pGfx = Test::Device();
+	REQUIRE(pGfx != nullptr);
+	const auto load = [&](const std::string& name, const char* path)
+	{
+		const auto timed = [&](const std::string& what)
+		{
+			const auto before = Codex::GetStats();
+			const auto begin = Clock::now();
+			auto pModel = std::make_unique<Model>(*pGfx, path);
+			const std::chrono::duration<double> elapsed = Clock::now() - begin;
+			const auto after = Codex::GetStats();
+			Test::Report(name + ", " + what, elapsed.count() * 1e3, "ms");
+			Test::Report(name + ", " + what + " codex misses", double(after.misses - before.misses), "");
+			return pModel;
+		};
+		// both stay loaded until the end; the first may still be warm from an earlier run through
+		// the cooked cache
+		const auto pFirst = timed("first instance");
+		const auto pSecond = timed("second instance");
+	};
+	load("GoblinX", "Models\\gobber\\GoblinX.obj");
+	load("nanosuit", "Models\\nano_textured\\nanosuit.obj");
+}
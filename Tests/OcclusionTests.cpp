@@ -0,0 +1,250 @@
+#include "Test.h"
+#include <Engine/OcclusionBuffer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace dx = DirectX;
+
+namespace
+{
+	// single channel float image, stored as PFM so the goldens open in any HDR viewer
+	struct Image
+	{
+		uint32_t width = 0u;
+		uint32_t height = 0u;
+		std::vector<float> texels;
+	};
+
+	bool ReadPfm(const std::filesystem::path& path, Image& image)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::string magic;
+		float scale = 0.0f;
+		if (!(file >> magic >> image.width >> image.height >> scale) || magic != "Pf" || scale >= 0.0f)
+		{
+			return false;
+		}
+		file.get();
+		image.texels.resize(size_t(image.width) * image.height);
+		// rows are stored bottom to top
+		for (uint32_t y = image.height; y-- > 0u; )
+		{
+			file.read(reinterpret_cast<char*>(&image.texels[size_t(y) * image.width]), std::streamsize(image.width * sizeof(float)));
+		}
+		return bool(file);
+	}
+
+	void WritePfm(const std::filesystem::path& path, const Image& image)
+	{
+		std::filesystem::create_directories(path.parent_path());
+		std::ofstream file(path, std::ios::binary);
+		// negative scale marks little endian
+		file << "Pf\n" << image.width << ' ' << image.height << "\n-1.0\n";
+		for (uint32_t y = image.height; y-- > 0u; )
+		{
+			file.write(reinterpret_cast<const char*>(&image.texels[size_t(y) * image.width]), std::streamsize(image.width * sizeof(float)));
+		}
+	}
+
+	Image DepthImage(const OcclusionBuffer& ob)
+	{
+		Image image{ ob.GetLevelWidth(0u),ob.GetLevelHeight(0u) };
+		const auto p = ob.GetMaxDepth(0u);
+		image.texels.assign(p, p + size_t(image.width) * image.height);
+		return image;
+	}
+
+	// levels 1 and up stacked top to bottom, min on the left half and max on the right
+	Image PyramidImage(const OcclusionBuffer& ob)
+	{
+		Image image{ 2u * ob.GetLevelWidth(1u),0u };
+		for (size_t level = 1u; level < ob.GetLevelCount(); level++)
+		{
+			image.height += ob.GetLevelHeight(level);
+		}
+		image.texels.assign(size_t(image.width) * image.height, 0.0f);
+		uint32_t top = 0u;
+		for (size_t level = 1u; level < ob.GetLevelCount(); level++)
+		{
+			const auto w = ob.GetLevelWidth(level);
+			const auto h = ob.GetLevelHeight(level);
+			for (uint32_t y = 0; y < h; y++)
+			{
+				auto pRow = &image.texels[size_t(top + y) * image.width];
+				std::copy_n(ob.GetMinDepth(level) + size_t(y) * w, w, pRow);
+				std::copy_n(ob.GetMaxDepth(level) + size_t(y) * w, w, pRow + image.width / 2u);
+			}
+			top += h;
+		}
+		return image;
+	}
+
+	// a missing golden is written out and fails the test, so new ones get looked at before they
+	// are committed; a mismatch writes the actual image next to the golden for comparing
+	void CheckGolden(const Image& actual, const std::string& name)
+	{
+		const auto path = Test::Root() / "Data" / "Occlusion" / (name + ".pfm");
+		Image golden;
+		if (!ReadPfm(path, golden))
+		{
+			WritePfm(path, actual);
+			Test::Fail(__FILE__, __LINE__, "golden " + path.string() + " was missing and has been written");
+			return;
+		}
+		if (golden.width != actual.width || golden.height != actual.height)
+		{
+			Test::Fail(__FILE__, __LINE__, "golden " + name + " has different dimensions");
+			return;
+		}
+		// DirectXMath's SSE and scalar paths may round a few ulps apart, which can flip the odd
+		// pixel whose center sits exactly on an edge
+		constexpr float depthTolerance = 1e-5f;
+		constexpr size_t flippedTexelBudget = 16u;
+		size_t mismatches = 0u;
+		for (size_t i = 0; i < golden.texels.size(); i++)
+		{
+			mismatches += !(std::abs(golden.texels[i] - actual.texels[i]) <= depthTolerance);
+		}
+		if (mismatches > flippedTexelBudget)
+		{
+			WritePfm(std::filesystem::path{ path }.replace_extension(".actual.pfm"), actual);
+			Test::Fail(__FILE__, __LINE__, name + ": " + std::to_string(mismatches) + " texels differ from the golden");
+		}
+	}
+
+	// camera at the origin looking down +z, as in the engine the screen is y-down and occluders
+	// wind clockwise as seen from the camera
+	dx::XMMATRIX Projection()
+	{
+		return dx::XMMatrixPerspectiveLH(1.0f, 0.6f, 0.5f, 100.0f);
+	}
+
+	// post-projection depth of view space z
+	float DepthAt(float z)
+	{
+		return (100.0f / 99.5f) * (1.0f - 0.5f / z);
+	}
+
+	struct Quad
+	{
+		// top left, top right, bottom right, bottom left as seen from the camera
+		std::vector<dx::XMFLOAT3> positions;
+		std::vector<uint32_t> indices = { 0u,1u,2u, 0u,2u,3u };
+	};
+
+	Quad Rect(float left, float top, float right, float bottom, float z)
+	{
+		return { { { left,top,z },{ right,top,z },{ right,bottom,z },{ left,bottom,z } } };
+	}
+
+	// occluder geometry only has to outlive Resolve, so the scenes can keep it on the stack
+	void Render(OcclusionBuffer& ob, const std::vector<std::pair<dx::XMMATRIX, const Quad*>>& occluders)
+	{
+		ob.Begin(Projection());
+		for (const auto& [world, pQuad] : occluders)
+		{
+			ob.AddOccluder(world, pQuad->positions, pQuad->indices);
+		}
+		ob.Rasterize();
+		ob.Resolve();
+	}
+
+	void CheckScene(const OcclusionBuffer& ob, const std::string& scene)
+	{
+		CheckGolden(DepthImage(ob), scene + "_depth");
+		CheckGolden(PyramidImage(ob), scene + "_pyramid");
+	}
+}
+
+TEST(OcclusionGoldenWall)
+{
+	// x, y within +-5 at z = 10 covers pixels [80,240) x [16,176), crossing tile borders on both axes
+	const auto wall = Rect(-5.0f, 5.0f, 5.0f, -5.0f, 10.0f);
+	OcclusionBuffer ob;
+	Render(ob, { { dx::XMMatrixIdentity(),&wall } });
+	CHECK(ob.GetStats().rasterized == 2u);
+	const auto pDepth = ob.GetMaxDepth(0u);
+	CHECK(std::abs(pDepth[96u * OcclusionBuffer::width + 160u] - DepthAt(10.0f)) < 1e-5f);
+	CHECK(pDepth[0] == 1.0f);
+	CHECK(std::count_if(pDepth, pDepth + OcclusionBuffer::width * OcclusionBuffer::height,
+		[](float d) { return d < 1.0f; }) == 160 * 160);
+	CHECK(ob.IsOccluded({ { 0.0f,0.0f,20.0f },{ 1.0f,1.0f,1.0f } }));
+	CHECK(!ob.IsOccluded({ { 0.0f,0.0f,10.0f },{ 1.0f,1.0f,1.0f } }));
+	// half of it pokes out past the wall's silhouette
+	CHECK(!ob.IsOccluded({ { 9.5f,0.0f,20.0f },{ 1.0f,1.0f,1.0f } }));
+	CheckScene(ob, "wall");
+}
+
+TEST(OcclusionGoldenEdgeTiles)
+{
+	// hangs off the right and bottom of the screen, partial tiles on the border
+	const auto offscreen = Rect(2.0f, -1.0f, 14.0f, -9.0f, 10.0f);
+	// hangs off the top left corner, placed through its world matrix
+	const auto corner = Rect(-2.0f, 2.0f, 2.0f, -2.0f, 0.0f);
+	// a sliver of a few pixels around the corner shared by four tiles at (32, 32)
+	const auto sliver = Rect(-8.3f, 4.3f, -7.7f, 3.7f, 10.0f);
+	OcclusionBuffer ob;
+	Render(ob, {
+		{ dx::XMMatrixIdentity(),&offscreen },
+		{ dx::XMMatrixTranslation(-12.0f, 7.0f, 12.0f),&corner },
+		{ dx::XMMatrixIdentity(),&sliver },
+	});
+	CHECK(ob.GetStats().rasterized == 6u);
+	const auto pDepth = ob.GetMaxDepth(0u);
+	constexpr auto w = OcclusionBuffer::width;
+	constexpr auto h = OcclusionBuffer::height;
+	CHECK(pDepth[(h - 1u) * w + (w - 1u)] < 1.0f);
+	CHECK(pDepth[0] < 1.0f);
+	for (const uint32_t y : { 31u,32u })
+	{
+		for (const uint32_t x : { 31u,32u })
+		{
+			CHECK(std::abs(pDepth[y * w + x] - DepthAt(10.0f)) < 1e-5f);
+		}
+	}
+	CheckScene(ob, "edge_tiles");
+}
+
+TEST(OcclusionGoldenNearPlaneClipping)
+{
+	// runs from behind the camera out to z = 30, only the part past the near plane is drawn
+	Quad slope{ { { -5.0f,5.0f,-5.0f },{ 5.0f,5.0f,30.0f },{ 5.0f,-5.0f,30.0f },{ -5.0f,-5.0f,-5.0f } } };
+	// entirely behind the camera, nothing of it may show up
+	const auto behind = Rect(-50.0f, 50.0f, 50.0f, -50.0f, -2.0f);
+	// straddles the near plane edge on, cut in two along z
+	Quad floor{ { { -3.0f,-0.3f,0.8f },{ 3.0f,-0.3f,0.8f },{ 3.0f,-0.3f,0.2f },{ -3.0f,-0.3f,0.2f } } };
+	OcclusionBuffer ob;
+	Render(ob, {
+		{ dx::XMMatrixIdentity(),&slope },
+		{ dx::XMMatrixIdentity(),&behind },
+		{ dx::XMMatrixIdentity(),&floor },
+	});
+	const auto pDepth = ob.GetMaxDepth(0u);
+	const auto count = size_t(OcclusionBuffer::width) * OcclusionBuffer::height;
+	CHECK(std::all_of(pDepth, pDepth + count, [](float d) { return d >= 0.0f && d <= 1.0f; }));
+	// the floor's far half runs along the bottom of the screen
+	CHECK(pDepth[count - 1u] < 1.0f);
+	CheckScene(ob, "near_clip");
+}
+
+TEST(OcclusionGoldenOverlapAndBackfaces)
+{
+	const auto distant = Rect(-4.0f, 12.0f, 16.0f, -2.0f, 20.0f);
+	const auto close = Rect(-3.0f, 3.0f, 3.0f, -3.0f, 8.0f);
+	// wound the wrong way round, culled
+	Quad back = Rect(-9.0f, 6.0f, -1.0f, -2.0f, 5.0f);
+	back.indices = { 0u,2u,1u, 0u,3u,2u };
+	OcclusionBuffer ob;
+	// far one last, the nearer depth has to win regardless of order
+	Render(ob, {
+		{ dx::XMMatrixIdentity(),&close },
+		{ dx::XMMatrixIdentity(),&back },
+		{ dx::XMMatrixIdentity(),&distant },
+	});
+	CHECK(ob.GetStats().rasterized == 4u);
+	CHECK(std::abs(ob.GetMaxDepth(0u)[96u * OcclusionBuffer::width + 160u] - DepthAt(8.0f)) < 1e-5f);
+	CheckScene(ob, "overlap");
+}
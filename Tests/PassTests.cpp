@@ -0,0 +1,159 @@
+#include "Test.h"
+#include <Engine/Architecture/Drawable.h>
+#include <Engine/Architecture/Job.h>
+#include <Engine/Architecture/Pass.h>
+#include <Engine/Architecture/Step.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+	// state sorting never reads gfx, and nothing here gets recorded
+	Graphics& NoDevice() noexcept
+	{
+		alignas(Graphics) static unsigned char storage[sizeof(Graphics)];
+		return *reinterpret_cast<Graphics*>(storage);
+	}
+
+	// shared state with no device object; steps only hash its identity into their key
+	class StateStub : public Bindable
+	{
+	public:
+		void Bind(Graphics&, CommandStream&) noexcept override
+		{}
+	};
+
+	// a mesh as jobs see it: its vertex buffer's identity, the buffer itself is never touched
+	class MeshStub : public Drawable
+	{
+	public:
+		MeshStub(uintptr_t vertexBuffer)
+		{
+			pVertices = std::shared_ptr<VertexBuffer>(std::shared_ptr<VertexBuffer>{}, reinterpret_cast<VertexBuffer*>(vertexBuffer));
+		}
+	};
+
+	uint64_t Field(uint64_t key, unsigned shift) noexcept
+	{
+		return key >> shift & 0xFFFull;
+	}
+
+	// materialCount steps sharing a sampler-like stub and each holding one of its own, meshCount
+	// meshes each drawn with material mesh % materialCount, every mesh placed instanceCount
+	// times and the jobs submitted in a fixed shuffled order like a node walk would. steps and
+	// vertex buffers are picked so no two share a field of the state key, which makes the
+	// change counts exact
+	class Scene
+	{
+	public:
+		Scene(size_t materialCount, size_t meshCount, size_t instanceCount)
+		{
+			using SK = Job::StateKey;
+			const auto pShared = std::make_shared<StateStub>();
+			std::unordered_set<uint64_t> miscFields;
+			while (steps.size() < materialCount)
+			{
+				auto pStep = std::make_unique<Step>("lambertian");
+				pStep->AddBindable(pShared);
+				pStep->AddBindable(std::make_shared<StateStub>());
+				if (miscFields.insert(Field(pStep->GetStateKey(), SK::miscShift)).second)
+				{
+					steps.push_back(std::move(pStep));
+				}
+			}
+			std::unordered_set<uint64_t> vbFields;
+			for (uintptr_t identity = 0x10000u; meshes.size() < meshCount; identity += 64u)
+			{
+				if (vbFields.insert(SK::Reduce(identity, 12u)).second)
+				{
+					meshes.push_back(std::make_unique<MeshStub>(identity));
+				}
+			}
+			for (size_t mesh = 0; mesh < meshCount; mesh++)
+			{
+				for (size_t i = 0; i < instanceCount; i++)
+				{
+					order.push_back(mesh);
+				}
+			}
+			std::mt19937 rng{ 11u };
+			std::shuffle(order.begin(), order.end(), rng);
+		}
+		void Submit(Pass& pass) const
+		{
+			for (const auto mesh : order)
+			{
+				pass.Accept(Job{ steps[mesh % steps.size()].get(),meshes[mesh].get(),DirectX::XMMatrixIdentity() });
+			}
+		}
+		// a material change switches the other state field, a mesh change the vertex buffer field
+		size_t SubmittedChanges() const noexcept
+		{
+			size_t changes = 0u;
+			for (size_t i = 1; i < order.size(); i++)
+			{
+				changes += order[i] % steps.size() != order[i - 1] % steps.size();
+				changes += order[i] != order[i - 1];
+			}
+			return changes;
+		}
+		// grouped by material, then by mesh within each
+		size_t SortedChanges() const noexcept
+		{
+			return (steps.size() - 1u) + (meshes.size() - 1u);
+		}
+	private:
+		std::vector<std::unique_ptr<Step>> steps;
+		std::vector<std::unique_ptr<MeshStub>> meshes;
+		std::vector<size_t> order;
+	};
+}
+
+TEST(PassStateSortingCutsStateChanges)
+{
+	const Scene scene{ 8u,32u,4u };
+
+	Pass sorted{ Pass::Sorting::State };
+	scene.Submit(sorted);
+	sorted.Order(NoDevice());
+	CHECK(sorted.GetStats().jobs == 128u);
+	CHECK(sorted.GetStats().stateChangesSubmitted == scene.SubmittedChanges());
+	CHECK(sorted.GetStats().stateChangesExecuted == scene.SortedChanges());
+
+	// without a sorting policy the jobs execute as submitted
+	Pass unsorted;
+	scene.Submit(unsorted);
+	unsorted.Order(NoDevice());
+	CHECK(unsorted.GetStats().stateChangesSubmitted == scene.SubmittedChanges());
+	CHECK(unsorted.GetStats().stateChangesExecuted == scene.SubmittedChanges());
+}
+
+BENCHMARK(PassStateSorting)
+{
+	using Clock = std::chrono::steady_clock;
+	constexpr int frames = 100;
+	for (const size_t materialCount : { 8u,64u })
+	{
+		const Scene scene{ materialCount,2048u,8u };
+		Pass pass{ Pass::Sorting::State };
+		std::chrono::duration<double> elapsed{ 0.0 };
+		for (int f = 0; f < frames; f++)
+		{
+			pass.Reset();
+			scene.Submit(pass);
+			const auto begin = Clock::now();
+			pass.Order(NoDevice());
+			elapsed += Clock::now() - begin;
+		}
+		const auto& stats = pass.GetStats();
+		const auto label = std::to_string(stats.jobs) + " jobs, " + std::to_string(materialCount) + " materials, ";
+		Test::Report(label + "state changes submitted", double(stats.stateChangesSubmitted), "");
+		Test::Report(label + "state changes sorted", double(stats.stateChangesExecuted), "");
+		Test::Report(label + "sort", elapsed.count() / frames * 1e6, "us");
+	}
+}
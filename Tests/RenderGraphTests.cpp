@@ -0,0 +1,121 @@
+#include "Test.h"
+#include <Engine/Architecture/RenderGraph.h>
+#include <stdexcept>
+
+namespace
+{
+	using PassNames = std::vector<std::string>;
+
+	// the passes FrameCommander registers
+	RenderGraph MakeFrameGraph()
+	{
+		RenderGraph graph;
+		graph.AddPass("phong", {}, { "color","depth" });
+		graph.AddPass("outlineMask", {}, { "stencil" });
+		graph.AddPass("outlineDraw", { "stencil" }, { "color" });
+		graph.AddOutput("color");
+		graph.Compile();
+		return graph;
+	}
+
+	PassNames Names(const RenderGraph& graph, const std::vector<size_t>& passes)
+	{
+		PassNames names;
+		for (const auto i : passes)
+		{
+			names.push_back(graph.GetPassName(i));
+		}
+		return names;
+	}
+}
+
+TEST(RenderGraphFrameOrder)
+{
+	auto graph = MakeFrameGraph();
+	CHECK(Names(graph, graph.GetOrder()) == (PassNames{ "phong","outlineMask","outlineDraw" }));
+	CHECK(Names(graph, graph.Schedule({ true,true,true })) == (PassNames{ "phong","outlineMask","outlineDraw" }));
+}
+
+TEST(RenderGraphOrdersReadersAfterWriters)
+{
+	// registered consumer first, the producer still has to run before it
+	RenderGraph graph;
+	graph.AddPass("composite", { "lit","shadow" }, { "color" });
+	graph.AddPass("lighting", { "shadow" }, { "lit" });
+	graph.AddPass("shadow", {}, { "shadow" });
+	graph.AddOutput("color");
+	graph.Compile();
+	CHECK(Names(graph, graph.GetOrder()) == (PassNames{ "shadow","lighting","composite" }));
+}
+
+TEST(RenderGraphKeepsRegistrationOrderOfWriters)
+{
+	// independent passes writing the same target keep the order they were added in
+	RenderGraph graph;
+	graph.AddPass("opaque", {}, { "color" });
+	graph.AddPass("sky", {}, { "color" });
+	graph.AddPass("transparent", {}, { "color" });
+	graph.AddOutput("color");
+	graph.Compile();
+	CHECK(Names(graph, graph.GetOrder()) == (PassNames{ "opaque","sky","transparent" }));
+}
+
+TEST(RenderGraphRejectsCycles)
+{
+	RenderGraph graph;
+	graph.AddPass("a", { "x" }, { "y" });
+	graph.AddPass("b", { "y" }, { "x" });
+	graph.AddOutput("y");
+	bool threw = false;
+	try
+	{
+		graph.Compile();
+	}
+	catch (const std::logic_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+TEST(RenderGraphRejectsDuplicatePasses)
+{
+	RenderGraph graph;
+	graph.AddPass("phong", {}, { "color" });
+	graph.AddPass("phong", {}, { "color" });
+	bool threw = false;
+	try
+	{
+		graph.Compile();
+	}
+	catch (const std::logic_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+TEST(RenderGraphCullsOutlineWithoutOutlineTechnique)
+{
+	auto graph = MakeFrameGraph();
+	// nothing submitted an outline technique, neither outline pass has jobs
+	CHECK(Names(graph, graph.Schedule({ true,false,false })) == (PassNames{ "phong" }));
+}
+
+TEST(RenderGraphCullsUnconsumedMask)
+{
+	auto graph = MakeFrameGraph();
+	// a mask nobody draws with writes only stencil, which nothing reads
+	CHECK(Names(graph, graph.Schedule({ true,true,false })) == (PassNames{ "phong" }));
+	// drawing without a mask this frame still runs, it only writes color
+	CHECK(Names(graph, graph.Schedule({ true,false,true })) == (PassNames{ "phong","outlineDraw" }));
+	CHECK(Names(graph, graph.Schedule({ false,true,true })) == (PassNames{ "outlineMask","outlineDraw" }));
+}
+
+TEST(RenderGraphFindsPassesById)
+{
+	auto graph = MakeFrameGraph();
+	CHECK(graph.Find(RenderGraph::MakePassId("outlineMask")) == 1u);
+	CHECK(graph.Find(RenderGraph::MakePassId("missing")) == RenderGraph::npos);
+	CHECK(graph.GetPassCount() == 3u);
+}
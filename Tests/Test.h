@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// a minimal harness: TEST registers a function that runs in the test executable, CHECK records
+// a failure and carries on, REQUIRE records it and leaves the test. BENCHMARK functions only run
+// when the executable is started with --bench
+namespace Test
+{
+	struct Case
+	{
+		const char* name;
+		void (*pRun)();
+		bool benchmark;
+	};
+	std::vector<Case>& Registry();
+	struct Registrar
+	{
+		Registrar(const char* name, void (*pRun)(), bool benchmark)
+		{
+			Registry().push_back({ name,pRun,benchmark });
+		}
+	};
+	void Fail(const char* file, int line, std::string_view what);
+	// benchmark output, one line per measurement
+	void Report(std::string_view what, double value, std::string_view unit);
+	// the Tests directory, where the golden data lives
+	const std::filesystem::path& Root();
+	// the WinD3D project directory, for the models and shaders the app ships with
+	std::filesystem::path AppRoot();
+
+	// runs work(thread) on count threads released at once
+	template<typename F>
+	void Hammer(unsigned count, F&& work)
+	{
+		std::atomic<bool> go = false;
+		std::vector<std::thread> threads;
+		for (unsigned t = 0; t < count; t++)
+		{
+			threads.emplace_back([&go, &work, t]
+			{
+				while (!go)
+				{
+					std::this_thread::yield();
+				}
+				work(t);
+			});
+		}
+		go = true;
+		for (auto& t : threads)
+		{
+			t.join();
+		}
+	}
+}
+
+#define TEST_CASE_(name, benchmark) \
+	static void name(); \
+	static const Test::Registrar name##Registrar{ #name,&name,benchmark }; \
+	static void name()
+#define TEST(name) TEST_CASE_(name, false)
+#define BENCHMARK(name) TEST_CASE_(name, true)
+
+#define CHECK(expr) ((expr) ? void() : Test::Fail(__FILE__, __LINE__, #expr))
+#define REQUIRE(expr) do { if (!(expr)) { Test::Fail(__FILE__, __LINE__, #expr); return; } } while (false)
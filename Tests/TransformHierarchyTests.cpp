@@ -0,0 +1,221 @@
+#include "Test.h"
+#include <Engine/Entities/TransformHierarchy.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace dx = DirectX;
+
+namespace
+{
+	// what Node::Submit walked before the hierarchy was flattened: a pointer tree recomputing
+	// applied * local * accumulated for every node every frame
+	struct TreeNode
+	{
+		dx::XMFLOAT4X4 local;
+		dx::XMFLOAT4X4 applied;
+		std::vector<std::unique_ptr<TreeNode>> children;
+		uint32_t id;
+	};
+
+	void Accumulate(const TreeNode& node, dx::FXMMATRIX accumulated, std::vector<dx::XMFLOAT4X4>& world)
+	{
+		const auto built =
+			dx::XMLoadFloat4x4(&node.applied) *
+			dx::XMLoadFloat4x4(&node.local) *
+			accumulated;
+		dx::XMStoreFloat4x4(&world[node.id], built);
+		for (const auto& pc : node.children)
+		{
+			Accumulate(*pc, built, world);
+		}
+	}
+
+	// every node hangs under a random earlier one, which gives the shallow, bushy trees scenes import as
+	class SyntheticModel
+	{
+	public:
+		SyntheticModel(size_t nodeCount, unsigned seed)
+			:
+			rng(seed)
+		{
+			pRoot = MakeNode();
+			std::vector<TreeNode*> open{ pRoot.get() };
+			std::uniform_int_distribution<size_t> pick;
+			while (nodes.size() < nodeCount)
+			{
+				auto& parent = *open[pick(rng) % open.size()];
+				parent.children.push_back(MakeNode());
+				open.push_back(parent.children.back().get());
+			}
+			// ids in the preorder the hierarchy wants, the same order Model's node ids come in
+			uint32_t next = 0u;
+			Flatten(*pRoot, TransformHierarchy::noParent, next);
+		}
+		const TreeNode& Root() const noexcept
+		{
+			return *pRoot;
+		}
+		TreeNode& Get(uint32_t id) noexcept
+		{
+			return *nodes[id];
+		}
+		size_t GetCount() const noexcept
+		{
+			return nodes.size();
+		}
+		TransformHierarchy& Hierarchy() noexcept
+		{
+			return hierarchy;
+		}
+		void SetApplied(uint32_t id, dx::FXMMATRIX applied)
+		{
+			dx::XMStoreFloat4x4(&nodes[id]->applied, applied);
+			hierarchy.SetApplied(id, applied);
+		}
+		dx::XMMATRIX RandomTransform()
+		{
+			std::uniform_real_distribution<float> d{ -1.0f,1.0f };
+			return dx::XMMatrixScaling(1.0f + d(rng) * 0.05f, 1.0f + d(rng) * 0.05f, 1.0f + d(rng) * 0.05f) *
+				dx::XMMatrixRotationRollPitchYaw(d(rng), d(rng), d(rng)) *
+				dx::XMMatrixTranslation(d(rng), d(rng), d(rng));
+		}
+	private:
+		std::unique_ptr<TreeNode> MakeNode()
+		{
+			auto pNode = std::make_unique<TreeNode>();
+			dx::XMStoreFloat4x4(&pNode->local, RandomTransform());
+			dx::XMStoreFloat4x4(&pNode->applied, dx::XMMatrixIdentity());
+			nodes.push_back(pNode.get());
+			return pNode;
+		}
+		void Flatten(TreeNode& node, uint32_t parent, uint32_t& next)
+		{
+			node.id = next++;
+			nodes[node.id] = &node;
+			hierarchy.Add(parent, dx::XMLoadFloat4x4(&node.local));
+			for (auto& pc : node.children)
+			{
+				Flatten(*pc, node.id, next);
+			}
+			hierarchy.CloseSubtree(node.id);
+		}
+	private:
+		std::mt19937 rng;
+		std::unique_ptr<TreeNode> pRoot;
+		std::vector<TreeNode*> nodes;
+		TransformHierarchy hierarchy;
+	};
+
+	// largest element difference between the hierarchy's world matrices and the recursive ones,
+	// relative to the element's magnitude where that is above one
+	float MaxDifference(SyntheticModel& model)
+	{
+		std::vector<dx::XMFLOAT4X4> reference(model.GetCount());
+		Accumulate(model.Root(), dx::XMMatrixIdentity(), reference);
+		float maxDiff = 0.0f;
+		for (uint32_t i = 0; i < model.GetCount(); i++)
+		{
+			dx::XMFLOAT4X4 world;
+			dx::XMStoreFloat4x4(&world, model.Hierarchy().GetWorld(i));
+			for (int r = 0; r < 4; r++)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					const auto ref = reference[i].m[r][c];
+					maxDiff = std::max(maxDiff, std::abs(world.m[r][c] - ref) / std::max(1.0f, std::abs(ref)));
+				}
+			}
+		}
+		return maxDiff;
+	}
+
+	// the subtree of the node whose descendant count is closest to size
+	uint32_t FindSubtree(SyntheticModel& model, size_t size)
+	{
+		std::vector<size_t> sizes(model.GetCount(), 1u);
+		// preorder, so walking backwards visits every child before its parent
+		for (auto i = model.GetCount(); i-- > 0u; )
+		{
+			for (const auto& pc : model.Get(uint32_t(i)).children)
+			{
+				sizes[i] += sizes[pc->id];
+			}
+		}
+		uint32_t best = 0u;
+		for (uint32_t i = 0; i < model.GetCount(); i++)
+		{
+			if (std::abs(double(sizes[i]) - double(size)) < std::abs(double(sizes[best]) - double(size)))
+			{
+				best = i;
+			}
+		}
+		return best;
+	}
+}
+
+TEST(TransformHierarchyMatchesRecursive)
+{
+	SyntheticModel model{ 4096u,3u };
+	auto& hierarchy = model.Hierarchy();
+	CHECK(hierarchy.Update());
+	CHECK(MaxDifference(model) < 1e-4f);
+	CHECK(!hierarchy.Update());
+
+	// changes to a few scattered nodes, some of them nested inside each other's subtrees
+	for (const auto id : { 1u,17u,18u,400u,4095u })
+	{
+		model.SetApplied(id, model.RandomTransform());
+	}
+	CHECK(hierarchy.Update());
+	CHECK(MaxDifference(model) < 1e-4f);
+	CHECK(!hierarchy.Update());
+
+	model.SetApplied(0u, model.RandomTransform());
+	CHECK(hierarchy.Update());
+	CHECK(MaxDifference(model) < 1e-4f);
+}
+
+BENCHMARK(TransformHierarchyUpdate)
+{
+	using Clock = std::chrono::steady_clock;
+	constexpr size_t nodeCount = 100000u;
+	constexpr int frames = 200;
+	SyntheticModel model{ nodeCount,7u };
+	auto& hierarchy = model.Hierarchy();
+	hierarchy.Update();
+	const auto root = dx::XMMatrixRotationY(0.5f);
+	const auto subtree = FindSubtree(model, 64u);
+	const auto perFrame = [&](auto&& frame)
+	{
+		const auto begin = Clock::now();
+		for (int f = 0; f < frames; f++)
+		{
+			frame();
+		}
+		const std::chrono::duration<double> elapsed = Clock::now() - begin;
+		return elapsed.count() / frames;
+	};
+
+	std::vector<dx::XMFLOAT4X4> world(nodeCount);
+	const auto recursive = perFrame([&] { Accumulate(model.Root(), dx::XMMatrixIdentity(), world); });
+	const auto full = perFrame([&]
+	{
+		hierarchy.SetApplied(0u, root);
+		hierarchy.Update();
+	});
+	const auto dirtySubtree = perFrame([&]
+	{
+		hierarchy.SetApplied(subtree, root);
+		hierarchy.Update();
+	});
+	const auto clean = perFrame([&] { hierarchy.Update(); });
+
+	Test::Report("100k nodes, recursive every frame (before)", recursive * 1e6, "us/frame");
+	Test::Report("100k nodes, root dirty, full rebuild", full * 1e6, "us/frame");
+	Test::Report("100k nodes, one dirty subtree of ~64", dirtySubtree * 1e6, "us/frame");
+	Test::Report("100k nodes, nothing dirty", clean * 1e6, "us/frame");
+}
@@ -0,0 +1,351 @@
+#include "Test.h"
+#include <Engine/Architecture/Material.h>
+#include <Engine/Architecture/VertexLayout.h>
+#include <IndexedTriangleList.h>
+#include <assimp/scene.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace dx = DirectX;
+
+namespace
+{
+	// every layout a phong material asks for, one per distinct set of maps
+	std::vector<DV::VertexLayout> MaterialLayouts()
+	{
+		std::vector<DV::VertexLayout> layouts;
+		for (unsigned maps = 0; maps < 8u; maps++)
+		{
+			Material::Description description;
+			description.diffuseMap = maps & 1u ? "dif.png" : "";
+			description.specularMap = maps & 2u ? "spc.png" : "";
+			description.normalMap = maps & 4u ? "nrm.png" : "";
+			auto layout = Material::MakeVertexLayout(description);
+			if (std::none_of(layouts.begin(), layouts.end(), [&](const DV::VertexLayout& l) { return l.GetCode() == layout.GetCode(); }))
+			{
+				layouts.push_back(std::move(layout));
+			}
+		}
+		return layouts;
+	}
+
+	// random vertices with the awkward cases mixed in: zero and signed zero normals, axis aligned
+	// vectors, texcoords out of half range. the mesh owns its arrays like an imported one does
+	std::unique_ptr<aiMesh> MakeMesh(unsigned vertexCount, unsigned seed)
+	{
+		std::mt19937 rng{ seed };
+		std::uniform_real_distribution<float> d{ -1.0f,1.0f };
+		const auto unit = [&]
+		{
+			switch (rng() % 16u)
+			{
+			case 0: return aiVector3D{ 0.0f,0.0f,0.0f };
+			case 1: return aiVector3D{ -0.0f,0.0f,-1.0f };
+			case 2: return aiVector3D{ 0.0f,-0.0f,-0.0f };
+			case 3: return aiVector3D{ 1.0f,0.0f,0.0f };
+			case 4: return aiVector3D{ 0.0f,-1.0f,-0.0f };
+			default:
+			{
+				const aiVector3D v{ d(rng),d(rng),d(rng) };
+				const auto l = std::sqrt(v * v);
+				return l > 0.0f ? aiVector3D{ v.x / l,v.y / l,v.z / l } : v;
+			}
+			}
+		};
+		auto pMesh = std::make_unique<aiMesh>();
+		pMesh->mNumVertices = vertexCount;
+		pMesh->mVertices = new aiVector3D[vertexCount];
+		pMesh->mNormals = new aiVector3D[vertexCount];
+		pMesh->mTangents = new aiVector3D[vertexCount];
+		pMesh->mBitangents = new aiVector3D[vertexCount];
+		pMesh->mTextureCoords[0] = new aiVector3D[vertexCount];
+		pMesh->mNumUVComponents[0] = 2u;
+		for (unsigned i = 0; i < vertexCount; i++)
+		{
+			pMesh->mVertices[i] = { d(rng) * 100.0f,d(rng) * 3.0f,d(rng) };
+			pMesh->mNormals[i] = unit();
+			pMesh->mTangents[i] = unit();
+			pMesh->mBitangents[i] = unit();
+			pMesh->mTextureCoords[0][i] = { d(rng) * 4.0f,d(rng) * 70000.0f,0.0f };
+		}
+		return pMesh;
+	}
+
+	// the per vertex path the column fill replaced, for Bridge
+	template<DV::Type type>
+	struct ExtractSetting
+	{
+		static void Exec(DV::Vertex& vertex, size_t element, const aiMesh& mesh, size_t i, const DV::PositionQuantization& quantization) noexcept
+		{
+			vertex.SetAttributeByIndex(element, DV::VertexLayout::Map<type>::Extract(mesh, i, quantization));
+		}
+	};
+
+	// the per vertex path into a buffer of the same layout and quantization as filled
+	DV::VertexBuffer ExtractPerVertex(const DV::VertexLayout& layout, const aiMesh& mesh, const DV::PositionQuantization& quantization)
+	{
+		DV::VertexBuffer vb{ layout,mesh.mNumVertices };
+		vb.SetQuantization(quantization);
+		for (size_t i = 0; i < mesh.mNumVertices; i++)
+		{
+			auto vertex = vb[i];
+			for (size_t e = 0; e < layout.GetElementCount(); e++)
+			{
+				DV::VertexLayout::Bridge<ExtractSetting>(layout.ResolveByIndex(e).GetType(), vertex, e, mesh, i, quantization);
+			}
+		}
+		return vb;
+	}
+
+	template<typename Lane, size_t count>
+	bool LanesWithinOne(const unsigned char* pA, const unsigned char* pB) noexcept
+	{
+		Lane a[count];
+		Lane b[count];
+		std::memcpy(a, pA, sizeof(a));
+		std::memcpy(b, pB, sizeof(b));
+		for (size_t i = 0; i < count; i++)
+		{
+			if (std::abs(int(a[i]) - int(b[i])) > 1)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// the column fill encodes four vertices at a time with the vector forms of the per vertex
+	// encoders, so the encoded lanes may round one unit apart; the float elements are copies
+	template<DV::Type type>
+	struct ElementMatching
+	{
+		static bool Exec(const unsigned char* pA, const unsigned char* pB) noexcept
+		{
+			using SysType = typename DV::VertexLayout::Map<type>::SysType;
+			if constexpr (type == DV::Type::QuantizedPosition3D || type == DV::Type::HalfTexture2D)
+			{
+				return LanesWithinOne<uint16_t, sizeof(SysType) / sizeof(uint16_t)>(pA, pB);
+			}
+			else if constexpr (type == DV::Type::OctNormal)
+			{
+				return LanesWithinOne<int16_t, 2u>(pA, pB);
+			}
+			else if constexpr (type == DV::Type::OctTangent)
+			{
+				uint32_t a;
+				uint32_t b;
+				std::memcpy(&a, pA, sizeof(a));
+				std::memcpy(&b, pB, sizeof(b));
+				const uint32_t lanesA[] = { a & 0x3FFu,(a >> 10u) & 0x3FFu,(a >> 20u) & 0x3FFu,a >> 30u };
+				const uint32_t lanesB[] = { b & 0x3FFu,(b >> 10u) & 0x3FFu,(b >> 20u) & 0x3FFu,b >> 30u };
+				// the handedness bit is a sign test and must agree exactly
+				return LanesWithinOne<uint32_t, 3u>(reinterpret_cast<const unsigned char*>(lanesA), reinterpret_cast<const unsigned char*>(lanesB))
+					&& lanesA[3] == lanesB[3];
+			}
+			else
+			{
+				return std::memcmp(pA, pB, sizeof(SysType)) == 0;
+			}
+		}
+	};
+
+	// how Vertex::Attr found an attribute before the offset table, searching the layout's
+	// elements on every access
+	template<DV::Type type>
+	auto& ResolvedAttr(DV::VertexBuffer& vb, size_t i) noexcept
+	{
+		const auto& layout = vb.GetLayout();
+		const auto pAttribute = const_cast<unsigned char*>(vb.data()) + i * layout.Size() + layout.Resolve<type>().GetOffset();
+		return *reinterpret_cast<typename DV::VertexLayout::Map<type>::SysType*>(pAttribute);
+	}
+
+	// a side by side grid of quads, every other one split along the other diagonal
+	IndexedTriangleList MakeGrid(const DV::VertexLayout& layout, uint32_t side)
+	{
+		DV::VertexBuffer vb{ layout,size_t(side) * side };
+		const auto positions = vb.Span<DV::Type::Position3D>();
+		for (uint32_t y = 0; y < side; y++)
+		{
+			for (uint32_t x = 0; x < side; x++)
+			{
+				positions[y * side + x] = { float(x),float((x * 7u + y * 3u) % 5u) * 0.1f,float(y) };
+			}
+		}
+		std::vector<uint32_t> indices;
+		for (uint32_t y = 0; y + 1u < side; y++)
+		{
+			for (uint32_t x = 0; x + 1u < side; x++)
+			{
+				const auto i = y * side + x;
+				if ((x + y) % 2u == 0u)
+				{
+					indices.insert(indices.end(), { i,i + side,i + 1u,i + 1u,i + side,i + side + 1u });
+				}
+				else
+				{
+					indices.insert(indices.end(), { i,i + side,i + side + 1u,i,i + side + 1u,i + 1u });
+				}
+			}
+		}
+		return { std::move(vb),std::move(indices) };
+	}
+}
+
+// meshes are filled a column at a time in chunks of fillChunkSize vertices, four vertices per step;
+// sizes around both boundaries take every tail path
+TEST(VertexLayoutColumnFillMatchesPerVertex)
+{
+	constexpr size_t chunk = DV::VertexBuffer::fillChunkSize;
+	const size_t sizes[] = { 1u,3u,4u,5u,chunk - 1u,chunk,chunk + 1u,2u * chunk + 5u };
+	for (const auto& layout : MaterialLayouts())
+	{
+		for (const auto size : sizes)
+		{
+			const auto pMesh = MakeMesh(unsigned(size), unsigned(size));
+			const DV::VertexBuffer filled{ layout,*pMesh };
+			REQUIRE(filled.Count() == size);
+			const auto reference = ExtractPerVertex(layout, *pMesh, filled.GetQuantization());
+			REQUIRE(reference.Size() == filled.Size());
+			size_t mismatches = 0u;
+			for (size_t i = 0; i < size; i++)
+			{
+				const auto pA = filled.data() + i * layout.Size();
+				const auto pB = reference.data() + i * layout.Size();
+				for (size_t e = 0; e < layout.GetElementCount(); e++)
+				{
+					const auto& element = layout.ResolveByIndex(e);
+					if (!DV::VertexLayout::Bridge<ElementMatching>(element.GetType(), pA + element.GetOffset(), pB + element.GetOffset()))
+					{
+						mismatches++;
+					}
+				}
+			}
+			if (mismatches != 0u)
+			{
+				Test::Fail(__FILE__, __LINE__, layout.GetCode() + " at " + std::to_string(size) + " vertices: "
+					+ std::to_string(mismatches) + " elements differ from the per vertex path");
+			}
+		}
+	}
+}
+
+BENCHMARK(VertexLayoutFillThroughput)
+{
+	using Clock = std::chrono::steady_clock;
+	constexpr unsigned vertexCount = (1u << 20) + 3u;
+	const auto pMesh = MakeMesh(vertexCount, 11u);
+	const auto best = [](auto&& fill)
+	{
+		std::chrono::duration<double> fastest{ 1e30 };
+		for (int r = 0; r < 5; r++)
+		{
+			const auto begin = Clock::now();
+			fill();
+			fastest = std::min<std::chrono::duration<double>>(fastest, Clock::now() - begin);
+		}
+		return fastest.count();
+	};
+	for (const auto& layout : MaterialLayouts())
+	{
+		const DV::VertexBuffer filled{ layout,*pMesh };
+		const auto quantization = filled.GetQuantization();
+		const auto perVertex = best([&] { ExtractPerVertex(layout, *pMesh, quantization); });
+		const auto columns = best([&] { DV::VertexBuffer{ layout,*pMesh }; });
+		Test::Report(layout.GetCode() + " per vertex (before)", vertexCount / perVertex, "vertices/s");
+		Test::Report(layout.GetCode() + " column fill", vertexCount / columns, "vertices/s");
+	}
+}
+
+// per access element search (before) against the offset table and attribute spans (after) in
+// the whole-buffer loops: writing attributes vertex by vertex, IndexedTriangleList::Deform and
+// CalcNormalsIndependentFlat
+BENCHMARK(VertexLayoutAttributeAccess)
+{
+	using Clock = std::chrono::steady_clock;
+	const auto layout = DV::VertexLayout{} + DV::Type::Position3D + DV::Type::Texture2D + DV::Type::Normal + DV::Type::Tangent + DV::Type::Bitangent;
+	auto grid = MakeGrid(layout, 512u);
+	auto& vb = grid.vertices;
+	const auto vertexCount = vb.Count();
+	const auto best = [](auto&& work)
+	{
+		std::chrono::duration<double> fastest{ 1e30 };
+		for (int r = 0; r < 5; r++)
+		{
+			const auto begin = Clock::now();
+			work();
+			fastest = std::min<std::chrono::duration<double>>(fastest, Clock::now() - begin);
+		}
+		return fastest.count() * 1e3;
+	};
+
+	Test::Report("fill, element search per access (before)", best([&]
+	{
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			ResolvedAttr<DV::Type::Texture2D>(vb, i) = { 0.5f,0.5f };
+			ResolvedAttr<DV::Type::Normal>(vb, i) = { 0.0f,1.0f,0.0f };
+			ResolvedAttr<DV::Type::Tangent>(vb, i) = { 1.0f,0.0f,0.0f };
+			ResolvedAttr<DV::Type::Bitangent>(vb, i) = { 0.0f,0.0f,1.0f };
+		}
+	}), "ms");
+	Test::Report("fill, Vertex::Attr through the offset table", best([&]
+	{
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			auto vertex = vb[i];
+			vertex.Attr<DV::Type::Texture2D>() = { 0.5f,0.5f };
+			vertex.Attr<DV::Type::Normal>() = { 0.0f,1.0f,0.0f };
+			vertex.Attr<DV::Type::Tangent>() = { 1.0f,0.0f,0.0f };
+			vertex.Attr<DV::Type::Bitangent>() = { 0.0f,0.0f,1.0f };
+		}
+	}), "ms");
+	Test::Report("fill, attribute spans", best([&]
+	{
+		const auto texcoords = vb.Span<DV::Type::Texture2D>();
+		const auto normals = vb.Span<DV::Type::Normal>();
+		const auto tangents = vb.Span<DV::Type::Tangent>();
+		const auto bitangents = vb.Span<DV::Type::Bitangent>();
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			texcoords[i] = { 0.5f,0.5f };
+			normals[i] = { 0.0f,1.0f,0.0f };
+			tangents[i] = { 1.0f,0.0f,0.0f };
+			bitangents[i] = { 0.0f,0.0f,1.0f };
+		}
+	}), "ms");
+
+	// a rotation keeps the grid from drifting off over the runs
+	const auto rotation = dx::XMMatrixRotationY(0.001f);
+	Test::Report("Deform, element search per access (before)", best([&]
+	{
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			auto& pos = ResolvedAttr<DV::Type::Position3D>(vb, i);
+			dx::XMStoreFloat3(&pos, dx::XMVector3Transform(dx::XMLoadFloat3(&pos), rotation));
+		}
+	}), "ms");
+	Test::Report("Deform, attribute span", best([&] { grid.Deform(rotation); }), "ms");
+
+	const auto& indices = grid.indices;
+	Test::Report("flat normals, element search per access (before)", best([&]
+	{
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const auto p0 = dx::XMLoadFloat3(&ResolvedAttr<DV::Type::Position3D>(vb, indices[i]));
+			const auto p1 = dx::XMLoadFloat3(&ResolvedAttr<DV::Type::Position3D>(vb, indices[i + 1]));
+			const auto p2 = dx::XMLoadFloat3(&ResolvedAttr<DV::Type::Position3D>(vb, indices[i + 2]));
+			const auto n = dx::XMVector3Normalize(dx::XMVector3Cross(dx::XMVectorSubtract(p1, p0), dx::XMVectorSubtract(p2, p0)));
+			dx::XMStoreFloat3(&ResolvedAttr<DV::Type::Normal>(vb, indices[i]), n);
+			dx::XMStoreFloat3(&ResolvedAttr<DV::Type::Normal>(vb, indices[i + 1]), n);
+			dx::XMStoreFloat3(&ResolvedAttr<DV::Type::Normal>(vb, indices[i + 2]), n);
+		}
+	}), "ms");
+	Test::Report("flat normals, CalcNormalsIndependentFlat", best([&] { grid.CalcNormalsIndependentFlat(); }), "ms");
+}
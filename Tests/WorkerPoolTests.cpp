@@ -0,0 +1,94 @@
+#include "Test.h"
+#include <Framework/WorkerPool.h>
+#include <Framework/ParallelFor.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+TEST(WorkerPoolRunsEveryIndexOnce)
+{
+	WorkerPool pool{ 3u };
+	// the same helpers serve every run, as they do frame after frame
+	for (size_t run = 0; run < 200; run++)
+	{
+		const auto count = run % 7u;
+		std::vector<std::atomic<int>> visits(count);
+		pool.Run(count, [&](size_t i)
+		{
+			visits[i]++;
+		});
+		for (const auto& v : visits)
+		{
+			CHECK(v == 1);
+		}
+	}
+}
+
+TEST(WorkerPoolRethrowsAndRecovers)
+{
+	WorkerPool pool{ 2u };
+	bool threw = false;
+	try
+	{
+		pool.Run(64u, [](size_t i)
+		{
+			if (i == 17u)
+			{
+				throw std::runtime_error("work failed");
+			}
+		});
+	}
+	catch (const std::runtime_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+	std::atomic<size_t> sum = 0u;
+	pool.Run(10u, [&](size_t i)
+	{
+		sum += i;
+	});
+	CHECK(sum == 45u);
+}
+
+TEST(WorkerPoolWithoutHelpers)
+{
+	WorkerPool pool{ 0u };
+	size_t sum = 0u;
+	pool.Run(10u, [&](size_t i)
+	{
+		sum += i;
+	});
+	CHECK(sum == 45u);
+}
+
+TEST(ParallelForNestedRunsOnItsWorker)
+{
+	constexpr size_t outer = 8u;
+	constexpr size_t inner = 16u;
+	std::vector<std::atomic<int>> visits(outer * inner);
+	std::atomic<int> mismatches = 0;
+	ParallelFor(outer, [&](size_t i)
+	{
+		const auto worker = std::this_thread::get_id();
+		ParallelFor(inner, [&](size_t j)
+		{
+			visits[i * inner + j]++;
+			mismatches += std::this_thread::get_id() != worker;
+		}, 4u);
+	}, 4u);
+	CHECK(mismatches == 0);
+	for (const auto& v : visits)
+	{
+		CHECK(v == 1);
+	}
+	// left behind on no thread, so a later top level call splits again
+	CHECK(!IsInParallelFor());
+	std::atomic<size_t> flagged = 0u;
+	ParallelFor(10u, [&](size_t)
+	{
+		flagged += IsInParallelFor();
+	}, 3u);
+	CHECK(flagged == 10u);
+	CHECK(!IsInParallelFor());
+}
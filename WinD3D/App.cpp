@@ -1,6 +1,8 @@
 #include "App.h"
 #include "ImGUI/imgui.h"
 #include "Engine/Entities/ModelProbe.h"
+#include "Engine/Architecture/Codex.h"
+#include "Framework/PerfLog.h"
 
 namespace dx = DirectX;
 
@@ -55,19 +57,33 @@ int App::Go()
 
 void App::DoFrame(float dt)
 {
+	PerfLog::NextFrame();
+	PERF_SCOPE("App::DoFrame");
 	const auto s = dt*speed;
 	wnd.Gfx().BeginFrame(0.07f, 0.0f, 0.12f);
 	wnd.Gfx().SetCamera(cam.GetViewMatrix());
+	// nothing to draw until the scene is imported
+	const auto pSponza = sponza.Poll();
+	if (occlusionCulling && pSponza != nullptr)
+	{
+		// rasterized on workers while the light binds and the frustum is culled
+		occlusion.Begin(wnd.Gfx().GetCamera() * wnd.Gfx().GetProjection());
+		pSponza->AddOccluders(occlusion);
+		occlusion.Rasterize();
+	}
 	light.Bind(wnd.Gfx(), cam.GetViewMatrix());
 	
 
-	sponza.Submit(fc);
+	if (pSponza != nullptr)
+	{
+		pSponza->Submit(fc, wnd.Gfx().GetFrustum(), occlusionCulling ? &occlusion : nullptr);
+	}
 	//light.Submit(fc);
 	//cube.Submit(fc);
 	//cube2.Submit(fc);
 	fc.Execute(wnd.Gfx());
 
-
+	PerfLog::Scope imguiScope{ "ImGui" };
 	if (ImGui::Begin("Simulation speed"))
 	{
 		ImGui::SliderFloat("Speed Factor", &speed, 0.0f, 3.0f);
@@ -75,6 +91,89 @@ void App::DoFrame(float dt)
 	}
 	ImGui::End();
 
+	if (ImGui::Begin("Passes"))
+	{
+		if (!sponza.IsDone())
+		{
+			ImGui::Text("loading: %.0f%%", sponza.GetProgress() * 100.0f);
+		}
+		if (pSponza != nullptr)
+		{
+			const auto& cs = pSponza->GetCullStats();
+			ImGui::Text("meshes: %zu visible / %zu culled / %zu occluded, %zu triangles", cs.visible, cs.culled, cs.occluded, cs.triangles);
+		}
+		ImGui::Checkbox("Occlusion culling", &occlusionCulling);
+		if (occlusionCulling)
+		{
+			const auto& os = occlusion.GetStats();
+			ImGui::Text("occluders: %zu meshes, %zu of %zu triangles rasterized", os.occluders, os.rasterized, os.triangles);
+		}
+		for (size_t i = 0; i < fc.GetPassCount(); i++)
+		{
+			if (!fc.WasPassExecuted(i))
+			{
+				ImGui::TextDisabled("%s: culled", fc.GetPassName(i).c_str());
+				continue;
+			}
+			const auto& ps = fc.GetPassStats(i);
+			ImGui::Text("%s: %zu jobs in %zu draws, state changes %zu submitted / %zu executed, %zu commands",
+				fc.GetPassName(i).c_str(), ps.jobs, ps.draws, ps.stateChangesSubmitted, ps.stateChangesExecuted, ps.commands);
+		}
+		const auto& fs = fc.GetStats();
+		ImGui::Text("record %.3f ms, replay %.3f ms (%.1f M commands/s)", fs.recordSeconds * 1000.0f,
+			fs.replaySeconds * 1000.0f, fs.replaySeconds > 0.0f ? fs.commands / fs.replaySeconds / 1e6f : 0.0f);
+		const auto& bs = wnd.Gfx().GetBindCache().GetLastFrameStats();
+		ImGui::Text("binds last frame: %zu issued / %zu skipped", bs.issued, bs.skipped);
+	}
+	ImGui::End();
+
+	if (ImGui::Begin("Profiler"))
+	{
+		const auto ps = PerfLog::GetFrameStats();
+		ImGui::Text("%zu frames: p50 %.2f ms, p99 %.2f ms, worst %.2f ms", ps.frames, ps.p50, ps.p99, ps.worst);
+		// frame time distribution, 0 to the worst frame in equal buckets
+		constexpr int bucketCount = 32;
+		float buckets[bucketCount] = {};
+		if (ps.worst > 0.0f)
+		{
+			for (const auto t : PerfLog::GetFrameTimes())
+			{
+				buckets[std::min(int(t / ps.worst * bucketCount), bucketCount - 1)] += 1.0f;
+			}
+		}
+		ImGui::PlotHistogram("##frametimes", buckets, bucketCount, 0, "frame time histogram", 0.0f, FLT_MAX, { 0.0f,80.0f });
+		static int traceFrames = 60;
+		ImGui::SliderInt("Frames", &traceFrames, 1, int(PerfLog::frameHistory));
+		if (ImGui::Button("Dump Chrome trace"))
+		{
+			PerfLog::DumpChromeTrace("trace.json", size_t(traceFrames));
+		}
+	}
+	ImGui::End();
+
+	if (ImGui::Begin("Codex"))
+	{
+		const auto stats = Codex::GetStats();
+		ImGui::Text("%zu entries, %.2f MB (budget %.2f MB)", stats.entries, stats.bytes / 1048576.0f, stats.budget / 1048576.0f);
+		ImGui::Text("hits %llu, misses %llu, evictions %llu", stats.hits, stats.misses, stats.evictions);
+		ImGui::Columns(3, nullptr, true);
+		for (const auto& t : stats.types)
+		{
+			ImGui::Text("%s", t.typeName);
+			ImGui::NextColumn();
+			ImGui::Text("%zu", t.entries);
+			ImGui::NextColumn();
+			ImGui::Text("%.1f KB", t.bytes / 1024.0f);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+		if (ImGui::Button("Trim"))
+		{
+			Codex::Trim();
+		}
+	}
+	ImGui::End();
+
 	// Mesh techniques window
 	class TP : public TechniqueProbe
 	{
@@ -142,6 +241,32 @@ void App::DoFrame(float dt)
 	class MP : ModelProbe
 	{
 	public:
+		void Select(Node& node)
+		{
+			// used to change the highlighted node on selection change
+			struct Probe : public TechniqueProbe
+			{
+				virtual void OnSetTechnique()
+				{
+					if (pTech->GetName() == "Outline")
+					{
+						pTech->SetActiveState(highlighted);
+					}
+				}
+				bool highlighted = false;
+			} probe;
+
+			// remove highlight on prev-selected node
+			if (pSelectedNode != nullptr)
+			{
+				pSelectedNode->Accept(probe);
+			}
+			// add highlight to newly-selected node
+			probe.highlighted = true; 
+			node.Accept(probe);
+
+			pSelectedNode = &node;
+		}
 		void SpawnWindow(Model& model)
 		{
 			ImGui::Begin("Model");
@@ -196,29 +321,7 @@ void App::DoFrame(float dt)
 			// processing for selecting node
 			if (ImGui::IsItemClicked())
 			{
-				// used to change the highlighted node on selection change
-				struct Probe : public TechniqueProbe
-				{
-					virtual void OnSetTechnique()
-					{
-						if (pTech->GetName() == "Outline")
-						{
-							pTech->SetActiveState(highlighted);
-						}
-					}
-					bool highlighted = false;
-				} probe;
-
-				// remove highlight on prev-selected node
-				if (pSelectedNode != nullptr)
-				{
-					pSelectedNode->Accept(probe);
-				}
-				// add highlight to newly-selected node
-				probe.highlighted = true; 
-				node.Accept(probe);
-
-				pSelectedNode = &node;
+				Select(node);
 			}
 			// signal if children should also be recursed
 			return expanded;
@@ -267,8 +370,31 @@ void App::DoFrame(float dt)
 	};
 	static MP modelProbe;
 
+	// click-to-pick, clicks imgui takes for itself never reach the mouse queue
+	while (const auto e = wnd.mouse.Read())
+	{
+		if (e->GetType() == Mouse::Event::Type::LPress && wnd.CursorEnabled() && pSponza != nullptr)
+		{
+			const auto& gfx = wnd.Gfx();
+			const auto unproject = [&](float depth)
+			{
+				return dx::XMVector3Unproject(dx::XMVectorSet(float(e->GetPosX()), float(e->GetPosY()), depth, 0.0f),
+					0.0f, 0.0f, float(gfx.GetWidth()), float(gfx.GetHeight()), 0.0f, 1.0f,
+					gfx.GetProjection(), gfx.GetCamera(), dx::XMMatrixIdentity());
+			};
+			const auto nearPoint = unproject(0.0f);
+			if (const auto pNode = pSponza->Pick(nearPoint, dx::XMVectorSubtract(unproject(1.0f), nearPoint)))
+			{
+				modelProbe.Select(*pNode);
+			}
+		}
+	}
+
 	// imgui windows
-	modelProbe.SpawnWindow(sponza);
+	if (pSponza != nullptr)
+	{
+		modelProbe.SpawnWindow(*pSponza);
+	}
 
 	ProcessInput(dt);
 	cam.SpawnControlWindow();
@@ -276,6 +402,7 @@ void App::DoFrame(float dt)
 	//cube.SpawnControlWindow(wnd.Gfx(), "Cube 1");
 	//cube2.SpawnControlWindow(wnd.Gfx(), "Cube 2");
 
+	imguiScope.End();
 	// Present
 	wnd.Gfx().EndFrame();
 	fc.Reset();
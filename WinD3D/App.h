@@ -2,10 +2,12 @@
 #include <Engine/Window.h>
 #include <Engine/Entities/ImGUIManager.h>
 #include <Engine/Entities/Model.h>
+#include <Engine/Entities/ModelLoader.h>
 #include "Camera.h"
 #include "PointLight.h"
 #include "SkinnedBox.h"
 #include <Engine/Architecture/FrameCommander.h>
+#include <Engine/OcclusionBuffer.h>
 
 class App
 {
@@ -21,12 +23,16 @@ private:
 	ImGUIManager imgui;
 	Window wnd;
 	Camera cam;
-	FrameCommander fc;
+	FrameCommander fc{ wnd.Gfx() };
 
 	PointLight light;
 	//TestCube cube{ wnd.Gfx(),4.0f };
 	//TestCube cube2{ wnd.Gfx(),4.0f };
-	Model sponza{ wnd.Gfx(), "Models\\brick_wall\\brick_wall.obj", 1.0f/*/20.0f*/ };
+	// meshes stream in over the first frames
+	ModelLoader sponza{ wnd.Gfx(), "Models\\brick_wall\\brick_wall.obj", 1.0f/*/20.0f*/ };
+	// declared after the model so it goes first, a rasterization in flight reads the model's meshes
+	OcclusionBuffer occlusion;
+	bool occlusionCulling = true;
 
 	float speed = 1.0f;
 };
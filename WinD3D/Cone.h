@@ -39,7 +39,7 @@ public:
 
 
 		// base indices
-		std::vector<unsigned short> indices;
+		std::vector<uint32_t> indices;
 		for (unsigned short iLong = 0; iLong < longDiv; iLong++)
 		{
 			indices.push_back(iCenter);
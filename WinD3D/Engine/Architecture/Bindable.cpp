@@ -11,6 +11,11 @@ ID3D11Device* Bindable::GetDevice(Graphics& gfx) noexcept
 	return gfx.pDevice.Get();
 }
 
+std::unique_lock<std::mutex> Bindable::LockContext(Graphics& gfx) noexcept
+{
+	return std::unique_lock<std::mutex>{ gfx.contextMutex };
+}
+
 DXGIInfoManager& Bindable::GetInfoManager(Graphics& gfx) noexcept(IS_DEBUG)
 {
 #ifndef NDEBUG
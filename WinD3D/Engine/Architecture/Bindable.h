@@ -1,13 +1,15 @@
 #pragma once
 #include <Engine/Graphics.h>
 #include <memory>
+#include "BindableKey.h"
 
 class Bindable
 {
 public:
 	virtual ~Bindable() = default;
 public:
-	virtual void Bind(Graphics& gfx)noexcept = 0;
+	// records the binding into cmd, gfx is only read so this may run on any thread
+	virtual void Bind(Graphics& gfx, CommandStream& cmd)noexcept = 0;
 	virtual void InitializeParentReference(const class Drawable&)noexcept
 	{
 
@@ -16,19 +18,35 @@ public:
 	{
 
 	}
-	virtual std::string GetUID() const noexcept
+	virtual BindableKey GetUID() const noexcept
 	{
 		assert(false);
-		return "";
+		return {};
+	}
+	// bytes of GPU memory owned by this bindable, set once at construction
+	size_t GetFootprint() const noexcept
+	{
+		return footprint;
 	}
 protected:
 	static ID3D11DeviceContext* GetContext(Graphics& gfx)noexcept;
 	static ID3D11Device* GetDevice(Graphics& gfx)noexcept;
+	static std::unique_lock<std::mutex> LockContext(Graphics& gfx)noexcept;
 	static DXGIInfoManager& GetInfoManager(Graphics& gfx)noexcept(IS_DEBUG);
+protected:
+	size_t footprint = 0u;
 };
 
+// per-drawable bindables, cloned for every drawable a step is copied into; they get the
+// world matrix of the job being recorded
 class CloningBindable : public Bindable
 {
 public:
 	virtual std::unique_ptr<CloningBindable> Clone() const noexcept = 0;
+	virtual void Bind(Graphics& gfx, CommandStream& cmd, DirectX::FXMMATRIX world) noexcept = 0;
+	// outside of a job there is no world matrix, draw at the origin
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override
+	{
+		Bind(gfx, cmd, DirectX::XMMatrixIdentity());
+	}
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+// 64-bit identity of a shareable bindable: a compile-time tag of the bindable type
+// folded together with the parameters that make two instances distinct (FNV-1a, strings
+// a word at a time)
+class BindableKey
+{
+public:
+	struct Hasher
+	{
+		size_t operator()(const BindableKey& key) const noexcept
+		{
+			return size_t(key.value);
+		}
+	};
+public:
+	constexpr BindableKey() noexcept = default;
+	template<class T>
+	static constexpr BindableKey Of() noexcept
+	{
+		return typeTag<T>;
+	}
+public:
+	constexpr BindableKey Mix(std::string_view str) const noexcept
+	{
+		// eight characters a step; a multiply only carries upwards, so the high half is folded
+		// back down each step for the low bits (the bucket index) to depend on all of them
+		auto h = value;
+		size_t i = 0u;
+		for (; i + 8u <= str.size(); i += 8u)
+		{
+			uint64_t word = 0u;
+			for (size_t b = 0u; b < 8u; b++)
+			{
+				word |= uint64_t((unsigned char)str[i + b]) << (b * 8u);
+			}
+			h = (h ^ word) * prime;
+			h ^= h >> 32u;
+		}
+		for (; i < str.size(); i++)
+		{
+			h = (h ^ uint64_t((unsigned char)str[i])) * prime;
+		}
+		// terminator so that ("ab","c") and ("a","bc") don't collide
+		return BindableKey{ (h ^ 0xFFu) * prime };
+	}
+	template<typename V, typename = std::enable_if_t<std::is_integral_v<V> || std::is_enum_v<V>>>
+	constexpr BindableKey Mix(V v) const noexcept
+	{
+		auto h = value;
+		auto bits = uint64_t(v);
+		for (size_t i = 0; i < sizeof(V); i++)
+		{
+			h = (h ^ (bits & 0xFFu)) * prime;
+			bits >>= 8;
+		}
+		return BindableKey{ h };
+	}
+	constexpr uint64_t Value() const noexcept
+	{
+		return value;
+	}
+	constexpr bool operator==(const BindableKey& rhs) const noexcept
+	{
+		return value == rhs.value;
+	}
+	constexpr bool operator!=(const BindableKey& rhs) const noexcept
+	{
+		return value != rhs.value;
+	}
+private:
+	constexpr explicit BindableKey(uint64_t value) noexcept
+		:
+		value(value)
+	{}
+private:
+	template<class T>
+	static constexpr BindableKey MakeTypeTag() noexcept
+	{
+#if defined(_MSC_VER)
+		return BindableKey{}.Mix(std::string_view{ __FUNCSIG__ });
+#else
+		return BindableKey{}.Mix(std::string_view{ __PRETTY_FUNCTION__ });
+#endif
+	}
+	// a variable, so the signature is hashed by the compiler and not on every resolve
+	template<class T>
+	static constexpr BindableKey typeTag = MakeTypeTag<T>();
+private:
+	static constexpr uint64_t offsetBasis = 0xCBF29CE484222325ull;
+	static constexpr uint64_t prime = 0x100000001B3ull;
+	uint64_t value = offsetBasis;
+};
@@ -29,11 +29,11 @@ BlendState::BlendState(Graphics& gfx, bool blending)
 	GFX_THROW_INFO(GetDevice(gfx)->CreateBlendState(&blendDesc, &pBlendState));
 }
 
-void BlendState::Bind(Graphics& gfx) noexcept
+void BlendState::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->OMSetBlendState(pBlendState.Get(), nullptr, 0xFFFFFFFFu);
+	cmd.SetBlend(pBlendState.Get());
 }
-std::string BlendState::GetUID() const noexcept
+BindableKey BlendState::GetUID() const noexcept
 {
 	return GenerateUID(blendingMode);
 }
@@ -42,7 +42,7 @@ std::shared_ptr<BlendState> BlendState::Resolve(Graphics& gfx, bool blending)
 {
 	return Codex::Resolve<BlendState>(gfx, blending);
 }
-std::string BlendState::GenerateUID(bool Blending)
+BindableKey BlendState::GenerateUID(bool Blending)
 {
-	return std::string(typeid(BlendState).name()) + "#" + (Blending ? "+" : "-");
+	return BindableKey::Of<BlendState>().Mix(Blending);
 }
@@ -0,0 +1,96 @@
+#include "Codex.h"
+#include <algorithm>
+
+void Codex::SetBudget(size_t bytes) noexcept
+{
+	Get().budget = bytes;
+	Trim();
+}
+
+void Codex::Trim() noexcept
+{
+	auto& codex = Get();
+	codex.Evict(codex.budget);
+}
+
+Codex::Stats Codex::GetStats() noexcept
+{
+	auto& codex = Get();
+	Stats stats;
+	for (auto& shard : codex.shards)
+	{
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		for (const auto& kv : shard.binds)
+		{
+			const auto& e = kv.second;
+			auto i = std::find_if(stats.types.begin(), stats.types.end(),
+				[&e](const Stats::TypeStats& ts) { return ts.typeName == e.pType->name(); });
+			if (i == stats.types.end())
+			{
+				i = stats.types.insert(stats.types.end(), { e.pType->name(),0u,0u });
+			}
+			i->entries++;
+			i->bytes += e.footprint;
+			stats.entries++;
+		}
+		stats.hits += shard.hits;
+		stats.misses += shard.misses;
+		stats.evictions += shard.evictions;
+	}
+	std::sort(stats.types.begin(), stats.types.end(),
+		[](const Stats::TypeStats& lhs, const Stats::TypeStats& rhs) { return lhs.bytes > rhs.bytes; });
+	stats.bytes = codex.bytes;
+	stats.budget = codex.budget;
+	return stats;
+}
+
+void Codex::Evict(size_t target) noexcept
+{
+	struct Candidate
+	{
+		Shard* pShard;
+		BindableKey key;
+		uint64_t lastUse;
+		// uses of the shard since, what is compared across shards; keys spread evenly over
+		// the shards, so their clocks run at about the same rate
+		uint64_t age;
+	};
+	std::vector<Candidate> candidates;
+	for (auto& shard : shards)
+	{
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		for (const auto& [key, e] : shard.binds)
+		{
+			if (IsEvictable(e))
+			{
+				candidates.push_back({ &shard,key,e.lastUse,shard.clock - e.lastUse });
+			}
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(),
+		[](const Candidate& lhs, const Candidate& rhs) { return lhs.age > rhs.age; });
+
+	for (const auto& c : candidates)
+	{
+		if (bytes <= target)
+		{
+			break;
+		}
+		std::lock_guard<std::mutex> lock(c.pShard->mtx);
+		// shard was unlocked since collection, entry may have been resolved again meanwhile
+		const auto i = c.pShard->binds.find(c.key);
+		if (i == c.pShard->binds.end() || i->second.lastUse != c.lastUse || !IsEvictable(i->second))
+		{
+			continue;
+		}
+		bytes -= i->second.footprint;
+		c.pShard->evictions++;
+		c.pShard->binds.erase(i);
+	}
+}
+
+bool Codex::IsEvictable(const Entry& entry) noexcept
+{
+	// without bind the construction is still in flight; with it, the codex must hold the only reference
+	return entry.bind != nullptr && entry.bind.use_count() == 1;
+}
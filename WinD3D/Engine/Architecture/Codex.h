@@ -1,34 +1,191 @@
 #pragma once
 #include <unordered_map>
 #include <memory>
+#include <mutex>
+#include <future>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <typeinfo>
+#include <cassert>
 #include <Framework/noexcept_if.h>
 #include "Bindable.h"
+#include "BindableKey.h"
 
 class Codex
 {
 public:
-	template<class T, typename ...Params> 
+	struct Stats
+	{
+		struct TypeStats
+		{
+			const char* typeName;
+			size_t entries;
+			size_t bytes;
+		};
+		std::vector<TypeStats> types;
+		size_t entries = 0u;
+		size_t bytes = 0u;
+		size_t budget = 0u;
+		uint64_t hits = 0u;
+		uint64_t misses = 0u;
+		uint64_t evictions = 0u;
+	};
+public:
+	// stands in for a bindable's payload parameter, converting to the payload by
+	// calling the factory, which therefore only runs when the resolve misses
+	template<typename F>
+	class Lazy
+	{
+	public:
+		Lazy(F factory) noexcept
+			:
+			factory(std::move(factory))
+		{}
+		operator std::invoke_result_t<F&>() const
+		{
+			return factory();
+		}
+	private:
+		mutable F factory;
+	};
+public:
+	template<class T, typename ...Params>
 	static std::shared_ptr<T> Resolve(Graphics& gfx, Params&& ...p)noxnd
 	{
 		static_assert(std::is_base_of<Bindable, T>::value, "Can only resolve classes derived from Bindable");
 		return Get()._Resolve<T>(gfx, std::forward<Params>(p)...);
 	}
+	// what is resolved under key already, nullptr if nothing is or it is still being built;
+	// builds nothing, and only a find that returns something counts, as a hit
+	template<class T>
+	static std::shared_ptr<T> Find(const BindableKey& key) noexcept
+	{
+		static_assert(std::is_base_of<Bindable, T>::value, "Can only find classes derived from Bindable");
+		return Get()._Find<T>(key);
+	}
+	template<typename F>
+	static Lazy<std::decay_t<F>> Defer(F&& factory) noexcept
+	{
+		return { std::forward<F>(factory) };
+	}
+	// 0 means unbounded, otherwise the least recently resolved entries that nobody
+	// outside the codex holds are dropped once the footprint goes over budget
+	static void SetBudget(size_t bytes) noexcept;
+	// with no budget set this drops every entry that nobody outside the codex holds
+	static void Trim() noexcept;
+	static Stats GetStats() noexcept;
+private:
+	// slot is published before the bindable is built, so concurrent resolves
+	// of the same key wait on the one construction in flight instead of repeating it
+	using Slot = std::shared_future<std::shared_ptr<Bindable>>;
+	struct Entry
+	{
+		// only while the construction is in flight, hits after it take bind and never touch the future
+		Slot slot;
+		std::shared_ptr<Bindable> bind;
+		// keys are hashes, this is what tells a collision between two types from a hit
+		const std::type_info* pType;
+		size_t footprint = 0u;
+		// of the shard's clock
+		uint64_t lastUse;
+	};
+	// counters are kept per shard under its lock, a hit touches nothing shared with other shards
+	struct Shard
+	{
+		std::mutex mtx;
+		std::unordered_map<BindableKey, Entry, BindableKey::Hasher> binds;
+		uint64_t clock = 0u;
+		uint64_t hits = 0u;
+		uint64_t misses = 0u;
+		uint64_t evictions = 0u;
+	};
+	static constexpr size_t shardCount = 16u; // must match the 4 key bits used by GetShard
 private:
 	template<class T, typename ...Params>
 	std::shared_ptr<T> _Resolve(Graphics& gfx, Params&& ...p)noxnd
 	{
-		const auto key = T::GenerateUID(std::forward<Params>(p)...);
-		const auto i = binds.find(key);
-		if (i == binds.end())
+		const auto key = T::GenerateUID(p...);
+		auto& shard = GetShard(key);
+		std::promise<std::shared_ptr<Bindable>> promise;
+		{
+			std::unique_lock<std::mutex> lock(shard.mtx);
+			const auto i = shard.binds.find(key);
+			if (i != shard.binds.end())
+			{
+				auto& e = i->second;
+				if (*e.pType != typeid(T))
+				{
+					assert(false && "Codex key collision between two bindable types");
+					// casting the slot would hand out the wrong object, build one that isn't shared instead
+					lock.unlock();
+					return std::make_shared<T>(gfx, std::forward<Params>(p)...);
+				}
+				shard.hits++;
+				e.lastUse = shard.clock++;
+				if (e.bind != nullptr)
+				{
+					return std::static_pointer_cast<T>(e.bind);
+				}
+				// copy the slot out so we don't hold the shard while waiting on it
+				auto slot = e.slot;
+				lock.unlock();
+				return std::static_pointer_cast<T>(slot.get());
+			}
+			shard.misses++;
+			shard.binds.emplace(key, Entry{ promise.get_future().share(), nullptr, &typeid(T), 0u, shard.clock++ });
+		}
+		std::shared_ptr<T> bind;
+		try
+		{
+			bind = std::make_shared<T>(gfx, std::forward<Params>(p)...);
+		}
+		catch (...)
+		{
+			// failed construction must not poison the key, next resolve retries
+			{
+				std::lock_guard<std::mutex> lock(shard.mtx);
+				shard.binds.erase(key);
+			}
+			promise.set_exception(std::current_exception());
+			throw;
+		}
 		{
-			auto bind = std::make_shared<T>(gfx, std::forward<Params>(p)...);
-			binds[key] = bind;
-			return bind;
+			std::lock_guard<std::mutex> lock(shard.mtx);
+			auto& e = shard.binds.at(key);
+			e.bind = bind;
+			e.footprint = bind->GetFootprint();
+			// waiters copied it already, later hits go by bind
+			e.slot = {};
 		}
-		else
+		bytes += bind->GetFootprint();
+		promise.set_value(bind);
+		if (const size_t limit = budget; limit != 0u && bytes > limit)
 		{
-			return std::static_pointer_cast<T>(i->second);
+			Evict(limit);
 		}
+		return bind;
+	}
+	template<class T>
+	std::shared_ptr<T> _Find(const BindableKey& key) noexcept
+	{
+		auto& shard = GetShard(key);
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		const auto i = shard.binds.find(key);
+		if (i == shard.binds.end() || *i->second.pType != typeid(T) || i->second.bind == nullptr)
+		{
+			return nullptr;
+		}
+		shard.hits++;
+		i->second.lastUse = shard.clock++;
+		return std::static_pointer_cast<T>(i->second.bind);
+	}
+	void Evict(size_t target) noexcept;
+	static bool IsEvictable(const Entry& entry) noexcept;
+	Shard& GetShard(const BindableKey& key) noexcept
+	{
+		// top bits pick the shard, low bits are left for the bucket index
+		return shards[size_t(key.Value() >> 60)];
 	}
 	static Codex& Get()
 	{
@@ -36,5 +193,8 @@ private:
 		return codex;
 	}
 private:
-	std::unordered_map<std::string, std::shared_ptr<Bindable>> binds;
-};
\ No newline at end of file
+	std::array<Shard, shardCount> shards;
+	// only misses and evictions change these
+	std::atomic<size_t> bytes{ 0u };
+	std::atomic<size_t> budget{ 0u };
+};
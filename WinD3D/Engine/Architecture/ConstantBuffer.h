@@ -20,6 +20,7 @@ public:
 		cbd.MiscFlags = 0u;
 		cbd.ByteWidth = sizeof(consts);
 		cbd.StructureByteStride = 0u;
+		footprint = cbd.ByteWidth;
 
 		D3D11_SUBRESOURCE_DATA csd = {};
 		csd.pSysMem = &consts;
@@ -37,22 +38,14 @@ public:
 		cbd.MiscFlags = 0u;
 		cbd.ByteWidth = sizeof(C);
 		cbd.StructureByteStride = 0u;
+		footprint = cbd.ByteWidth;
 
 		GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&cbd, nullptr, &pConstantBuffer));
 	}
 public:
-	void Update(Graphics& gfx, const C& consts)
+	void Update(CommandStream& cmd, const C& consts) noexcept
 	{
-		INFOMAN(gfx);
-
-		D3D11_MAPPED_SUBRESOURCE msr = {};
-		GFX_THROW_INFO(GetContext(gfx)->Map(
-			pConstantBuffer.Get(), 0u,
-			D3D11_MAP_WRITE_DISCARD, 0u,
-			&msr
-		));
-		memcpy(msr.pData, &consts, sizeof(consts));
-		GetContext(gfx)->Unmap(pConstantBuffer.Get(), 0u);
+		cmd.UpdateBuffer(pConstantBuffer.Get(), &consts, sizeof(consts));
 	}
 protected:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> pConstantBuffer;
@@ -64,12 +57,11 @@ class VertexConstantBuffer : public ConstantBuffer<C>
 {
 	using ConstantBuffer<C>::pConstantBuffer;
 	using ConstantBuffer<C>::slot;
-	using Bindable::GetContext;
 public:
 	using ConstantBuffer<C>::ConstantBuffer;
-	void Bind(Graphics& gfx)noexcept override
+	void Bind(Graphics& gfx, CommandStream& cmd)noexcept override
 	{
-		GetContext(gfx)->VSSetConstantBuffers(slot, 1u, pConstantBuffer.GetAddressOf());
+		cmd.SetVertexConstantBuffer(slot, pConstantBuffer.Get());
 	}
 	static std::shared_ptr<VertexConstantBuffer> Resolve(Graphics& gfx, const C& consts, UINT slot = 0)
 	{
@@ -79,16 +71,15 @@ public:
 	{
 		return Codex::Resolve<VertexConstantBuffer>(gfx, slot);
 	}
-	static std::string GenerateUID(const C&, UINT slot)
+	static BindableKey GenerateUID(const C&, UINT slot)
 	{
 		return GenerateUID(slot);
 	}
-	static std::string GenerateUID(UINT slot = 0)
+	static BindableKey GenerateUID(UINT slot = 0)
 	{
-		using namespace std::string_literals;
-		return typeid(VertexConstantBuffer).name() + "#"s + std::to_string(slot);
+		return BindableKey::Of<VertexConstantBuffer>().Mix(slot);
 	}
-	std::string GetUID() const noexcept override
+	BindableKey GetUID() const noexcept override
 	{
 		return GenerateUID(slot);
 	}
@@ -99,12 +90,11 @@ class PixelConstantBuffer : public ConstantBuffer<C>
 {
 	using ConstantBuffer<C>::pConstantBuffer;
 	using ConstantBuffer<C>::slot;
-	using Bindable::GetContext;
 public:
 	using ConstantBuffer<C>::ConstantBuffer;
-	void Bind(Graphics& gfx)noexcept override
+	void Bind(Graphics& gfx, CommandStream& cmd)noexcept override
 	{
-		GetContext(gfx)->PSSetConstantBuffers(slot, 1u, pConstantBuffer.GetAddressOf());
+		cmd.SetPixelConstantBuffer(slot, pConstantBuffer.Get());
 	}
 	static std::shared_ptr<PixelConstantBuffer> Resolve(Graphics& gfx, const C& consts, UINT slot = 0)
 	{
@@ -114,16 +104,15 @@ public:
 	{
 		return Codex::Resolve<PixelConstantBuffer>(gfx, slot);
 	}
-	static std::string GenerateUID(const C&, UINT slot)
+	static BindableKey GenerateUID(const C&, UINT slot)
 	{
 		return GenerateUID(slot);
 	}
-	static std::string GenerateUID(UINT slot = 0)
+	static BindableKey GenerateUID(UINT slot = 0)
 	{
-		using namespace std::string_literals;
-		return typeid(PixelConstantBuffer).name() + "#"s + std::to_string(slot);
+		return BindableKey::Of<PixelConstantBuffer>().Mix(slot);
 	}
-	std::string GetUID() const noexcept override
+	BindableKey GetUID() const noexcept override
 	{
 		return GenerateUID(slot);
 	}
@@ -8,19 +8,10 @@
 class ConstantBufferEx : public Bindable
 {
 public:
-	void Update(Graphics& gfx, const DC::Buffer& buf)
+	void Update(CommandStream& cmd, const DC::Buffer& buf) noexcept
 	{
 		assert(&buf.GetRootLayoutElement() == &GetRootLayoutElement());
-		INFOMAN(gfx);
-
-		D3D11_MAPPED_SUBRESOURCE msr;
-		GFX_THROW_INFO(GetContext(gfx)->Map(
-			pConstantBuffer.Get(), 0u,
-			D3D11_MAP_WRITE_DISCARD, 0u,
-			&msr
-		));
-		memcpy(msr.pData, buf.GetData(), buf.GetSizeInBytes());
-		GetContext(gfx)->Unmap(pConstantBuffer.Get(), 0u);
+		cmd.UpdateBuffer(pConstantBuffer.Get(), buf.GetData(), buf.GetSizeInBytes());
 	}
 	// this exists for validation of the update buffer layout
 	// reason why it's not getbuffer is becasue nocache doesn't store buffer
@@ -39,6 +30,7 @@ protected:
 		cbd.MiscFlags = 0u;
 		cbd.ByteWidth = (UINT)layoutRoot.GetSizeInBytes();
 		cbd.StructureByteStride = 0u;
+		footprint = cbd.ByteWidth;
 
 		if (pBuf != nullptr)
 		{
@@ -60,9 +52,9 @@ class PixelConstantBufferEx : public ConstantBufferEx
 {
 public:
 	using ConstantBufferEx::ConstantBufferEx;
-	void Bind(Graphics& gfx) noexcept override
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override
 	{
-		GetContext(gfx)->PSSetConstantBuffers(slot, 1u, pConstantBuffer.GetAddressOf());
+		cmd.SetPixelConstantBuffer(slot, pConstantBuffer.Get());
 	}
 };
 
@@ -70,9 +62,9 @@ class VertexConstantBufferEx : public ConstantBufferEx
 {
 public:
 	using ConstantBufferEx::ConstantBufferEx;
-	void Bind(Graphics& gfx) noexcept override
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override
 	{
-		GetContext(gfx)->VSSetConstantBuffers(slot, 1u, pConstantBuffer.GetAddressOf());
+		cmd.SetVertexConstantBuffer(slot, pConstantBuffer.Get());
 	}
 };
 
@@ -103,14 +95,14 @@ public:
 		buf.CopyFrom(buf_in);
 		dirty = true;
 	}
-	void Bind(Graphics& gfx) noexcept override
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override
 	{
 		if (dirty)
 		{
-			T::Update(gfx, buf);
+			T::Update(cmd, buf);
 			dirty = false;
 		}
-		T::Bind(gfx);
+		T::Bind(gfx, cmd);
 	}
 	void Accept(TechniqueProbe& probe) override
 	{
@@ -3,11 +3,12 @@
 #include "GraphicsThrows.m"
 #include "Material.h"
 
-Drawable::Drawable(Graphics& gfx, const Material& mat, const aiMesh& mesh, float scale) noexcept
+Drawable::Drawable(Graphics& gfx, const Material& mat, std::shared_ptr<VertexBuffer> pVertices_in, std::shared_ptr<IndexBuffer> pIndices_in) noexcept
+	:
+	pIndices(std::move(pIndices_in)),
+	pVertices(std::move(pVertices_in)),
+	pTopology(mat.GetTopology())
 {
-	pVertices = mat.MakeVertexBindable(gfx, mesh, scale);
-	pIndices = mat.MakeIndexBindable(gfx, mesh);
-	pTopology = Topology::Resolve(gfx);
 
 	for (auto& t : mat.GetTechniques())
 	{
@@ -15,23 +16,51 @@ Drawable::Drawable(Graphics& gfx, const Material& mat, const aiMesh& mesh, float
 	}
 }
 
+Drawable::Drawable(Graphics& gfx, const Material& mat, std::shared_ptr<VertexBuffer> pVertices_in, std::shared_ptr<IndexBuffer> pIndices_in,
+	UINT startIndex_in, UINT indexCount_in, INT baseVertex_in) noexcept
+	:
+	Drawable(gfx, mat, std::move(pVertices_in), std::move(pIndices_in))
+{
+	startIndex = startIndex_in;
+	indexCount = indexCount_in;
+	baseVertex = baseVertex_in;
+}
+
+void Drawable::ShareBuffers(std::shared_ptr<VertexBuffer> pVertices_in, std::shared_ptr<IndexBuffer> pIndices_in,
+	UINT startIndex_in, UINT indexCount_in, INT baseVertex_in) noexcept
+{
+	pVertices = std::move(pVertices_in);
+	pIndices = std::move(pIndices_in);
+	startIndex = startIndex_in;
+	indexCount = indexCount_in;
+	baseVertex = baseVertex_in;
+}
+
 void Drawable::AddTechnique(Technique tech_in) noexcept
 {
 	tech_in.InitializeParentReferences(*this);
 	techniques.push_back(std::move(tech_in));
 }
+DirectX::XMMATRIX Drawable::GetTransformXM() const noexcept
+{
+	return DirectX::XMMatrixIdentity();
+}
 void Drawable::Submit(FrameCommander& frame) const noexcept
+{
+	Submit(frame, GetTransformXM());
+}
+void Drawable::Submit(FrameCommander& frame, DirectX::FXMMATRIX world) const noexcept
 {
 	for (const auto& tech : techniques)
 	{
-		tech.Submit(frame, *this);
+		tech.Submit(frame, *this, world);
 	}
 }
-void Drawable::Bind(Graphics& gfx) const noexcept
+void Drawable::Bind(Graphics& gfx, CommandStream& cmd) const noexcept
 {
-	pTopology->Bind(gfx);
-	pIndices->Bind(gfx);
-	pVertices->Bind(gfx);
+	pTopology->Bind(gfx, cmd);
+	pIndices->Bind(gfx, cmd);
+	pVertices->Bind(gfx, cmd);
 }
 void Drawable::Accept(TechniqueProbe& probe)
 {
@@ -42,5 +71,29 @@ void Drawable::Accept(TechniqueProbe& probe)
 }
 UINT Drawable::GetIndexCount() const noexcept(!IS_DEBUG)
 {
-	return pIndices->GetCount();
+	return indexCount != ~0u ? indexCount : pIndices->GetCount();
+}
+UINT Drawable::GetStartIndex() const noexcept
+{
+	return startIndex;
+}
+INT Drawable::GetBaseVertex() const noexcept
+{
+	return baseVertex;
+}
+const VertexBuffer* Drawable::GetVertexBuffer() const noexcept
+{
+	return pVertices.get();
+}
+const IndexBuffer* Drawable::GetIndexBuffer() const noexcept
+{
+	return pIndices.get();
+}
+void Drawable::SetDecode(DirectX::FXMMATRIX decode_in) noexcept
+{
+	DirectX::XMStoreFloat4x4(&decode, decode_in);
+}
+DirectX::XMMATRIX Drawable::GetDecodeXM() const noexcept
+{
+	return DirectX::XMLoadFloat4x4(&decode);
 }
\ No newline at end of file
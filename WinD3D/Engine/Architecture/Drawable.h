@@ -9,20 +9,47 @@ class Drawable
 {
 public:
 	Drawable() = default;
-	Drawable(Graphics& gfx, const class Material& mat, const struct aiMesh& mesh, float scale = 1.0f) noexcept;
+	// buffers made elsewhere, e.g. a level of detail sharing its mesh's vertices
+	Drawable(Graphics& gfx, const class Material& mat, std::shared_ptr<class VertexBuffer> pVertices, std::shared_ptr<class IndexBuffer> pIndices) noexcept;
+	// a range of buffers shared with other drawables, e.g. one mesh of a static batch
+	Drawable(Graphics& gfx, const class Material& mat, std::shared_ptr<class VertexBuffer> pVertices, std::shared_ptr<class IndexBuffer> pIndices,
+		UINT startIndex, UINT indexCount, INT baseVertex) noexcept;
 	Drawable(const Drawable&) = delete;
 public:
-	virtual DirectX::XMMATRIX GetTransformXM() const noexcept = 0;
+	// where Submit without a transform draws it, drawables placed by their owner keep the identity
+	virtual DirectX::XMMATRIX GetTransformXM() const noexcept;
 	virtual ~Drawable() = default;
 public:
 	void AddTechnique(Technique tech_in) noexcept;
 	void Submit(class FrameCommander& frame) const noexcept;
-	void Bind(Graphics& gfx)const noexcept;
+	void Submit(class FrameCommander& frame, DirectX::FXMMATRIX world) const noexcept;
+	void Bind(Graphics& gfx, CommandStream& cmd)const noexcept;
 	void Accept(TechniqueProbe& probe);
 	UINT GetIndexCount()const noxnd;
+	UINT GetStartIndex() const noexcept;
+	INT GetBaseVertex() const noexcept;
+	const class VertexBuffer* GetVertexBuffer() const noexcept;
+	const class IndexBuffer* GetIndexBuffer() const noexcept;
+	// from what the vertex buffer holds to the space the drawable is placed from (e.g. dequantizing
+	// positions); transforms apply it ahead of anything they do in that space and the world matrix
+	void SetDecode(DirectX::FXMMATRIX decode_in) noexcept;
+	// moves the drawable onto a range of buffers shared with others, letting go of its own
+	void ShareBuffers(std::shared_ptr<class VertexBuffer> pVertices_in, std::shared_ptr<class IndexBuffer> pIndices_in,
+		UINT startIndex_in, UINT indexCount_in, INT baseVertex_in) noexcept;
+	DirectX::XMMATRIX GetDecodeXM() const noexcept;
 protected:
 	std::shared_ptr<class IndexBuffer> pIndices;
 	std::shared_ptr<class VertexBuffer> pVertices;
 	std::shared_ptr<class Topology> pTopology;
 	std::vector<Technique> techniques;
+	UINT startIndex = 0u;
+	// ~0u draws the whole index buffer
+	UINT indexCount = ~0u;
+	INT baseVertex = 0;
+	DirectX::XMFLOAT4X4 decode = {
+		1.0f,0.0f,0.0f,0.0f,
+		0.0f,1.0f,0.0f,0.0f,
+		0.0f,0.0f,1.0f,0.0f,
+		0.0f,0.0f,0.0f,1.0f
+	};
 };
\ No newline at end of file
@@ -1,35 +1,89 @@
 #pragma once
-#include <array>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <chrono>
 #include "BindableCommons.h"
 #include "NullPixelShader.h"
 #include <Engine/Graphics.h>
 #include "Job.h"
 #include "Pass.h"
-//#include "PerfLog.h"
+#include "RenderGraph.h"
+#include <Framework/PerfLog.h>
+#include <Framework/WorkerPool.h>
 
 class FrameCommander
 {
 public:
-	void Accept(Job job, size_t target) noexcept
+	struct Stats
 	{
-		passes[target].Accept(job);
-	}
-	void Execute(Graphics& gfx) const noxnd
+		size_t commands = 0u;
+		float recordSeconds = 0.0f;
+		float replaySeconds = 0.0f;
+	};
+public:
+	// pass-constant bindables are resolved once here, Execute only dereferences them
+	FrameCommander(Graphics& gfx)
 	{
-		// normally this would be a loop with each pass defining it setup / etc.
-		// and later on it would be a complex graph with parallel execution contingent
-		// on input / output requirements
-
 		// main phong lighting pass
-		Stencil::Resolve(gfx, Stencil::Mode::Off)->Bind(gfx);
-		passes[0].Execute(gfx);
+		AddPass("phong", {}, { "color","depth" }, Pass::Sorting::State)
+			.AddBindable(Stencil::Resolve(gfx, Stencil::Mode::Off));
 		// outline masking pass
-		Stencil::Resolve(gfx, Stencil::Mode::Write)->Bind(gfx);
-		NullPixelShader::Resolve(gfx)->Bind(gfx);
-		passes[1].Execute(gfx);
+		auto& mask = AddPass("outlineMask", {}, { "stencil" }, Pass::Sorting::State);
+		mask.AddBindable(Stencil::Resolve(gfx, Stencil::Mode::Write));
+		mask.AddBindable(NullPixelShader::Resolve(gfx));
 		// outline drawing pass
-		Stencil::Resolve(gfx, Stencil::Mode::Mask)->Bind(gfx);
-		passes[2].Execute(gfx);
+		AddPass("outlineDraw", { "stencil" }, { "color" }, Pass::Sorting::State)
+			.AddBindable(Stencil::Resolve(gfx, Stencil::Mode::Mask));
+
+		graph.AddOutput("color");
+		graph.Compile();
+		hasWork.resize(passes.size());
+		// a helper per pass beyond the first, started once instead of every frame
+		const auto threadCount = std::min(passes.size(), size_t(std::max(std::thread::hardware_concurrency(), 1u)));
+		pRecorders = std::make_unique<WorkerPool>(unsigned(threadCount - 1u));
+	}
+	void Accept(Job job, RenderGraph::PassId target) noexcept
+	{
+		const auto i = graph.Find(target);
+		assert(i != RenderGraph::npos && "Job submitted to a pass that is not registered");
+		if (i != RenderGraph::npos)
+		{
+			passes[i].Accept(job);
+		}
+	}
+	void Execute(Graphics& gfx) noxnd
+	{
+		// passes with no work, or whose output nobody reads, are culled (e.g. both outline
+		// passes when no outline technique is active)
+		for (size_t i = 0; i < passes.size(); i++)
+		{
+			hasWork[i] = passes[i].HasJobs();
+		}
+		lastSchedule = graph.Schedule(hasWork);
+
+		// passes record independently on this thread and the recorders;
+		// replay then happens in schedule order on the immediate context
+		using Clock = std::chrono::steady_clock;
+		const auto recordStart = Clock::now();
+		pRecorders->Run(lastSchedule.size(), [this, &gfx](size_t n)
+		{
+			const auto i = lastSchedule[n];
+			PERF_SCOPE_CAT(GetPassName(i).c_str(), "record");
+			passes[i].Record(gfx);
+		});
+		const auto replayStart = Clock::now();
+		stats.commands = 0u;
+		for (const auto i : lastSchedule)
+		{
+			PERF_SCOPE_CAT(GetPassName(i).c_str(), "replay");
+			gfx.Execute(passes[i].GetCommands());
+			stats.commands += passes[i].GetCommands().GetCommandCount();
+		}
+		stats.recordSeconds = std::chrono::duration<float>(replayStart - recordStart).count();
+		stats.replaySeconds = std::chrono::duration<float>(Clock::now() - replayStart).count();
 	}
 	void Reset() noexcept
 	{
@@ -38,6 +92,37 @@ public:
 			p.Reset();
 		}
 	}
+	const Pass::Stats& GetPassStats(size_t pass) const noexcept
+	{
+		return passes[pass].GetStats();
+	}
+	const Stats& GetStats() const noexcept
+	{
+		return stats;
+	}
+	size_t GetPassCount() const noexcept
+	{
+		return passes.size();
+	}
+	const std::string& GetPassName(size_t pass) const noexcept
+	{
+		return graph.GetPassName(pass);
+	}
+	bool WasPassExecuted(size_t pass) const noexcept
+	{
+		return std::find(lastSchedule.begin(), lastSchedule.end(), pass) != lastSchedule.end();
+	}
+private:
+	Pass& AddPass(std::string name, std::vector<std::string> reads, std::vector<std::string> writes, Pass::Sorting sorting)
+	{
+		graph.AddPass(std::move(name), std::move(reads), std::move(writes));
+		return passes.emplace_back(sorting);
+	}
 private:
-	std::array<Pass, 3> passes;
-};
\ No newline at end of file
+	RenderGraph graph;
+	std::vector<Pass> passes;
+	std::vector<bool> hasWork;
+	std::vector<size_t> lastSchedule;
+	std::unique_ptr<WorkerPool> pRecorders;
+	Stats stats;
+};
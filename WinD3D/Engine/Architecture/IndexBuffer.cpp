@@ -1,38 +1,72 @@
 #include "IndexBuffer.h"
 #include "GraphicsThrows.m"
 #include <Engine/Architecture/Codex.h>
+#include <algorithm>
 
 IndexBuffer::IndexBuffer(Graphics& gfx, const std::vector<unsigned short>& indices)
 	:
 	IndexBuffer(gfx, "?", indices)
 {}
+IndexBuffer::IndexBuffer(Graphics& gfx, const std::vector<uint32_t>& indices)
+	:
+	IndexBuffer(gfx, "?", indices)
+{}
 IndexBuffer::IndexBuffer(Graphics& gfx, std::string tag, const std::vector<unsigned short>& indices)
 	:
 	tag(tag),
-	count((UINT)indices.size())
+	count((UINT)indices.size()),
+	indexSize(sizeof(unsigned short))
+{
+	Create(gfx, indices.data(), DXGI_FORMAT_R16_UINT);
+}
+IndexBuffer::IndexBuffer(Graphics& gfx, std::string tag, const std::vector<uint32_t>& indices)
+	:
+	tag(tag),
+	count((UINT)indices.size()),
+	indexSize(sizeof(uint32_t))
+{
+	if (indices.empty() || *std::max_element(indices.begin(), indices.end()) <= 0xFFFFu)
+	{
+		const std::vector<unsigned short> narrowed(indices.begin(), indices.end());
+		Create(gfx, narrowed.data(), DXGI_FORMAT_R16_UINT);
+	}
+	else
+	{
+		Create(gfx, indices.data(), DXGI_FORMAT_R32_UINT);
+	}
+}
+
+void IndexBuffer::Create(Graphics& gfx, const void* pIndices, DXGI_FORMAT format_in)
 {
 	INFOMAN(gfx);
 
+	format = format_in;
+	const UINT stride = format == DXGI_FORMAT_R32_UINT ? 4u : 2u;
 	D3D11_BUFFER_DESC ibd = {};
 	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	ibd.Usage = D3D11_USAGE_DEFAULT;
 	ibd.CPUAccessFlags = 0u;
 	ibd.MiscFlags = 0u;
-	ibd.ByteWidth = UINT(count * sizeof(unsigned short));
-	ibd.StructureByteStride = sizeof(unsigned short);
+	ibd.ByteWidth = count * stride;
+	ibd.StructureByteStride = stride;
+	footprint = ibd.ByteWidth;
 	D3D11_SUBRESOURCE_DATA isd = {};
-	isd.pSysMem = indices.data();
+	isd.pSysMem = pIndices;
 	GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&ibd, &isd, &pIndexBuffer));
 }
 
-void IndexBuffer::Bind(Graphics& gfx)noexcept
+void IndexBuffer::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->IASetIndexBuffer(pIndexBuffer.Get(), DXGI_FORMAT::DXGI_FORMAT_R16_UINT, 0u);
+	cmd.SetIndexBuffer(pIndexBuffer.Get(), format);
 }
 UINT IndexBuffer::GetCount()const noexcept
 {
 	return count;
 }
+DXGI_FORMAT IndexBuffer::GetFormat() const noexcept
+{
+	return format;
+}
 
 std::shared_ptr<IndexBuffer> IndexBuffer::Resolve(Graphics& gfx, const std::string& tag,
 	const std::vector<unsigned short>& indices)
@@ -40,12 +74,21 @@ std::shared_ptr<IndexBuffer> IndexBuffer::Resolve(Graphics& gfx, const std::stri
 	assert(tag != "?");
 	return Codex::Resolve<IndexBuffer>(gfx, tag, indices);
 }
-std::string IndexBuffer::GenerateUID_(const std::string& tag)
+std::shared_ptr<IndexBuffer> IndexBuffer::Resolve(Graphics& gfx, const std::string& tag,
+	const std::vector<uint32_t>& indices)
+{
+	assert(tag != "?");
+	return Codex::Resolve<IndexBuffer>(gfx, tag, indices);
+}
+std::shared_ptr<IndexBuffer> IndexBuffer::Find(const std::string& tag, size_t indexSize) noexcept
+{
+	return Codex::Find<IndexBuffer>(GenerateUID_(tag, indexSize));
+}
+BindableKey IndexBuffer::GenerateUID_(const std::string& tag, size_t indexSize)
 {
-	using namespace std::string_literals;
-	return typeid(IndexBuffer).name() + "#"s + tag;
+	return BindableKey::Of<IndexBuffer>().Mix(tag).Mix(uint32_t(indexSize));
 }
-std::string IndexBuffer::GetUID() const noexcept
+BindableKey IndexBuffer::GetUID() const noexcept
 {
-	return GenerateUID_(tag);
+	return GenerateUID_(tag, indexSize);
 }
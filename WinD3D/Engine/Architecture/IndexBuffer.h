@@ -1,29 +1,63 @@
 #pragma once
 #include <Engine/Architecture/Bindable.h>
+#include <Engine/Architecture/Codex.h>
 #include <memory>
+#include <cstdint>
 
+// 16 bit indices stay 16 bit; 32 bit ones are narrowed to 16 when the highest index fits,
+// so only meshes past 65536 vertices pay for the wide format
 class IndexBuffer : public Bindable
 {
 public:
 	IndexBuffer(Graphics& gfx, const std::vector<unsigned short>& indices);
+	IndexBuffer(Graphics& gfx, const std::vector<uint32_t>& indices);
 	IndexBuffer(Graphics& gfx, std::string tag, const std::vector<unsigned short>& indices);
+	IndexBuffer(Graphics& gfx, std::string tag, const std::vector<uint32_t>& indices);
 public:
-	void Bind(Graphics& gfx) noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
 	UINT GetCount() const noexcept;
+	DXGI_FORMAT GetFormat() const noexcept;
 
 	static std::shared_ptr<IndexBuffer> Resolve(Graphics& gfx, const std::string& tag,
 		const std::vector<unsigned short>& indices);
+	static std::shared_ptr<IndexBuffer> Resolve(Graphics& gfx, const std::string& tag,
+		const std::vector<uint32_t>& indices);
+	// makeIndices is only called if nothing is cached under tag yet
+	template<typename F, typename = std::enable_if_t<
+		std::is_same_v<std::invoke_result_t<F&>, std::vector<unsigned short>> ||
+		std::is_same_v<std::invoke_result_t<F&>, std::vector<uint32_t>>>>
+	static std::shared_ptr<IndexBuffer> Resolve(Graphics& gfx, const std::string& tag, F&& makeIndices)
+	{
+		assert(tag != "?");
+		return Codex::Resolve<IndexBuffer>(gfx, tag, Codex::Defer(std::forward<F>(makeIndices)));
+	}
+	// what is cached under tag for indices indexSize bytes wide, nullptr if nothing is
+	static std::shared_ptr<IndexBuffer> Find(const std::string& tag, size_t indexSize) noexcept;
 
-	template<typename...Ignore>
-	static std::string GenerateUID(const std::string& tag, Ignore&&...ignore)
+	// the index width asked for is part of the key, a tag resolved both ways gets two buffers
+	template<typename Indices, typename...Ignore>
+	static BindableKey GenerateUID(const std::string& tag, const Indices& indices, Ignore&&...ignore)
 	{
-		return GenerateUID_(tag);
+		return GenerateUID_(tag, IndexSize<Indices>::value);
 	}
-	std::string GetUID() const noexcept override;
+	BindableKey GetUID() const noexcept override;
 private:
-	static std::string GenerateUID_(const std::string& tag);
+	template<typename Indices>
+	struct IndexSize
+	{
+		static constexpr size_t value = sizeof(typename Indices::value_type);
+	};
+	template<typename F>
+	struct IndexSize<Codex::Lazy<F>>
+	{
+		static constexpr size_t value = sizeof(typename std::invoke_result_t<F&>::value_type);
+	};
+	void Create(Graphics& gfx, const void* pIndices, DXGI_FORMAT format_in);
+	static BindableKey GenerateUID_(const std::string& tag, size_t indexSize);
 protected:
 	std::string tag;
 	UINT count;
+	size_t indexSize;
+	DXGI_FORMAT format = DXGI_FORMAT_R16_UINT;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> pIndexBuffer;
-};
\ No newline at end of file
+};
@@ -17,11 +17,11 @@ InputLayout::InputLayout(Graphics & gfx, DV::VertexLayout layout_in, ID3DBlob *
 	));
 }
 
-void InputLayout::Bind(Graphics& gfx) noexcept
+void InputLayout::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->IASetInputLayout(pInputLayout.Get());
+	cmd.SetInputLayout(pInputLayout.Get());
 }
-std::string InputLayout::GetUID() const noexcept
+BindableKey InputLayout::GetUID() const noexcept
 {
 	return GenerateUID(layout);
 }
@@ -29,11 +29,10 @@ std::string InputLayout::GetUID() const noexcept
 std::shared_ptr<InputLayout> InputLayout::Resolve(Graphics& gfx,
 	const DV::VertexLayout& layout, ID3DBlob* pVertexShaderBytecode)
 {
-	return Codex::Resolve<InputLayout>(gfx, layout, pVertexShaderBytecode);;
+	return Codex::Resolve<InputLayout>(gfx, layout, pVertexShaderBytecode);
 }
 
-std::string InputLayout::GenerateUID(const DV::VertexLayout& layout, ID3DBlob* pVertexShaderBytecode)
+BindableKey InputLayout::GenerateUID(const DV::VertexLayout& layout, ID3DBlob* pVertexShaderBytecode)
 {
-	using namespace std::string_literals;
-	return typeid(InputLayout).name() + "#"s + layout.GetCode();
+	return BindableKey::Of<InputLayout>().Mix(layout.GetCode());
 }
@@ -9,12 +9,12 @@ public:
 		DV::VertexLayout layout,
 		ID3DBlob* pVertexShaderBytecode);
 public:
-	void Bind(Graphics& gfx) noexcept override;
-	std::string GetUID()const noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
+	BindableKey GetUID()const noexcept override;
 public:
 	static std::shared_ptr<InputLayout> Resolve(Graphics& gfx,
 		const DV::VertexLayout& layout, ID3DBlob* pVertexShaderBytecode);
-	static std::string GenerateUID(const DV::VertexLayout& layout, ID3DBlob* pVertexShaderBytecode = nullptr);
+	static BindableKey GenerateUID(const DV::VertexLayout& layout, ID3DBlob* pVertexShaderBytecode = nullptr);
 protected:
 	DV::VertexLayout layout;
 	Microsoft::WRL::ComPtr<ID3D11InputLayout> pInputLayout;
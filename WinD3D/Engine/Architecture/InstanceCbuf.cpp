@@ -0,0 +1,60 @@
+#include "InstanceCbuf.h"
+#include "GraphicsThrows.m"
+#include <Engine/Architecture/Codex.h>
+#include <Engine/Architecture/TransformCBuf.h>
+#include "Job.h"
+#include "Drawable.h"
+
+InstanceCbuf::InstanceCbuf(Graphics& gfx, UINT slot)
+	:
+	slot(slot)
+{
+	INFOMAN(gfx);
+
+	D3D11_BUFFER_DESC cbd = {};
+	cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	cbd.Usage = D3D11_USAGE_DYNAMIC;
+	cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	cbd.MiscFlags = 0u;
+	cbd.ByteWidth = UINT(sizeof(TransformCbuf::Transforms) * maxInstances);
+	cbd.StructureByteStride = 0u;
+	footprint = cbd.ByteWidth;
+
+	GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&cbd, nullptr, &pConstantBuffer));
+}
+
+void InstanceCbuf::Bind(Graphics& gfx, CommandStream& cmd) noexcept
+{
+	cmd.SetVertexConstantBuffer(slot, pConstantBuffer.Get());
+}
+void InstanceCbuf::Update(Graphics& gfx, CommandStream& cmd, const Job* pJobs, size_t count) const noexcept
+{
+	assert(count <= maxInstances);
+	namespace dx = DirectX;
+	const auto camera = gfx.GetCamera();
+	const auto viewProj = camera * gfx.GetProjection();
+	// only the used prefix is uploaded, the rest of the buffer is left undefined
+	auto pTransforms = static_cast<TransformCbuf::Transforms*>(
+		cmd.UpdateBuffer(pConstantBuffer.Get(), sizeof(TransformCbuf::Transforms) * count));
+	for (size_t i = 0; i < count; i++)
+	{
+		const auto model = pJobs[i].GetDrawable().GetDecodeXM() * pJobs[i].GetTransformXM();
+		pTransforms[i] = {
+			dx::XMMatrixTranspose(model * camera),
+			dx::XMMatrixTranspose(model * viewProj)
+		};
+	}
+}
+BindableKey InstanceCbuf::GetUID() const noexcept
+{
+	return GenerateUID(slot);
+}
+
+std::shared_ptr<InstanceCbuf> InstanceCbuf::Resolve(Graphics& gfx, UINT slot)
+{
+	return Codex::Resolve<InstanceCbuf>(gfx, slot);
+}
+BindableKey InstanceCbuf::GenerateUID(UINT slot)
+{
+	return BindableKey::Of<InstanceCbuf>().Mix(slot);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <Engine/Architecture/Bindable.h>
+#include <memory>
+
+// transforms of a whole run of jobs in one vertex constant buffer, read by the
+// *_Inst_VS shaders through SV_InstanceID
+class InstanceCbuf : public Bindable
+{
+public:
+	// must match the array size in InstanceTransform.hlsli
+	static constexpr size_t maxInstances = 256u;
+public:
+	InstanceCbuf(Graphics& gfx, UINT slot = 0u);
+public:
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
+	// records the transforms of count jobs (at most maxInstances) for the next instanced draw
+	void Update(Graphics& gfx, CommandStream& cmd, const class Job* pJobs, size_t count) const noexcept;
+	BindableKey GetUID() const noexcept override;
+public:
+	static std::shared_ptr<InstanceCbuf> Resolve(Graphics& gfx, UINT slot = 0u);
+	static BindableKey GenerateUID(UINT slot = 0u);
+private:
+	UINT slot;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> pConstantBuffer;
+};
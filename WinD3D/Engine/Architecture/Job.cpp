@@ -1,18 +1,62 @@
 #include "Job.h"
 #include "Step.h"
 #include "Drawable.h"
+#include "InstanceCbuf.h"
 
-Job::Job(const Step* pStep, const Drawable* pDrawable)
+Job::Job(const Step* pStep, const Drawable* pDrawable, DirectX::FXMMATRIX world_in) noexcept
 	:
 	pDrawable{ pDrawable },
-	pStep{ pStep }
+	pStep{ pStep },
+	stateKey{ pStep->GetStateKey() | StateKey::Reduce(uint64_t(pDrawable->GetVertexBuffer()), 12u) << StateKey::vbShift }
 {
-
+	DirectX::XMStoreFloat4x4(&world, world_in);
 }
 
-void Job::Execute(Graphics& gfx) const noexcept(!IS_DEBUG)
+void Job::Record(Graphics& gfx, CommandStream& cmd) const noexcept
+{
+	pDrawable->Bind(gfx, cmd);
+	pStep->Bind(gfx, cmd, GetTransformXM());
+	cmd.DrawIndexed(pDrawable->GetIndexCount(), pDrawable->GetStartIndex(), pDrawable->GetBaseVertex());
+}
+bool Job::CanInstanceWith(const Job& other) const noexcept
+{
+	return pStep->IsInstanced() &&
+		pDrawable->GetVertexBuffer() == other.pDrawable->GetVertexBuffer() &&
+		pDrawable->GetIndexBuffer() == other.pDrawable->GetIndexBuffer() &&
+		pDrawable->GetStartIndex() == other.pDrawable->GetStartIndex() &&
+		pDrawable->GetBaseVertex() == other.pDrawable->GetBaseVertex() &&
+		pDrawable->GetIndexCount() == other.pDrawable->GetIndexCount() &&
+		pStep->SharesStateWith(*other.pStep);
+}
+void Job::RecordInstanced(Graphics& gfx, CommandStream& cmd, const Job* pJobs, size_t count) noexcept
+{
+	const auto& step = *pJobs->pStep;
+	pJobs->pDrawable->Bind(gfx, cmd);
+	step.BindInstanced(gfx, cmd);
+	step.GetInstances().Update(gfx, cmd, pJobs, count);
+	cmd.DrawIndexedInstanced(pJobs->pDrawable->GetIndexCount(), UINT(count), pJobs->pDrawable->GetStartIndex(), pJobs->pDrawable->GetBaseVertex());
+}
+uint64_t Job::GetStateKey() const noexcept
+{
+	return stateKey;
+}
+uint64_t Job::GetSortKey() const noexcept
+{
+	return sortKey;
+}
+void Job::SetSortKey(uint64_t key) noexcept
+{
+	sortKey = key;
+}
+const Drawable& Job::GetDrawable() const noexcept
+{
+	return *pDrawable;
+}
+const Step& Job::GetStep() const noexcept
+{
+	return *pStep;
+}
+DirectX::XMMATRIX Job::GetTransformXM() const noexcept
 {
-	pDrawable->Bind(gfx);
-	pStep->Bind(gfx);
-	gfx.DrawIndexed(pDrawable->GetIndexCount());
+	return DirectX::XMLoadFloat4x4(&world);
 }
@@ -1,12 +1,44 @@
 #pragma once
 #include <Framework/noexcept_if.h>
+#include <DirectXMath.h>
+#include <cstdint>
 
 class Job
 {
 public:
-	Job(const class Step* pStep, const class Drawable* pDrawable);
-	void Execute(class Graphics& gfx) const noxnd;
+	// packed identity of the render state a job binds, most expensive switch in the high bits
+	// [ vertex shader:12 | pixel shader:12 | textures:16 | other state:12 | vertex buffer:12 ]
+	struct StateKey
+	{
+		static constexpr unsigned vsShift = 52u;
+		static constexpr unsigned psShift = 40u;
+		static constexpr unsigned texShift = 24u;
+		static constexpr unsigned miscShift = 12u;
+		static constexpr unsigned vbShift = 0u;
+		// fibonacci hash of an identity down to its field width
+		static constexpr uint64_t Reduce(uint64_t identity, unsigned bits) noexcept
+		{
+			return (identity * 0x9E3779B97F4A7C15ull) >> (64u - bits);
+		}
+	};
+public:
+	// the job carries its own world matrix, so one drawable can be submitted many times a frame
+	Job(const class Step* pStep, const class Drawable* pDrawable, DirectX::FXMMATRIX world) noexcept;
+	void Record(class Graphics& gfx, class CommandStream& cmd) const noexcept;
+	// true if both jobs draw the same geometry, the same range of the same buffers, with the same instanced step state
+	bool CanInstanceWith(const Job& other) const noexcept;
+	// one instanced draw for count jobs that can all instance with the first
+	static void RecordInstanced(class Graphics& gfx, class CommandStream& cmd, const Job* pJobs, size_t count) noexcept;
+	uint64_t GetStateKey() const noexcept;
+	uint64_t GetSortKey() const noexcept;
+	void SetSortKey(uint64_t key) noexcept;
+	const class Drawable& GetDrawable() const noexcept;
+	const class Step& GetStep() const noexcept;
+	DirectX::XMMATRIX GetTransformXM() const noexcept;
 private:
+	DirectX::XMFLOAT4X4 world;
 	const class Drawable* pDrawable;
 	const class Step* pStep;
-};
\ No newline at end of file
+	uint64_t stateKey;
+	uint64_t sortKey = 0u;
+};
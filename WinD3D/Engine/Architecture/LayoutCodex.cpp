@@ -5,7 +5,9 @@ namespace DC
 	CookedLayout LayoutCodex::Resolve(RawLayout&& layout) noxnd
 	{
 		auto sig = layout.GetSignature();
-		auto& map = Get().map;
+		auto& codex = Get();
+		std::lock_guard<std::mutex> lock(codex.mutex);
+		auto& map = codex.map;
 		const auto i = map.find(sig);
 		// idential layout already exists
 		if (i != map.end())
@@ -3,6 +3,7 @@
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <mutex>
 
 namespace DC
 {
@@ -13,6 +14,8 @@ namespace DC
 	private:
 		static LayoutCodex& Get() noexcept;
 	private:
+		// materials are built on several threads at once
+		std::mutex mutex;
 		std::unordered_map<std::string, std::shared_ptr<DC::LayoutElement>> map;
 	};
 }
\ No newline at end of file
@@ -4,25 +4,24 @@
 #include <Assimp/types.h>
 
 Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesystem::path& path) noxnd
-	:modelPath(path.string())
+	:
+	Material(gfx, Describe(material), path)
+{}
+
+Material::Material(Graphics& gfx, Description description_in, const std::filesystem::path& path) noxnd
+	:
+	description(std::move(description_in)),
+	vtxLayout(MakeVertexLayout(description)),
+	modelPath(path.string()),
+	name(description.name),
+	pTopology(Topology::Resolve(gfx))
 {
 	const auto rootPath = path.parent_path().string() + "\\";
-	{
-		aiString tempName;
-		material.Get(AI_MATKEY_NAME, tempName);
-		name = tempName.C_Str();
-	}
 	// phong technique
 	{
 		Technique phong{ "Phong" };
-		Step step(0);
+		Step step("phong");
 		std::string shaderCode = "Phong";
-		aiString texFileName;
-
-		// common (pre)
-		vtxLayout
-			+ DV::Type::Position3D
-			+ DV::Type::Normal;
 
 		DC::RawLayout pscLayout;
 		bool hasTexture = false;
@@ -31,16 +30,15 @@ Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesys
 		// diffuse
 		{
 			bool hasAlpha = false;
-			if (material.GetTexture(aiTextureType_DIFFUSE, 0, &texFileName) == aiReturn_SUCCESS)
+			if (!description.diffuseMap.empty())
 			{
 				hasTexture = true;
 				shaderCode += "Dif";
-				vtxLayout 
-					+ DV::Type::Texture2D;
-				auto tex = Texture::Resolve(gfx, rootPath + texFileName.C_Str());
+				auto tex = Texture::Resolve(gfx, rootPath + description.diffuseMap);
 				if (tex->UsesAlpha())
 				{
 					hasAlpha = true;
+					masked = true;
 					shaderCode += "Msk";
 				}
 				step.AddBindable(std::move(tex));
@@ -53,13 +51,11 @@ Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesys
 		}
 		// specular
 		{
-			if (material.GetTexture(aiTextureType_SPECULAR, 0, &texFileName) == aiReturn_SUCCESS)
+			if (!description.specularMap.empty())
 			{
 				hasTexture = true;
 				shaderCode += "Spc";
-				vtxLayout
-					+(DV::Type::Texture2D);
-				auto tex = Texture::Resolve(gfx, rootPath + texFileName.C_Str(), 1);
+				auto tex = Texture::Resolve(gfx, rootPath + description.specularMap, 1);
 				hasGlossAlpha = tex->UsesAlpha();
 				step.AddBindable(std::move(tex));
 				pscLayout.Add(
@@ -77,15 +73,11 @@ Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesys
 		}
 		// normal
 		{
-			if (material.GetTexture(aiTextureType_NORMALS, 0, &texFileName) == aiReturn_SUCCESS)
+			if (!description.normalMap.empty())
 			{
 				hasTexture = true;
 				shaderCode += "Nrm";
-				vtxLayout
-					+ (DV::Type::Texture2D)
-					+ (DV::Type::Tangent)
-					+ (DV::Type::Bitangent);
-				step.AddBindable(Texture::Resolve(gfx, rootPath + texFileName.C_Str(), 2));
+				step.AddBindable(Texture::Resolve(gfx, rootPath + description.normalMap, 2));
 				pscLayout.Add({ 
 					{DC::Type::Bool, "useNormalMap"},
 					{DC::Type::Float, "normalMapWeight"}
@@ -99,6 +91,7 @@ Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesys
 			auto pvs = VertexShader::Resolve(gfx, shaderCode + "_VS.cso");
 			auto pvsbc = pvs->GetBytecode();
 			step.AddBindable(std::move(pvs));
+			step.EnableInstancing(gfx, shaderCode + "_Inst_VS.cso");
 			step.AddBindable(PixelShader::Resolve(gfx, shaderCode + "_PS.cso"));
 			step.AddBindable(InputLayout::Resolve(gfx, vtxLayout, pvsbc));
 			if (hasTexture)
@@ -107,27 +100,12 @@ Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesys
 			}
 			// PS material params (cbuf)
 			DC::Buffer buf{ std::move(pscLayout) };
-			if (auto r = buf["materialColor"]; r.Exists())
-			{
-				aiColor3D color = { 0.45f,0.45f,0.85f };
-				material.Get(AI_MATKEY_COLOR_DIFFUSE, color);
-				r = reinterpret_cast<DirectX::XMFLOAT3&>(color);
-			}
+			buf["materialColor"].SetIfExists(description.diffuseColor);
 			buf["useGlossAlpha"].SetIfExists(hasGlossAlpha);
 			buf["useSpecularMap"].SetIfExists(true);
-			if (auto r = buf["specularColor"]; r.Exists())
-			{
-				aiColor3D color = { 0.18f,0.18f,0.18f };
-				material.Get(AI_MATKEY_COLOR_SPECULAR, color);
-				r = reinterpret_cast<DirectX::XMFLOAT3&>(color);
-			}
+			buf["specularColor"].SetIfExists(description.specularColor);
 			buf["specularWeight"].SetIfExists(1.0f);
-			if (auto r = buf["specularGloss"]; r.Exists())
-			{
-				float gloss = 8.0f;
-				material.Get(AI_MATKEY_SHININESS, gloss);
-				r = gloss;
-			}
+			buf["specularGloss"].SetIfExists(description.shininess);
 			buf["useNormalMap"].SetIfExists(true);
 			buf["normalMapWeight"].SetIfExists(1.0f);
 			step.AddBindable(std::make_unique<CachingPixelConstantBufferEx>(gfx, std::move(buf), 1u));
@@ -139,7 +117,7 @@ Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesys
 	{
 		Technique outline("Outline", false);
 		{
-			Step mask(1);
+			Step mask("outlineMask");
 
 			auto pvs = VertexShader::Resolve(gfx, "Solid_VS.cso");
 			auto pvsbc = pvs->GetBytecode();
@@ -155,7 +133,7 @@ Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesys
 			outline.AddStep(std::move(mask));
 		}
 		{
-			Step draw(2);
+			Step draw("outlineDraw");
 
 			// these can be pass-constant (tricky due to layout issues)
 			auto pvs = VertexShader::Resolve(gfx, "Solid_VS.cso");
@@ -192,14 +170,17 @@ Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesys
 				{
 					probe.VisitBuffer(buf);
 				}
-				void Bind(Graphics& gfx) noexcept override
+				using TransformCbuf::Bind;
+				void Bind(Graphics& gfx, CommandStream& cmd, DirectX::FXMMATRIX world) noexcept override
 				{
 					const float scale = buf["scale"];
 					const auto scaleMatrix = DirectX::XMMatrixScaling(scale, scale, scale);
-					auto xf = GetTransforms(gfx);
-					xf.modelView = xf.modelView * scaleMatrix;
-					xf.modelViewProj = xf.modelViewProj * scaleMatrix;
-					UpdateBindImpl(gfx, xf);
+					// grown about the mesh's own origin: after decoding, before placing it
+					UpdateBindImpl(gfx, cmd, GetTransforms(gfx, GetDecodeXM() * scaleMatrix * world));
+				}
+				std::unique_ptr<CloningBindable> Clone() const noexcept override
+				{
+					return std::make_unique<TransformCbufScaling>(*this);
 				}
 			private:
 				static DC::RawLayout MakeLayout()
@@ -223,48 +204,140 @@ Material::Material(Graphics& gfx, const aiMaterial& material, const std::filesys
 }
 
 
-DV::VertexBuffer Material::ExtractVertices(const aiMesh& mesh) const noexcept
+Material::Description Material::Describe(const aiMaterial& material) noexcept
 {
-	return { vtxLayout,mesh };
+	Description description;
+	aiString string;
+	material.Get(AI_MATKEY_NAME, string);
+	description.name = string.C_Str();
+	if (material.GetTexture(aiTextureType_DIFFUSE, 0, &string) == aiReturn_SUCCESS)
+	{
+		description.diffuseMap = string.C_Str();
+	}
+	if (material.GetTexture(aiTextureType_SPECULAR, 0, &string) == aiReturn_SUCCESS)
+	{
+		description.specularMap = string.C_Str();
+	}
+	if (material.GetTexture(aiTextureType_NORMALS, 0, &string) == aiReturn_SUCCESS)
+	{
+		description.normalMap = string.C_Str();
+	}
+	static_assert(sizeof(aiColor3D) == sizeof(DirectX::XMFLOAT3), "aiColor3D must be 3 packed floats");
+	material.Get(AI_MATKEY_COLOR_DIFFUSE, reinterpret_cast<aiColor3D&>(description.diffuseColor));
+	material.Get(AI_MATKEY_COLOR_SPECULAR, reinterpret_cast<aiColor3D&>(description.specularColor));
+	material.Get(AI_MATKEY_SHININESS, description.shininess);
+	return description;
 }
-std::vector<unsigned short> Material::ExtractIndices(const aiMesh& mesh) const noexcept
+DV::VertexLayout Material::MakeVertexLayout(const Description& description) noexcept
 {
-	std::vector<unsigned short> indices;
-	indices.reserve(mesh.mNumFaces * 3);
-	for (unsigned int i = 0; i < mesh.mNumFaces; i++)
+	// compressed, the shaders decode; positions are dequantized by the drawable's decode
+	DV::VertexLayout layout;
+	layout
+		+ DV::Type::QuantizedPosition3D
+		+ DV::Type::OctNormal;
+	if (!description.diffuseMap.empty() || !description.specularMap.empty() || !description.normalMap.empty())
 	{
-		const auto& face = mesh.mFaces[i];
-		assert(face.mNumIndices == 3);
-		indices.push_back(face.mIndices[0]);
-		indices.push_back(face.mIndices[1]);
-		indices.push_back(face.mIndices[2]);
+		layout + DV::Type::HalfTexture2D;
 	}
-	return indices;
+	if (!description.normalMap.empty())
+	{
+		layout + DV::Type::OctTangent;
+	}
+	return layout;
+}
+const Material::Description& Material::GetDescription() const noexcept
+{
+	return description;
 }
-std::shared_ptr<VertexBuffer> Material::MakeVertexBindable(Graphics& gfx, const aiMesh& mesh, float scale) const noxnd
+DV::VertexBuffer Material::ExtractVertices(const aiMesh& mesh, float scale) const noexcept
 {
-	auto vtc = ExtractVertices(mesh);
-	if (scale != 1.0f)
+	DV::VertexBuffer vtc{ vtxLayout,mesh };
+	if (vtxLayout.Has(DV::Type::QuantizedPosition3D))
 	{
-		for (auto i = 0u; i < vtc.Count(); i++)
+		// the encoded fractions stay, the cube they are fractions of grows
+		auto quantization = vtc.GetQuantization();
+		quantization.origin = { quantization.origin.x * scale,quantization.origin.y * scale,quantization.origin.z * scale };
+		quantization.extent *= scale;
+		vtc.SetQuantization(quantization);
+	}
+	else if (scale != 1.0f)
+	{
+		const auto positions = vtc.Span<DV::VertexLayout::ElementType::Position3D>();
+		for (size_t i = 0; i < positions.Count(); i++)
 		{
-			DirectX::XMFLOAT3& pos = vtc[i].Attr<DV::VertexLayout::ElementType::Position3D>();
+			DirectX::XMFLOAT3& pos = positions[i];
 			pos.x *= scale;
 			pos.y *= scale;
 			pos.z *= scale;
 		}
 	}
-	return VertexBuffer::Resolve(gfx, MakeMeshTag(mesh), std::move(vtc));
+	return vtc;
 }
-std::shared_ptr<IndexBuffer> Material::MakeIndexBindable(Graphics& gfx, const aiMesh& mesh) const noxnd
+DV::PositionQuantization Material::ExtractQuantization(const aiMesh& mesh, float scale) const noexcept
 {
-	return IndexBuffer::Resolve(gfx, MakeMeshTag(mesh), ExtractIndices(mesh));
+	if (!vtxLayout.Has(DV::Type::QuantizedPosition3D))
+	{
+		return {};
+	}
+	// as DV::VertexBuffer and ExtractVertices work it out
+	auto quantization = DV::PositionQuantization::FromPoints(reinterpret_cast<const DirectX::XMFLOAT3*>(mesh.mVertices), mesh.mNumVertices);
+	quantization.origin = { quantization.origin.x * scale,quantization.origin.y * scale,quantization.origin.z * scale };
+	quantization.extent *= scale;
+	return quantization;
+}
+std::vector<uint32_t> Material::ExtractIndices(const aiMesh& mesh) const noexcept
+{
+	std::vector<uint32_t> indices;
+	indices.reserve(size_t(mesh.mNumFaces) * 3u);
+	for (unsigned int i = 0; i < mesh.mNumFaces; i++)
+	{
+		const auto& face = mesh.mFaces[i];
+		// points and lines left over from triangulation aren't drawn
+		if (face.mNumIndices == 3u)
+		{
+			indices.insert(indices.end(), face.mIndices, face.mIndices + 3u);
+		}
+	}
+	return indices;
+}
+std::shared_ptr<VertexBuffer> Material::MakeVertexBindable(Graphics& gfx, std::string_view meshName, const void* pVertices, size_t size) const noxnd
+{
+	return VertexBuffer::Resolve(gfx, MakeMeshTag(meshName), pVertices, size, UINT(vtxLayout.Size()));
+}
+std::shared_ptr<IndexBuffer> Material::MakeIndexBindable(Graphics& gfx, std::string_view meshName, size_t lod, const std::vector<uint32_t>& indices) const noxnd
+{
+	return IndexBuffer::Resolve(gfx, MakeLodTag(meshName, lod), indices);
 }
-std::string Material::MakeMeshTag(const aiMesh& mesh) const noexcept
+std::shared_ptr<VertexBuffer> Material::FindVertexBindable(std::string_view meshName) const noexcept
 {
-	return modelPath + "%" + mesh.mName.C_Str();
+	return VertexBuffer::Find(MakeMeshTag(meshName));
+}
+std::shared_ptr<IndexBuffer> Material::FindIndexBindable(std::string_view meshName, size_t lod) const noexcept
+{
+	return IndexBuffer::Find(MakeLodTag(meshName, lod), sizeof(uint32_t));
+}
+std::string Material::MakeMeshTag(std::string_view meshName) const noexcept
+{
+	return modelPath + "%" + std::string(meshName);
+}
+std::string Material::MakeLodTag(std::string_view meshName, size_t lod) const noexcept
+{
+	return MakeMeshTag(meshName) + (lod > 0u ? "#lod" + std::to_string(lod) : "");
 }
 std::vector<Technique> Material::GetTechniques() const noexcept
 {
 	return techniques;
+}
+const std::shared_ptr<Topology>& Material::GetTopology() const noexcept
+{
+	return pTopology;
+}
+const DV::VertexLayout& Material::GetVertexLayout() const noexcept
+{
+	return vtxLayout;
+}
+
+bool Material::IsMasked() const noexcept
+{
+	return masked;
 }
\ No newline at end of file
@@ -10,19 +10,62 @@ struct aiMesh;
 
 class Material
 {
+public:
+	// everything the material is built from, so it can be rebuilt without the aiMaterial
+	struct Description
+	{
+		std::string name;
+		// relative to the model's directory, empty if the material has no such map
+		std::string diffuseMap;
+		std::string specularMap;
+		std::string normalMap;
+		DirectX::XMFLOAT3 diffuseColor = { 0.45f,0.45f,0.85f };
+		DirectX::XMFLOAT3 specularColor = { 0.18f,0.18f,0.18f };
+		float shininess = 8.0f;
+	};
 public:
 	Material(Graphics& gfx, const aiMaterial& material, const std::filesystem::path& path) noxnd;
+	Material(Graphics& gfx, Description description, const std::filesystem::path& path) noxnd;
 public:
-	DV::VertexBuffer ExtractVertices(const aiMesh& mesh) const noexcept;
-	std::vector<unsigned short> ExtractIndices(const aiMesh& mesh) const noexcept;
-	std::shared_ptr<VertexBuffer> MakeVertexBindable(Graphics& gfx, const aiMesh& mesh, float scale = 1.0f) const noxnd;
-	std::shared_ptr<IndexBuffer> MakeIndexBindable(Graphics& gfx, const aiMesh& mesh) const noxnd;
+	static Description Describe(const aiMaterial& material) noexcept;
+	// what the shaders of a material so described take
+	static DV::VertexLayout MakeVertexLayout(const Description& description) noexcept;
+	const Description& GetDescription() const noexcept;
+	// vertices in the layout this material's shaders take, positions scaled; quantized positions
+	// keep their encoding and are scaled through the buffer's quantization
+	DV::VertexBuffer ExtractVertices(const aiMesh& mesh, float scale = 1.0f) const noexcept;
+	// the quantization ExtractVertices would give the mesh's positions, without extracting them
+	DV::PositionQuantization ExtractQuantization(const aiMesh& mesh, float scale = 1.0f) const noexcept;
+	// full width, the index buffer narrows them when the mesh allows
+	std::vector<uint32_t> ExtractIndices(const aiMesh& mesh) const noexcept;
+	// vertices already in this material's layout, e.g. from a model cache
+	std::shared_ptr<VertexBuffer> MakeVertexBindable(Graphics& gfx, std::string_view meshName, const void* pVertices, size_t size) const noxnd;
+	// indices of a level of detail of a mesh, lod 0 being the mesh itself
+	std::shared_ptr<IndexBuffer> MakeIndexBindable(Graphics& gfx, std::string_view meshName, size_t lod, const std::vector<uint32_t>& indices) const noxnd;
+	// makeIndices is only called if the codex has nothing for the lod yet
+	template<typename F, typename = std::enable_if_t<std::is_invocable_r_v<std::vector<uint32_t>, F&>>>
+	std::shared_ptr<IndexBuffer> MakeIndexBindable(Graphics& gfx, std::string_view meshName, size_t lod, F&& makeIndices) const noxnd
+	{
+		return IndexBuffer::Resolve(gfx, MakeLodTag(meshName, lod), std::forward<F>(makeIndices));
+	}
+	// what the two above made for the mesh, nullptr if the codex doesn't hold it (anymore)
+	std::shared_ptr<VertexBuffer> FindVertexBindable(std::string_view meshName) const noexcept;
+	std::shared_ptr<IndexBuffer> FindIndexBindable(std::string_view meshName, size_t lod) const noexcept;
 	std::vector<Technique> GetTechniques() const noexcept;
+	// resolved once, for every drawable made from the material
+	const std::shared_ptr<Topology>& GetTopology() const noexcept;
+	const DV::VertexLayout& GetVertexLayout() const noexcept;
+	// alpha tested diffuse, drawn two sided and full of holes
+	bool IsMasked() const noexcept;
 private:
-	std::string MakeMeshTag(const aiMesh& mesh) const noexcept;
+	std::string MakeMeshTag(std::string_view meshName) const noexcept;
+	std::string MakeLodTag(std::string_view meshName, size_t lod) const noexcept;
 private:
+	Description description;
 	DV::VertexLayout vtxLayout;
 	std::vector<Technique> techniques;
 	std::string modelPath;
 	std::string name;
+	std::shared_ptr<Topology> pTopology;
+	bool masked = false;
 };
\ No newline at end of file
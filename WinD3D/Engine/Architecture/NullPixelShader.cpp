@@ -4,19 +4,19 @@
 NullPixelShader::NullPixelShader(Graphics& gfx)
 {
 }
-void NullPixelShader::Bind(Graphics& gfx) noexcept
+void NullPixelShader::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->PSSetShader(nullptr, nullptr, 0u);
+	cmd.SetPixelShader(nullptr);
 }
 std::shared_ptr<NullPixelShader> NullPixelShader::Resolve(Graphics& gfx)
 {
 	return Codex::Resolve<NullPixelShader>(gfx);
 }
-std::string NullPixelShader::GenerateUID()
+BindableKey NullPixelShader::GenerateUID()
 {
-	return typeid(NullPixelShader).name();
+	return BindableKey::Of<NullPixelShader>();
 }
-std::string NullPixelShader::GetUID() const noexcept
+BindableKey NullPixelShader::GetUID() const noexcept
 {
 	return GenerateUID();
 }
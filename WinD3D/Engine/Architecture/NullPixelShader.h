@@ -7,8 +7,8 @@ class NullPixelShader : public Bindable
 public:
 	NullPixelShader(Graphics& gfx);
 public:
-	void Bind(Graphics& gfx) noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
 	static std::shared_ptr<NullPixelShader> Resolve(Graphics& gfx);
-	static std::string GenerateUID();
-	std::string GetUID() const noexcept override;
+	static BindableKey GenerateUID();
+	BindableKey GetUID() const noexcept override;
 };
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "Pass.h"
+#include "Drawable.h"
+#include "Step.h"
+#include "InstanceCbuf.h"
+#include <cstring>
+
+namespace dx = DirectX;
+
+void Pass::Order(Graphics& gfx) noexcept
+{
+	stats.jobs = jobs.size();
+	stats.stateChangesSubmitted = CountStateChanges(jobs);
+	if (sorting != Sorting::None)
+	{
+		Sort(gfx);
+	}
+	stats.stateChangesExecuted = CountStateChanges(jobs);
+}
+
+void Pass::Record(Graphics& gfx) noexcept
+{
+	Order(gfx);
+	for (const auto& b : bindables)
+	{
+		b->Bind(gfx, commands);
+	}
+	stats.draws = 0u;
+	for (size_t i = 0; i < jobs.size(); )
+	{
+		const auto run = GetRunLength(i);
+		stats.draws++;
+		if (run > 1u)
+		{
+			Job::RecordInstanced(gfx, commands, &jobs[i], run);
+		}
+		else
+		{
+			jobs[i].Record(gfx, commands);
+		}
+		i += run;
+	}
+	stats.commands = commands.GetCommandCount();
+}
+
+void Pass::Sort(Graphics& gfx) noexcept
+{
+	if (jobs.size() < 2u)
+	{
+		return;
+	}
+	if (sorting == Sorting::State)
+	{
+		for (auto& j : jobs)
+		{
+			j.SetSortKey(j.GetStateKey());
+		}
+	}
+	else
+	{
+		const auto camera = gfx.GetCamera();
+		for (auto& j : jobs)
+		{
+			// view space depth of the drawable origin, mapped so unsigned order matches float order
+			const float depth = dx::XMVectorGetZ((j.GetTransformXM() * camera).r[3]);
+			uint32_t bits;
+			std::memcpy(&bits, &depth, sizeof(bits));
+			bits ^= (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+			if (sorting == Sorting::BackToFront)
+			{
+				bits = ~bits;
+			}
+			// state still breaks ties between jobs at equal depth
+			j.SetSortKey(uint64_t(bits) << 32 | j.GetStateKey() >> 32);
+		}
+	}
+
+	// LSD radix sort, one byte per round; stable so equal keys keep submission order
+	scratch.resize(jobs.size(), jobs.front());
+	for (unsigned shift = 0u; shift < 64u; shift += 8u)
+	{
+		size_t offsets[256] = {};
+		for (const auto& j : jobs)
+		{
+			offsets[(j.GetSortKey() >> shift) & 0xFFu]++;
+		}
+		// skip rounds where every key has the same byte
+		if (offsets[(jobs.front().GetSortKey() >> shift) & 0xFFu] == jobs.size())
+		{
+			continue;
+		}
+		size_t sum = 0u;
+		for (auto& o : offsets)
+		{
+			const auto count = o;
+			o = sum;
+			sum += count;
+		}
+		for (const auto& j : jobs)
+		{
+			scratch[offsets[(j.GetSortKey() >> shift) & 0xFFu]++] = j;
+		}
+		jobs.swap(scratch);
+	}
+}
+
+size_t Pass::GetRunLength(size_t first) const noexcept
+{
+	// equal state keys are adjacent after state sorting, so runs only need looking ahead
+	size_t n = 1u;
+	while (first + n < jobs.size() && n < InstanceCbuf::maxInstances &&
+		jobs[first + n].CanInstanceWith(jobs[first]))
+	{
+		n++;
+	}
+	return n;
+}
+
+size_t Pass::CountStateChanges(const std::vector<Job>& jobs) noexcept
+{
+	using SK = Job::StateKey;
+	constexpr uint64_t fieldMasks[] = {
+		0xFFFull << SK::vsShift,
+		0xFFFull << SK::psShift,
+		0xFFFFull << SK::texShift,
+		0xFFFull << SK::miscShift,
+		0xFFFull << SK::vbShift,
+	};
+	size_t changes = 0u;
+	for (size_t i = 1; i < jobs.size(); i++)
+	{
+		const auto diff = jobs[i - 1].GetStateKey() ^ jobs[i].GetStateKey();
+		for (const auto mask : fieldMasks)
+		{
+			changes += (diff & mask) != 0u;
+		}
+	}
+	return changes;
+}
@@ -1,26 +1,76 @@
 #pragma once
 #include <Engine/Graphics.h>
 #include "Job.h"
+#include "Bindable.h"
 #include <vector>
+#include <memory>
 
 class Pass
 {
 public:
+	enum class Sorting
+	{
+		None,
+		State,
+		FrontToBack,
+		BackToFront
+	};
+	struct Stats
+	{
+		size_t jobs = 0u;
+		// state fields (shaders, textures, other state, vertex buffer) that differ between consecutive jobs
+		size_t stateChangesSubmitted = 0u;
+		size_t stateChangesExecuted = 0u;
+		size_t commands = 0u;
+		size_t draws = 0u;
+	};
+public:
+	Pass(Sorting sorting = Sorting::None) noexcept
+		:
+		sorting(sorting)
+	{}
 	void Accept(Job job) noexcept
 	{
 		jobs.push_back(job);
 	}
-	void Execute(Graphics& gfx) const noxnd
+	// pass-constant state, bound once before the pass's jobs
+	void AddBindable(std::shared_ptr<Bindable> bind) noexcept
+	{
+		bindables.push_back(std::move(bind));
+	}
+	bool HasJobs() const noexcept
 	{
-		for (const auto& j : jobs)
-		{
-			j.Execute(gfx);
-		}
+		return !jobs.empty();
+	}
+	// sorts the jobs by the pass's policy and counts their state changes before and after;
+	// Record starts with this. state sorting doesn't read gfx
+	void Order(Graphics& gfx) noexcept;
+	// sorts and records the jobs into the pass's command stream; touches no context state,
+	// so different passes can be recorded concurrently
+	void Record(Graphics& gfx) noexcept;
+	const CommandStream& GetCommands() const noexcept
+	{
+		return commands;
 	}
 	void Reset() noexcept
 	{
 		jobs.clear();
+		commands.Clear();
 	}
+	const Stats& GetStats() const noexcept
+	{
+		return stats;
+	}
+private:
+	void Sort(Graphics& gfx) noexcept;
+	// length of the instanceable run of jobs starting at first, 1 if it can't be instanced
+	size_t GetRunLength(size_t first) const noexcept;
+	static size_t CountStateChanges(const std::vector<Job>& jobs) noexcept;
 private:
+	Sorting sorting;
+	std::vector<std::shared_ptr<Bindable>> bindables;
 	std::vector<Job> jobs;
-};
\ No newline at end of file
+	std::vector<Job> scratch;
+	CommandStream commands;
+	Stats stats;
+};
@@ -11,22 +11,22 @@ PixelShader::PixelShader(Graphics& gfx, const std::string& path)
 	Microsoft::WRL::ComPtr<ID3DBlob> pBlob;
 	GFX_THROW_INFO(D3DReadFileToBlob(ToWide(path).c_str(), &pBlob));
 	GFX_THROW_INFO(GetDevice(gfx)->CreatePixelShader(pBlob->GetBufferPointer(), pBlob->GetBufferSize(), nullptr, &pPixelShader));
+	footprint = pBlob->GetBufferSize();
 }
 
-void PixelShader::Bind(Graphics& gfx) noexcept
+void PixelShader::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->PSSetShader(pPixelShader.Get(), nullptr, 0u);
+	cmd.SetPixelShader(pPixelShader.Get());
 }
 std::shared_ptr<PixelShader> PixelShader::Resolve(Graphics& gfx, const std::string& path)
 {
 	return Codex::Resolve<PixelShader>(gfx, path);
 }
-std::string PixelShader::GenerateUID(const std::string& path)
+BindableKey PixelShader::GenerateUID(const std::string& path)
 {
-	using namespace std::string_literals;
-	return typeid(PixelShader).name() + "#"s + path;
+	return BindableKey::Of<PixelShader>().Mix(path);
 }
-std::string PixelShader::GetUID() const noexcept
+BindableKey PixelShader::GetUID() const noexcept
 {
 	return GenerateUID(path);
 }
\ No newline at end of file
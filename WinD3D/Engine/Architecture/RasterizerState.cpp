@@ -24,21 +24,20 @@ RasterizerState::RasterizerState(Graphics& gfx, bool twoSided)
 	GFX_THROW_INFO(GetDevice(gfx)->CreateRasterizerState(&rasterDesc, &pRasterizer));
 }
 
-void RasterizerState::Bind(Graphics& gfx) noexcept
+void RasterizerState::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->RSSetState(pRasterizer.Get());
+	cmd.SetRasterizer(pRasterizer.Get());
 }
 
 std::shared_ptr<RasterizerState> RasterizerState::Resolve(Graphics& gfx, bool twoSided)
 {
 	return Codex::Resolve<RasterizerState>(gfx, twoSided);
 }
-std::string RasterizerState::GenerateUID(bool twoSided)
+BindableKey RasterizerState::GenerateUID(bool twoSided)
 {
-	using namespace std::string_literals;
-	return typeid(RasterizerState).name() + "#"s + (twoSided ? "2s" : "1s");
+	return BindableKey::Of<RasterizerState>().Mix(twoSided);
 }
-std::string RasterizerState::GetUID() const noexcept
+BindableKey RasterizerState::GetUID() const noexcept
 {
 	return GenerateUID(twoSided);
 }
\ No newline at end of file
@@ -7,11 +7,11 @@ class RasterizerState : public Bindable
 public:
 	RasterizerState(Graphics& gfx, bool twosided);
 public:
-	void Bind(Graphics& gfx)noexcept override;
-	std::string GetUID() const noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
+	BindableKey GetUID() const noexcept override;
 public:
 	static std::shared_ptr<RasterizerState> Resolve(Graphics& gfx, bool twosided);
-	static std::string GenerateUID(bool twoSided);
+	static BindableKey GenerateUID(bool twoSided);
 protected:
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> pRasterizer;
 	bool twoSided;
@@ -0,0 +1,158 @@
+#include "RenderGraph.h"
+#include "BindableKey.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+RenderGraph::PassId RenderGraph::MakePassId(std::string_view name) noexcept
+{
+	return BindableKey{}.Mix(name).Value();
+}
+
+size_t RenderGraph::AddPass(std::string name, std::vector<std::string> reads, std::vector<std::string> writes)
+{
+	const auto id = MakePassId(name);
+	nodes.push_back({ std::move(name),id,std::move(reads),std::move(writes) });
+	compiled = false;
+	return nodes.size() - 1;
+}
+
+void RenderGraph::AddOutput(std::string resource)
+{
+	outputs.push_back(std::move(resource));
+	compiled = false;
+}
+
+void RenderGraph::Compile()
+{
+	const auto count = nodes.size();
+	std::vector<std::vector<size_t>> successors(count);
+	std::vector<size_t> inDegree(count, 0u);
+	for (size_t i = 0; i < count; i++)
+	{
+		for (size_t j = i + 1; j < count; j++)
+		{
+			if (nodes[i].id == nodes[j].id)
+			{
+				throw std::logic_error("Render graph pass registered twice: " + nodes[i].name);
+			}
+		}
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		for (size_t j = 0; j < count; j++)
+		{
+			if (i == j)
+			{
+				continue;
+			}
+			bool dependency = false;
+			for (const auto& r : nodes[i].writes)
+			{
+				// j consumes what i produces, or both produce it and i was registered first
+				if (Contains(nodes[j].reads, r) || (i < j && Contains(nodes[j].writes, r)))
+				{
+					dependency = true;
+					break;
+				}
+			}
+			if (dependency)
+			{
+				successors[i].push_back(j);
+				inDegree[j]++;
+			}
+		}
+	}
+
+	// Kahn, always taking the earliest registered ready pass so independent passes keep registration order
+	order.clear();
+	std::vector<bool> done(count, false);
+	while (order.size() < count)
+	{
+		size_t next = npos;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!done[i] && inDegree[i] == 0u)
+			{
+				next = i;
+				break;
+			}
+		}
+		if (next == npos)
+		{
+			throw std::logic_error("Render graph has a cyclic resource dependency");
+		}
+		done[next] = true;
+		order.push_back(next);
+		for (const auto s : successors[next])
+		{
+			inDegree[s]--;
+		}
+	}
+	compiled = true;
+}
+
+const std::vector<size_t>& RenderGraph::Schedule(const std::vector<bool>& hasWork)
+{
+	assert(compiled && "Render graph must be compiled before scheduling");
+	assert(hasWork.size() == nodes.size());
+	// walk back from the outputs, a pass survives if it has work and writes something still needed
+	needed = outputs;
+	schedule.clear();
+	for (auto i = order.rbegin(); i != order.rend(); ++i)
+	{
+		const auto& node = nodes[*i];
+		if (!hasWork[*i])
+		{
+			continue;
+		}
+		const bool consumed = std::any_of(node.writes.begin(), node.writes.end(),
+			[this](const std::string& r) { return Contains(needed, r); });
+		if (!consumed)
+		{
+			continue;
+		}
+		for (const auto& r : node.reads)
+		{
+			if (!Contains(needed, r))
+			{
+				needed.push_back(r);
+			}
+		}
+		schedule.push_back(*i);
+	}
+	std::reverse(schedule.begin(), schedule.end());
+	return schedule;
+}
+
+size_t RenderGraph::Find(PassId id) const noexcept
+{
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		if (nodes[i].id == id)
+		{
+			return i;
+		}
+	}
+	return npos;
+}
+
+size_t RenderGraph::GetPassCount() const noexcept
+{
+	return nodes.size();
+}
+
+const std::string& RenderGraph::GetPassName(size_t pass) const noexcept
+{
+	return nodes[pass].name;
+}
+
+const std::vector<size_t>& RenderGraph::GetOrder() const noexcept
+{
+	return order;
+}
+
+bool RenderGraph::Contains(const std::vector<std::string>& resources, const std::string& resource) noexcept
+{
+	return std::find(resources.begin(), resources.end(), resource) != resources.end();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// pass scheduling only, knows nothing about the device so it can be compiled and queried standalone
+// passes declare the resources they read and write; a pass runs after the passes producing what it reads,
+// passes writing the same resource keep registration order, and passes whose writes nobody consumes are culled
+class RenderGraph
+{
+public:
+	using PassId = uint64_t;
+	static constexpr size_t npos = ~size_t(0);
+public:
+	static PassId MakePassId(std::string_view name) noexcept;
+	size_t AddPass(std::string name, std::vector<std::string> reads, std::vector<std::string> writes);
+	// resources that leave the graph (e.g. the back buffer), passes feeding these are never culled
+	void AddOutput(std::string resource);
+	// throws std::logic_error on duplicate pass names or cyclic dependencies
+	void Compile();
+	// passes to execute in order, given which passes have work this frame
+	const std::vector<size_t>& Schedule(const std::vector<bool>& hasWork);
+	size_t Find(PassId id) const noexcept;
+	size_t GetPassCount() const noexcept;
+	const std::string& GetPassName(size_t pass) const noexcept;
+	const std::vector<size_t>& GetOrder() const noexcept;
+private:
+	struct Node
+	{
+		std::string name;
+		PassId id;
+		std::vector<std::string> reads;
+		std::vector<std::string> writes;
+	};
+private:
+	static bool Contains(const std::vector<std::string>& resources, const std::string& resource) noexcept;
+private:
+	std::vector<Node> nodes;
+	std::vector<std::string> outputs;
+	std::vector<size_t> order;
+	std::vector<size_t> schedule;
+	std::vector<std::string> needed;
+	bool compiled = false;
+};
@@ -19,11 +19,11 @@ Sampler::Sampler(Graphics & gfx)
 	GFX_THROW_INFO(GetDevice(gfx)->CreateSamplerState(&sDesc, &pSampler));
 }
 
-void Sampler::Bind(Graphics& gfx)noexcept
+void Sampler::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->PSSetSamplers(0u, 1u, pSampler.GetAddressOf());
+	cmd.SetPixelSampler(0u, pSampler.Get());
 }
-std::string Sampler::GetUID() const noexcept
+BindableKey Sampler::GetUID() const noexcept
 {
 	return GenerateUID();
 }
@@ -32,7 +32,7 @@ std::shared_ptr<Sampler> Sampler::Resolve(Graphics& gfx)
 {
 	return Codex::Resolve<Sampler>(gfx);
 }
-std::string Sampler::GenerateUID()
+BindableKey Sampler::GenerateUID()
 {
-	return typeid(Sampler).name();
+	return BindableKey::Of<Sampler>();
 }
@@ -7,11 +7,11 @@ class Sampler : public Bindable
 public:
 	Sampler(Graphics& gfx);
 public:
-	void Bind(Graphics& gfx)noexcept override;
-	std::string GetUID() const noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
+	BindableKey GetUID() const noexcept override;
 public:
 	static std::shared_ptr<Sampler> Resolve(Graphics& gfx);
-	static std::string GenerateUID();
+	static BindableKey GenerateUID();
 protected:
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> pSampler;
 };
\ No newline at end of file
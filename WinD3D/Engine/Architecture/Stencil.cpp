@@ -35,12 +35,12 @@ Stencil::Stencil(Graphics& gfx, Mode mode)
     GetDevice(gfx)->CreateDepthStencilState(&dsDesc, &pStencil);
 }
 
-void Stencil::Bind(Graphics& gfx) noexcept
+void Stencil::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-    GetContext(gfx)->OMSetDepthStencilState(pStencil.Get(), 0xFF);
+    cmd.SetDepthStencil(pStencil.Get());
 }
 
-std::string Stencil::GetUID() const noexcept
+BindableKey Stencil::GetUID() const noexcept
 {
     return GenerateUID(mode);
 }
@@ -48,19 +48,7 @@ std::shared_ptr<Stencil> Stencil::Resolve(Graphics& gfx, Mode mode)
 {
     return Codex::Resolve<Stencil>(gfx, mode);
 }
-std::string Stencil::GenerateUID(Mode mode)
+BindableKey Stencil::GenerateUID(Mode mode)
 {
-    using namespace std::string_literals;
-    const auto modeName = [mode]() {
-        switch (mode) {
-        case Mode::Off:
-            return "off"s;
-        case Mode::Write:
-            return "write"s;
-        case Mode::Mask:
-            return "mask"s;
-        }
-        return "ERROR"s;
-    };
-    return typeid(Stencil).name() + "#"s + modeName();
+    return BindableKey::Of<Stencil>().Mix(mode);
 }
@@ -14,11 +14,11 @@ public:
 public:
 	Stencil(Graphics& gfx, Mode mode);
 public:
-	void Bind(Graphics& gfx)noexcept override;
-	std::string GetUID() const noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
+	BindableKey GetUID() const noexcept override;
 public:
 	static std::shared_ptr<Stencil> Resolve(Graphics& gfx, Mode mode);
-	static std::string GenerateUID(Mode mode);
+	static BindableKey GenerateUID(Mode mode);
 protected:
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> pStencil;
 	Mode mode;
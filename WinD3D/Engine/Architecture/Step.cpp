@@ -1,20 +1,115 @@
 #include "Step.h"
 #include "FrameCommander.h"
+#include "InstanceCbuf.h"
+#include "TransformCBuf.h"
+#include <typeinfo>
 
 void Step::AddBindable(std::shared_ptr<Bindable> bind_in) noexcept
 {
+	// per-drawable bindables (transforms) differ for every job anyway, only shared state sorts
+	if (dynamic_cast<const CloningBindable*>(bind_in.get()))
+	{
+		// the instance buffer only stands in for the world transform, anything else a clone
+		// carries per drawable (e.g. the outline scale) would be lost in an instanced draw
+		worldClonesOnly = worldClonesOnly && IsWorldTransform(*bind_in);
+	}
+	else
+	{
+		const auto identity = uint64_t(bind_in.get()) * 0x9E3779B97F4A7C15ull;
+		if (dynamic_cast<const VertexShader*>(bind_in.get()))
+		{
+			stateHashes[0] ^= identity;
+		}
+		else if (dynamic_cast<const PixelShader*>(bind_in.get()))
+		{
+			stateHashes[1] ^= identity;
+		}
+		else if (dynamic_cast<const Texture*>(bind_in.get()))
+		{
+			stateHashes[2] ^= identity;
+		}
+		else
+		{
+			stateHashes[3] ^= identity;
+		}
+	}
 	bindables.push_back(std::move(bind_in));
 }
+uint64_t Step::GetStateKey() const noexcept
+{
+	using SK = Job::StateKey;
+	return SK::Reduce(stateHashes[0], 12u) << SK::vsShift |
+		SK::Reduce(stateHashes[1], 12u) << SK::psShift |
+		SK::Reduce(stateHashes[2], 16u) << SK::texShift |
+		SK::Reduce(stateHashes[3], 12u) << SK::miscShift;
+}
+
+void Step::EnableInstancing(Graphics& gfx, const std::string& instancedVSPath)
+{
+	pInstancedVS = VertexShader::Resolve(gfx, instancedVSPath);
+	pInstances = InstanceCbuf::Resolve(gfx);
+}
+bool Step::SharesStateWith(const Step& other) const noexcept
+{
+	if (!worldClonesOnly || !other.worldClonesOnly)
+	{
+		return false;
+	}
+	if (this == &other)
+	{
+		return true;
+	}
+	if (bindables.size() != other.bindables.size() || pInstancedVS != other.pInstancedVS)
+	{
+		return false;
+	}
+	for (size_t i = 0; i < bindables.size(); i++)
+	{
+		const auto* pA = bindables[i].get();
+		const auto* pB = other.bindables[i].get();
+		// world transforms are per drawable and carried by the instance buffer, the rest must be the same object
+		if (pA != pB && (!IsWorldTransform(*pA) || !IsWorldTransform(*pB)))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+void Step::BindInstanced(Graphics& gfx, CommandStream& cmd) const noexcept
+{
+	for (const auto& b : bindables)
+	{
+		if (!IsWorldTransform(*b) && !dynamic_cast<const VertexShader*>(b.get()))
+		{
+			b->Bind(gfx, cmd);
+		}
+	}
+	pInstancedVS->Bind(gfx, cmd);
+	pInstances->Bind(gfx, cmd);
+}
+
+bool Step::IsWorldTransform(const Bindable& bind) noexcept
+{
+	// exact type, derived transforms bind more than the world (scaling, pixel stage copies)
+	return typeid(bind) == typeid(TransformCbuf);
+}
 
-void Step::Submit(FrameCommander& frame, const Drawable& drawable) const
+void Step::Submit(FrameCommander& frame, const Drawable& drawable, DirectX::FXMMATRIX world) const
 {
-	frame.Accept(Job{ this, &drawable }, targetPass);
+	frame.Accept(Job{ this, &drawable, world }, targetPass);
 }
-void Step::Bind(Graphics& gfx) const
+void Step::Bind(Graphics& gfx, CommandStream& cmd, DirectX::FXMMATRIX world) const noexcept
 {
 	for (const auto& b : bindables)
 	{
-		b->Bind(gfx);
+		if (auto* pCloning = dynamic_cast<CloningBindable*>(b.get()))
+		{
+			pCloning->Bind(gfx, cmd, world);
+		}
+		else
+		{
+			b->Bind(gfx, cmd);
+		}
 	}
 }
 void Step::InitializeParentReferences(const Drawable& parent) noexcept
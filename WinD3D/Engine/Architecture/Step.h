@@ -1,21 +1,28 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <array>
+#include <string>
 #include "Bindable.h"
 #include <Engine/Graphics.h>
 #include "TechniqueProbe.h"
+#include "RenderGraph.h"
 
 class Step
 {
 public:
-	Step(size_t targetPass_in)
+	Step(std::string_view targetPass_in)
 		:
-		targetPass{ targetPass_in }
+		targetPass{ RenderGraph::MakePassId(targetPass_in) }
 	{}
 	Step(Step&&) = default;
 	Step(const Step& src) noexcept
 		:
-		targetPass(src.targetPass)
+		targetPass(src.targetPass),
+		stateHashes(src.stateHashes),
+		worldClonesOnly(src.worldClonesOnly),
+		pInstancedVS(src.pInstancedVS),
+		pInstances(src.pInstances)
 	{
 		bindables.reserve(src.bindables.size());
 		for (auto& pb : src.bindables)
@@ -34,11 +41,35 @@ public:
 	Step& operator=(Step&&) = delete;
 public:
 	void AddBindable(std::shared_ptr<Bindable> bind_in) noexcept;
-	void Submit(class FrameCommander& frame, const class Drawable& drawable) const;
-	void Bind(Graphics& gfx) const;
+	void Submit(class FrameCommander& frame, const class Drawable& drawable, DirectX::FXMMATRIX world) const;
+	// per-drawable bindables get world, the rest bind as they are
+	void Bind(Graphics& gfx, CommandStream& cmd, DirectX::FXMMATRIX world) const noexcept;
 	void InitializeParentReferences(const class Drawable& parent) noexcept;
 	void Accept(TechniqueProbe& probe);
+	// identity of the shared state this step binds, packed as in Job::StateKey (vertex buffer field left 0)
+	uint64_t GetStateKey() const noexcept;
+	// lets runs of jobs with this step's state and the same geometry be drawn as one instanced
+	// draw; the instanced shader replaces both the step's vertex shader and its transform cbuf
+	void EnableInstancing(Graphics& gfx, const std::string& instancedVSPath);
+	bool IsInstanced() const noexcept
+	{
+		return pInstancedVS != nullptr;
+	}
+	// same bindables apart from the world transforms, and no other per-drawable clones
+	bool SharesStateWith(const Step& other) const noexcept;
+	void BindInstanced(Graphics& gfx, CommandStream& cmd) const noexcept;
+	const class InstanceCbuf& GetInstances() const noexcept
+	{
+		return *pInstances;
+	}
+private:
+	static bool IsWorldTransform(const Bindable& bind) noexcept;
 private:
-	size_t targetPass;
+	RenderGraph::PassId targetPass;
 	std::vector<std::shared_ptr<Bindable>> bindables;
+	// vertex shader, pixel shader, textures, other shared state
+	std::array<uint64_t, 4> stateHashes = {};
+	bool worldClonesOnly = true;
+	std::shared_ptr<class VertexShader> pInstancedVS;
+	std::shared_ptr<class InstanceCbuf> pInstances;
 };
\ No newline at end of file
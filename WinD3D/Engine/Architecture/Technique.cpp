@@ -7,12 +7,12 @@ Technique::Technique(std::string name, bool startActive) noexcept
 {}
 
 
-void Technique::Submit(FrameCommander& frame, const Drawable& drawable) const noexcept
+void Technique::Submit(FrameCommander& frame, const Drawable& drawable, DirectX::FXMMATRIX world) const noexcept
 {
 	if(active)
 		for (const auto& step : steps)
 		{
-			step.Submit(frame, drawable);
+			step.Submit(frame, drawable, world);
 		}
 }
 void Technique::AddStep(Step step) noexcept
@@ -10,7 +10,7 @@ public:
 	Technique() = default;
 	Technique(std::string name, bool startActive = true) noexcept;
 public:
-	void Submit(class FrameCommander& frame, const class Drawable& drawable) const noexcept;
+	void Submit(class FrameCommander& frame, const class Drawable& drawable, DirectX::FXMMATRIX world) const noexcept;
 	void AddStep(Step step) noexcept;
 	bool IsActive() const noexcept;
 	void SetActiveState(bool active_in) noexcept;
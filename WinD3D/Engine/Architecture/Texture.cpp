@@ -34,6 +34,8 @@ Texture::Texture(Graphics& gfx, std::string_view path, UINT slot)
 		&pTexture));
 
 
+	// device is free-threaded, context is not (texture may be resolved from a loader thread)
+	auto contextLock = LockContext(gfx);
 	GetContext(gfx)->UpdateSubresource(
 		pTexture.Get(), 0u, nullptr, s.GetBufferPtr(), s.GetStride(), 0u
 	);
@@ -51,22 +53,31 @@ Texture::Texture(Graphics& gfx, std::string_view path, UINT slot)
 	));
 
 	GetContext(gfx)->GenerateMips(pTextureView.Get());
+
+	// full mip chain down to 1x1, 4 bytes per texel
+	for (UINT w = texDesc.Width, h = texDesc.Height; ; w = std::max(w / 2u, 1u), h = std::max(h / 2u, 1u))
+	{
+		footprint += size_t(w) * h * 4u;
+		if (w == 1u && h == 1u)
+		{
+			break;
+		}
+	}
 }
 
-void Texture::Bind(Graphics& gfx)noexcept
+void Texture::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->PSSetShaderResources(slot, 1u, pTextureView.GetAddressOf());
+	cmd.SetPixelResource(slot, pTextureView.Get());
 }
 std::shared_ptr<Texture> Texture::Resolve(Graphics& gfx, std::string_view path, UINT slot)
 {
 	return Codex::Resolve<Texture>(gfx, path, slot);
 }
-std::string Texture::GenerateUID(std::string_view path, UINT slot)
+BindableKey Texture::GenerateUID(std::string_view path, UINT slot)
 {
-	using namespace std::string_literals;
-	return typeid(Texture).name() + "#"s + path.data() + "#" + std::to_string(slot);
+	return BindableKey::Of<Texture>().Mix(path).Mix(slot);
 }
-std::string Texture::GetUID() const noexcept
+BindableKey Texture::GetUID() const noexcept
 {
 	return GenerateUID(path, slot);
 }
@@ -7,10 +7,10 @@ class Texture : public Bindable
 public:
 	Texture(Graphics& gfx, std::string_view path, UINT slot = 0);
 public:
-	void Bind(Graphics& gfx) noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
 	static std::shared_ptr<Texture> Resolve(Graphics& gfx, std::string_view path, UINT slot = 0);
-	static std::string GenerateUID(std::string_view path, UINT slot = 0);
-	std::string GetUID() const noexcept override;
+	static BindableKey GenerateUID(std::string_view path, UINT slot = 0);
+	BindableKey GetUID() const noexcept override;
 	bool UsesAlpha() const noexcept;
 private:
 	static UINT CalculateNumberOfMipLevels(UINT width, UINT height) noexcept;
@@ -6,21 +6,20 @@ Topology::Topology(Graphics& gfx, D3D11_PRIMITIVE_TOPOLOGY type)
 	type(type)
 {}
 
-void Topology::Bind(Graphics& gfx) noexcept
+void Topology::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->IASetPrimitiveTopology(type);
+	cmd.SetTopology(type);
 }
 
 std::shared_ptr<Topology> Topology::Resolve(Graphics& gfx, D3D11_PRIMITIVE_TOPOLOGY type)
 {
 	return Codex::Resolve<Topology>(gfx, type);
 }
-std::string Topology::GenerateUID(D3D11_PRIMITIVE_TOPOLOGY type)
+BindableKey Topology::GenerateUID(D3D11_PRIMITIVE_TOPOLOGY type)
 {
-	using namespace std::string_literals;
-	return typeid(Topology).name() + "#"s + std::to_string(type);
+	return BindableKey::Of<Topology>().Mix(type);
 }
-std::string Topology::GetUID() const noexcept
+BindableKey Topology::GetUID() const noexcept
 {
 	return GenerateUID(type);
 }
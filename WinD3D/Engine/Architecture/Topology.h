@@ -7,10 +7,10 @@ class Topology : public Bindable
 public:
 	Topology(Graphics& gfx, D3D11_PRIMITIVE_TOPOLOGY type);
 public:
-	void Bind(Graphics& gfx) noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
 	static std::shared_ptr<Topology> Resolve(Graphics& gfx, D3D11_PRIMITIVE_TOPOLOGY type = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	static std::string GenerateUID(D3D11_PRIMITIVE_TOPOLOGY type);
-	std::string GetUID() const noexcept override;
+	static BindableKey GenerateUID(D3D11_PRIMITIVE_TOPOLOGY type);
+	BindableKey GetUID() const noexcept override;
 protected:
 	D3D11_PRIMITIVE_TOPOLOGY type;
 };
\ No newline at end of file
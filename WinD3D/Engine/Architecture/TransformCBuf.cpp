@@ -1,35 +1,34 @@
 #include "TransformCBuf.h"
+#include "Drawable.h"
 
 TransformCbuf::TransformCbuf(Graphics& gfx, UINT slot)
 {
-	if (!pVcbuf)
+	std::call_once(vcbufCreated, [&gfx, slot]
 	{
 		pVcbuf = std::make_unique<VertexConstantBuffer<Transforms>>(gfx, slot);
-	}
+	});
 }
 
-void TransformCbuf::Bind(Graphics& gfx) noexcept
+void TransformCbuf::Bind(Graphics& gfx, CommandStream& cmd, DirectX::FXMMATRIX world) noexcept
 {
-	UpdateBindImpl(gfx, GetTransforms(gfx));
-}
-void TransformCbuf::InitializeParentReference(const Drawable& parent) noexcept
-{
-	pParent = &parent;
+	UpdateBindImpl(gfx, cmd, GetTransforms(gfx, GetDecodeXM() * world));
 }
 std::unique_ptr<CloningBindable> TransformCbuf::Clone() const noexcept
 {
 	return std::make_unique<TransformCbuf>(*this);
 }
-void TransformCbuf::UpdateBindImpl(Graphics& gfx, const Transforms& tf) noexcept
+void TransformCbuf::InitializeParentReference(const Drawable& parent) noexcept
+{
+	pParent = &parent;
+}
+void TransformCbuf::UpdateBindImpl(Graphics& gfx, CommandStream& cmd, const Transforms& tf) noexcept
 {
-	assert(pParent != nullptr);
-	pVcbuf->Update(gfx, tf);
-	pVcbuf->Bind(gfx);
+	pVcbuf->Update(cmd, tf);
+	pVcbuf->Bind(gfx, cmd);
 }
-TransformCbuf::Transforms TransformCbuf::GetTransforms(Graphics& gfx) noexcept
+TransformCbuf::Transforms TransformCbuf::GetTransforms(Graphics& gfx, DirectX::FXMMATRIX model) noexcept
 {
-	assert(pParent != nullptr);
-	const auto modelView = pParent->GetTransformXM() * gfx.GetCamera();
+	const auto modelView = model * gfx.GetCamera();
 	return {
 		DirectX::XMMatrixTranspose(modelView),
 		DirectX::XMMatrixTranspose(
@@ -38,5 +37,10 @@ TransformCbuf::Transforms TransformCbuf::GetTransforms(Graphics& gfx) noexcept
 		)
 	};
 }
+DirectX::XMMATRIX TransformCbuf::GetDecodeXM() const noexcept
+{
+	return pParent ? pParent->GetDecodeXM() : DirectX::XMMatrixIdentity();
+}
 
+std::once_flag TransformCbuf::vcbufCreated;
 std::unique_ptr<VertexConstantBuffer<TransformCbuf::Transforms>> TransformCbuf::pVcbuf;
\ No newline at end of file
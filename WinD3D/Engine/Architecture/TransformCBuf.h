@@ -1,11 +1,13 @@
 #pragma once
 #include <Engine/Architecture/ConstantBuffer.h>
-#include <Engine/Architecture/Drawable.h>
 #include <DirectXMath.h>
+#include <mutex>
+
+class Drawable;
 
 class TransformCbuf : public CloningBindable
 {
-protected:
+public:
 	struct Transforms
 	{
 		DirectX::XMMATRIX modelView;
@@ -13,13 +15,18 @@ protected:
 	};
 public:
 	TransformCbuf(Graphics& gfx, UINT slot = 0u);
-	void Bind(Graphics& gfx) noexcept override;
-	void InitializeParentReference(const Drawable& parent) noexcept override;
+	using CloningBindable::Bind;
+	void Bind(Graphics& gfx, CommandStream& cmd, DirectX::FXMMATRIX world) noexcept override;
 	std::unique_ptr<CloningBindable> Clone() const noexcept override;
+	void InitializeParentReference(const Drawable& parent) noexcept override;
 protected:
-	void UpdateBindImpl(Graphics& gfx, const Transforms& tf) noexcept;
-	Transforms GetTransforms(Graphics& gfx) noexcept;
+	void UpdateBindImpl(Graphics& gfx, CommandStream& cmd, const Transforms& tf) noexcept;
+	// model goes from the vertex buffer to world space, decode included
+	Transforms GetTransforms(Graphics& gfx, DirectX::FXMMATRIX model) noexcept;
+	DirectX::XMMATRIX GetDecodeXM() const noexcept;
 private:
-	static std::unique_ptr<VertexConstantBuffer<Transforms>> pVcbuf;
 	const Drawable* pParent = nullptr;
+	// shared by every instance, materials construct them on several threads at once
+	static std::once_flag vcbufCreated;
+	static std::unique_ptr<VertexConstantBuffer<Transforms>> pVcbuf;
 };
\ No newline at end of file
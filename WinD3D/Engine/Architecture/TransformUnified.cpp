@@ -3,22 +3,23 @@
 TransformUnified::TransformUnified(Graphics& gfx, UINT slotV, UINT slotP)
 	:TransformCbuf(gfx, slotV)
 {
-	if (!pPCBuf)
+	std::call_once(pcbufCreated, [&gfx, slotP]
 	{
 		pPCBuf = std::make_unique<PixelConstantBuffer<Transforms>>(gfx, slotP);
-	}
+	});
 }
 
-void TransformUnified::Bind(Graphics& gfx) noexcept
+void TransformUnified::Bind(Graphics& gfx, CommandStream& cmd, DirectX::FXMMATRIX world) noexcept
 {
-	const auto tf = GetTransforms(gfx);
-	TransformCbuf::UpdateBindImpl(gfx, tf);
-	UpdateBindImpl(gfx, tf);
+	const auto tf = GetTransforms(gfx, GetDecodeXM() * world);
+	TransformCbuf::UpdateBindImpl(gfx, cmd, tf);
+	UpdateBindImpl(gfx, cmd, tf);
 }
-void TransformUnified::UpdateBindImpl(Graphics& gfx, const Transforms& tf) noexcept
+void TransformUnified::UpdateBindImpl(Graphics& gfx, CommandStream& cmd, const Transforms& tf) noexcept
 {
-	pPCBuf->Update(gfx, tf);
-	pPCBuf->Bind(gfx);
+	pPCBuf->Update(cmd, tf);
+	pPCBuf->Bind(gfx, cmd);
 }
 
+std::once_flag TransformUnified::pcbufCreated;
 std::unique_ptr<PixelConstantBuffer<TransformCbuf::Transforms>> TransformUnified::pPCBuf;
\ No newline at end of file
@@ -6,9 +6,11 @@ class TransformUnified : public TransformCbuf
 public:
 	TransformUnified(Graphics& gfx, UINT slotV = 0u, UINT slotP = 0u);
 public:
-	void Bind(Graphics& gfx)noexcept override;
+	using TransformCbuf::Bind;
+	void Bind(Graphics& gfx, CommandStream& cmd, DirectX::FXMMATRIX world)noexcept override;
 protected:
-	void UpdateBindImpl(Graphics& gfx, const Transforms& tf)noexcept;
+	void UpdateBindImpl(Graphics& gfx, CommandStream& cmd, const Transforms& tf)noexcept;
 private:
+	static std::once_flag pcbufCreated;
 	static std::unique_ptr<PixelConstantBuffer<Transforms>>pPCBuf;
 };
\ No newline at end of file
@@ -7,7 +7,11 @@ VertexBuffer::VertexBuffer(Graphics& gfx, const DV::VertexBuffer& vbuf)
 {}
 VertexBuffer::VertexBuffer(Graphics& gfx, const std::string& tag, const DV::VertexBuffer& vbuf)
 	:
-	stride((UINT)vbuf.GetLayout().Size()),
+	VertexBuffer(gfx, tag, vbuf.data(), vbuf.Size(), (UINT)vbuf.GetLayout().Size())
+{}
+VertexBuffer::VertexBuffer(Graphics& gfx, const std::string& tag, const void* pVertices, size_t size, UINT stride)
+	:
+	stride(stride),
 	tag(tag)
 {
 	INFOMAN(gfx);
@@ -17,17 +21,17 @@ VertexBuffer::VertexBuffer(Graphics& gfx, const std::string& tag, const DV::Vert
 	bd.Usage = D3D11_USAGE_DEFAULT;
 	bd.CPUAccessFlags = 0u;
 	bd.MiscFlags = 0u;
-	bd.ByteWidth = UINT(vbuf.Size());
+	bd.ByteWidth = UINT(size);
 	bd.StructureByteStride = stride;
+	footprint = bd.ByteWidth;
 	D3D11_SUBRESOURCE_DATA sd = {};
-	sd.pSysMem = vbuf.data();
+	sd.pSysMem = pVertices;
 	GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&bd, &sd, &pVertexBuffer));
 }
 
-void VertexBuffer::Bind(Graphics& gfx) noexcept
+void VertexBuffer::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	const UINT offset = 0u;
-	GetContext(gfx)->IASetVertexBuffers(0u, 1u, pVertexBuffer.GetAddressOf(), &stride, &offset);
+	cmd.SetVertexBuffer(pVertexBuffer.Get(), stride);
 }
 std::shared_ptr<VertexBuffer> VertexBuffer::Resolve(Graphics& gfx, const std::string& tag,
 	const DV::VertexBuffer& vbuf)
@@ -35,12 +39,21 @@ std::shared_ptr<VertexBuffer> VertexBuffer::Resolve(Graphics& gfx, const std::st
 	assert(tag != "?");
 	return Codex::Resolve<VertexBuffer>(gfx, tag, vbuf);
 }
-std::string VertexBuffer::GenerateUID_(const std::string& tag)
+std::shared_ptr<VertexBuffer> VertexBuffer::Resolve(Graphics& gfx, const std::string& tag,
+	const void* pVertices, size_t size, UINT stride)
+{
+	assert(tag != "?");
+	return Codex::Resolve<VertexBuffer>(gfx, tag, pVertices, size, stride);
+}
+std::shared_ptr<VertexBuffer> VertexBuffer::Find(const std::string& tag) noexcept
+{
+	return Codex::Find<VertexBuffer>(GenerateUID_(tag));
+}
+BindableKey VertexBuffer::GenerateUID_(const std::string& tag)
 {
-	using namespace std::string_literals;
-	return typeid(VertexBuffer).name() + "#"s + tag;
+	return BindableKey::Of<VertexBuffer>().Mix(tag);
 }
-std::string VertexBuffer::GetUID() const noexcept
+BindableKey VertexBuffer::GetUID() const noexcept
 {
 	return GenerateUID(tag);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <Engine/Architecture/Bindable.h>
 #include <Engine/Architecture/VertexLayout.h>
+#include <Engine/Architecture/Codex.h>
 #include "GraphicsThrows.m"
 #include <memory>
 
@@ -9,18 +10,24 @@ class VertexBuffer : public Bindable
 public:
 	VertexBuffer(Graphics& gfx, const std::string& tag, const DV::VertexBuffer& vbuf);
 	VertexBuffer(Graphics& gfx, const DV::VertexBuffer& vbuf);
+	// size bytes of vertices already laid out, stride bytes apart
+	VertexBuffer(Graphics& gfx, const std::string& tag, const void* pVertices, size_t size, UINT stride);
 public:
-	void Bind(Graphics& gfx) noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
 	static std::shared_ptr<VertexBuffer> Resolve(Graphics& gfx, const std::string& tag,
 		const DV::VertexBuffer& vbuf);
+	static std::shared_ptr<VertexBuffer> Resolve(Graphics& gfx, const std::string& tag,
+		const void* pVertices, size_t size, UINT stride);
+	// what is cached under tag, nullptr if nothing is
+	static std::shared_ptr<VertexBuffer> Find(const std::string& tag) noexcept;
 	template<typename...Ignore>
-	static std::string GenerateUID(const std::string& tag, Ignore&&...ignore)
+	static BindableKey GenerateUID(const std::string& tag, Ignore&&...ignore)
 	{
 		return GenerateUID_(tag);
 	}
-	std::string GetUID() const noexcept override;
+	BindableKey GetUID() const noexcept override;
 private:
-	static std::string GenerateUID_(const std::string& tag);
+	static BindableKey GenerateUID_(const std::string& tag);
 protected:
 	std::string tag;
 	UINT stride;
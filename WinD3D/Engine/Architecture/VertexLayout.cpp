@@ -1,5 +1,8 @@
 #define DVTX_SOURCE_FILE
 #include "VertexLayout.h"
+#include <Framework/ParallelFor.h>
+#include <algorithm>
+#include <cmath>
 
 #if _DEBUG
 
@@ -13,29 +16,247 @@ std::array<std::wstring, size_t(DV::VertexLayout::ElementType::Count)> DV::Verte
 	L"Bitangent",
 	L"Float3Color",
 	L"Float4Color",
-	L"BGRAColor"
+	L"BGRAColor",
+	L"QuantizedPosition3D",
+	L"OctNormal",
+	L"OctTangent",
+	L"HalfTexture2D"
 };
 
 #endif
 
 namespace DV
 {
+	PositionQuantization PositionQuantization::FromPoints(const DirectX::XMFLOAT3* pPoints, size_t count) noexcept
+	{
+		PositionQuantization quantization;
+		if (count == 0u)
+		{
+			return quantization;
+		}
+		auto lo = pPoints[0];
+		auto hi = lo;
+		for (size_t i = 1u; i < count; i++)
+		{
+			const auto& p = pPoints[i];
+			lo = { std::min(lo.x,p.x),std::min(lo.y,p.y),std::min(lo.z,p.z) };
+			hi = { std::max(hi.x,p.x),std::max(hi.y,p.y),std::max(hi.z,p.z) };
+		}
+		quantization.origin = lo;
+		const auto extent = std::max({ hi.x - lo.x,hi.y - lo.y,hi.z - lo.z });
+		// a single point still needs something to divide by
+		quantization.extent = extent > 0.0f ? extent : 1.0f;
+		return quantization;
+	}
+	DirectX::PackedVector::XMUSHORTN4 PositionQuantization::Encode(const DirectX::XMFLOAT3& position) const noexcept
+	{
+		const auto inverse = 1.0f / extent;
+		return {
+			(position.x - origin.x) * inverse,
+			(position.y - origin.y) * inverse,
+			(position.z - origin.z) * inverse,
+			0.0f
+		};
+	}
+	DirectX::XMFLOAT3 PositionQuantization::Decode(const DirectX::PackedVector::XMUSHORTN4& position) const noexcept
+	{
+		DirectX::XMFLOAT3 decoded;
+		DirectX::XMStoreFloat3(&decoded, DirectX::XMVectorMultiplyAdd(
+			DirectX::PackedVector::XMLoadUShortN4(&position),
+			DirectX::XMVectorReplicate(extent),
+			DirectX::XMLoadFloat3(&origin)
+		));
+		return decoded;
+	}
+	DirectX::XMMATRIX PositionQuantization::GetDecodeXM() const noexcept
+	{
+		return DirectX::XMMatrixScaling(extent, extent, extent) *
+			DirectX::XMMatrixTranslation(origin.x, origin.y, origin.z);
+	}
+
+	DirectX::XMFLOAT2 EncodeOctahedral(const DirectX::XMFLOAT3& v) noexcept
+	{
+		const auto l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+		if (l1 == 0.0f)
+		{
+			return { 0.0f,0.0f };
+		}
+		const DirectX::XMFLOAT2 folded = { v.x / l1,v.y / l1 };
+		if (v.z >= 0.0f)
+		{
+			return folded;
+		}
+		// the lower half folds over the diagonals onto the corners of the square
+		const auto signOf = [](float f) { return f >= 0.0f ? 1.0f : -1.0f; };
+		return {
+			(1.0f - std::abs(folded.y)) * signOf(folded.x),
+			(1.0f - std::abs(folded.x)) * signOf(folded.y)
+		};
+	}
+
+	DirectX::XMFLOAT3 DecodeOctahedral(const DirectX::XMFLOAT2& e) noexcept
+	{
+		DirectX::XMFLOAT3 v = { e.x,e.y,1.0f - std::abs(e.x) - std::abs(e.y) };
+		const auto fold = std::clamp(-v.z, 0.0f, 1.0f);
+		v.x += v.x >= 0.0f ? -fold : fold;
+		v.y += v.y >= 0.0f ? -fold : fold;
+		DirectX::XMStoreFloat3(&v, DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&v)));
+		return v;
+	}
+
 	ConstVertex::ConstVertex(const Vertex& v) noxnd
 		:
 	vertex(v)
 	{}
 
+	namespace
+	{
+		// four aiVector3D as columns, x, y and z of all four per vector
+		DirectX::XMMATRIX LoadColumns4(const aiVector3D* pVectors) noexcept
+		{
+			static_assert(sizeof(aiVector3D) == sizeof(DirectX::XMFLOAT3), "aiVector3D must be 3 packed floats");
+			const auto p = reinterpret_cast<const DirectX::XMFLOAT3*>(pVectors);
+			return DirectX::XMMatrixTranspose({
+				DirectX::XMLoadFloat3(&p[0]),
+				DirectX::XMLoadFloat3(&p[1]),
+				DirectX::XMLoadFloat3(&p[2]),
+				DirectX::XMLoadFloat3(&p[3])
+			});
+		}
+		// EncodeOctahedral on four vectors at once, the same operations in the same order lane by lane
+		void EncodeOctahedral4(DirectX::FXMVECTOR x, DirectX::FXMVECTOR y, DirectX::FXMVECTOR z,
+			DirectX::XMFLOAT4A& ex, DirectX::XMFLOAT4A& ey) noexcept
+		{
+			using namespace DirectX;
+			const auto zero = XMVectorZero();
+			const auto one = XMVectorSplatOne();
+			const auto l1 = XMVectorAdd(XMVectorAdd(XMVectorAbs(x), XMVectorAbs(y)), XMVectorAbs(z));
+			const auto fx = XMVectorDivide(x, l1);
+			const auto fy = XMVectorDivide(y, l1);
+			const auto signX = XMVectorSelect(XMVectorNegate(one), one, XMVectorGreaterOrEqual(fx, zero));
+			const auto signY = XMVectorSelect(XMVectorNegate(one), one, XMVectorGreaterOrEqual(fy, zero));
+			const auto upper = XMVectorGreaterOrEqual(z, zero);
+			const auto degenerate = XMVectorEqual(l1, zero);
+			const auto rx = XMVectorSelect(XMVectorMultiply(XMVectorSubtract(one, XMVectorAbs(fy)), signX), fx, upper);
+			const auto ry = XMVectorSelect(XMVectorMultiply(XMVectorSubtract(one, XMVectorAbs(fx)), signY), fy, upper);
+			XMStoreFloat4A(&ex, XMVectorSelect(rx, zero, degenerate));
+			XMStoreFloat4A(&ey, XMVectorSelect(ry, zero, degenerate));
+		}
+	}
+
+	// copies one element of vertices [begin, end) from its aiMesh array into the interleaved
+	// buffer, pFirst being that element in vertex 0; reads the array front to back once and
+	// writes at the vertex stride. the formats that need encoding do four vertices per step
 	template<VertexLayout::ElementType type>
 	struct AttributeAiMeshFill
 	{
-		static constexpr void Exec(VertexBuffer* pBuf, const aiMesh& mesh) noxnd
+		static constexpr void Exec(unsigned char* pFirst, size_t stride, const aiMesh& mesh,
+			const PositionQuantization& quantization, size_t begin, size_t end) noxnd
+		{
+			using SysType = typename VertexLayout::Map<type>::SysType;
+			for (auto i = begin; i < end; i++)
+			{
+				*reinterpret_cast<SysType*>(pFirst + stride * i) = VertexLayout::Map<type>::Extract(mesh, i, quantization);
+			}
+		}
+	};
+	template<>
+	struct AttributeAiMeshFill<VertexLayout::ElementType::QuantizedPosition3D>
+	{
+		static void Exec(unsigned char* pFirst, size_t stride, const aiMesh& mesh,
+			const PositionQuantization& quantization, size_t begin, size_t end) noxnd
 		{
-			for (auto end = mesh.mNumVertices, i = 0u; i < end; i++)
+			using namespace DirectX;
+			// Encode, with the origin and scale loaded once
+			const auto origin = XMLoadFloat3(&quantization.origin);
+			const auto inverse = XMVectorReplicate(1.0f / quantization.extent);
+			const auto pPositions = reinterpret_cast<const XMFLOAT3*>(mesh.mVertices);
+			for (auto i = begin; i < end; i++)
 			{
-				(*pBuf)[i].Attr<type>() = VertexLayout::Map<type>::Extract(mesh, i);
+				PackedVector::XMStoreUShortN4(
+					reinterpret_cast<PackedVector::XMUSHORTN4*>(pFirst + stride * i),
+					XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&pPositions[i]), origin), inverse)
+				);
 			}
 		}
 	};
+	template<>
+	struct AttributeAiMeshFill<VertexLayout::ElementType::OctNormal>
+	{
+		static void Exec(unsigned char* pFirst, size_t stride, const aiMesh& mesh,
+			const PositionQuantization& quantization, size_t begin, size_t end) noxnd
+		{
+			using Map = VertexLayout::Map<VertexLayout::ElementType::OctNormal>;
+			auto i = begin;
+			for (; i + 4u <= end; i += 4u)
+			{
+				const auto n = LoadColumns4(&mesh.mNormals[i]);
+				DirectX::XMFLOAT4A ex, ey;
+				EncodeOctahedral4(n.r[0], n.r[1], n.r[2], ex, ey);
+				const float* px = &ex.x;
+				const float* py = &ey.x;
+				for (size_t k = 0; k < 4u; k++)
+				{
+					*reinterpret_cast<Map::SysType*>(pFirst + stride * (i + k)) = { px[k],py[k] };
+				}
+			}
+			for (; i < end; i++)
+			{
+				*reinterpret_cast<Map::SysType*>(pFirst + stride * i) = Map::Extract(mesh, i, quantization);
+			}
+		}
+	};
+	template<>
+	struct AttributeAiMeshFill<VertexLayout::ElementType::OctTangent>
+	{
+		static void Exec(unsigned char* pFirst, size_t stride, const aiMesh& mesh,
+			const PositionQuantization& quantization, size_t begin, size_t end) noxnd
+		{
+			using namespace DirectX;
+			using Map = VertexLayout::Map<VertexLayout::ElementType::OctTangent>;
+			auto i = begin;
+			for (; i + 4u <= end; i += 4u)
+			{
+				const auto n = LoadColumns4(&mesh.mNormals[i]);
+				const auto t = LoadColumns4(&mesh.mTangents[i]);
+				const auto b = LoadColumns4(&mesh.mBitangents[i]);
+				// ((n ^ t) * b) like aiVector3D works it out
+				const auto cx = XMVectorSubtract(XMVectorMultiply(n.r[1], t.r[2]), XMVectorMultiply(n.r[2], t.r[1]));
+				const auto cy = XMVectorSubtract(XMVectorMultiply(n.r[2], t.r[0]), XMVectorMultiply(n.r[0], t.r[2]));
+				const auto cz = XMVectorSubtract(XMVectorMultiply(n.r[0], t.r[1]), XMVectorMultiply(n.r[1], t.r[0]));
+				const auto dot = XMVectorAdd(XMVectorAdd(XMVectorMultiply(cx, b.r[0]), XMVectorMultiply(cy, b.r[1])), XMVectorMultiply(cz, b.r[2]));
+				XMFLOAT4A ex, ey, handedness;
+				EncodeOctahedral4(t.r[0], t.r[1], t.r[2], ex, ey);
+				XMStoreFloat4A(&handedness, XMVectorSelect(XMVectorZero(), XMVectorSplatOne(), XMVectorGreaterOrEqual(dot, XMVectorZero())));
+				const float* px = &ex.x;
+				const float* py = &ey.x;
+				const float* pw = &handedness.x;
+				for (size_t k = 0; k < 4u; k++)
+				{
+					*reinterpret_cast<Map::SysType*>(pFirst + stride * (i + k)) = { px[k] * 0.5f + 0.5f,py[k] * 0.5f + 0.5f,0.0f,pw[k] };
+				}
+			}
+			for (; i < end; i++)
+			{
+				*reinterpret_cast<Map::SysType*>(pFirst + stride * i) = Map::Extract(mesh, i, quantization);
+			}
+		}
+	};
+	template<>
+	struct AttributeAiMeshFill<VertexLayout::ElementType::HalfTexture2D>
+	{
+		static void Exec(unsigned char* pFirst, size_t stride, const aiMesh& mesh,
+			const PositionQuantization&, size_t begin, size_t end) noxnd
+		{
+			using namespace DirectX::PackedVector;
+			// u and v are two strided streams, converted as many at a time as the cpu does
+			const auto& first = mesh.mTextureCoords[0][begin];
+			auto pHalves = reinterpret_cast<HALF*>(pFirst + stride * begin);
+			XMConvertFloatToHalfStream(pHalves, stride, &first.x, sizeof(aiVector3D), end - begin);
+			XMConvertFloatToHalfStream(pHalves + 1, stride, &first.y, sizeof(aiVector3D), end - begin);
+		}
+	};
+
 	VertexBuffer::VertexBuffer(VertexLayout layout, size_t size) noxnd
 		:
 		layout(std::move(layout))
@@ -46,10 +267,33 @@ namespace DV
 		:
 		layout(std::move(layout_in))
 	{
+		if (layout.Has(VertexLayout::ElementType::QuantizedPosition3D))
+		{
+			static_assert(sizeof(aiVector3D) == sizeof(DirectX::XMFLOAT3), "aiVector3D must be 3 packed floats");
+			quantization = PositionQuantization::FromPoints(reinterpret_cast<const DirectX::XMFLOAT3*>(mesh.mVertices), mesh.mNumVertices);
+		}
 		Reserve(mesh.mNumVertices);
-		for (size_t i = 0, end = layout.GetElementCount(); i < end; i++)
+		// a chunk at a time, every element of it; its part of the buffer stays in cache between elements
+		const auto fill = [&](size_t chunk)
+		{
+			const auto begin = chunk * fillChunkSize;
+			const auto end = std::min(begin + fillChunkSize, size_t(mesh.mNumVertices));
+			for (size_t i = 0, count = layout.GetElementCount(); i < count; i++)
+			{
+				const auto& element = layout.ResolveByIndex(i);
+				VertexLayout::Bridge<AttributeAiMeshFill>(element.GetType(),
+					buffer.data() + element.GetOffset(), layout.Size(), mesh, quantization, begin, end);
+			}
+		};
+		const auto chunkCount = (size_t(mesh.mNumVertices) + fillChunkSize - 1u) / fillChunkSize;
+		// model loading already fills meshes in parallel, there this runs serially on its worker
+		if (chunkCount > 1u)
+		{
+			ParallelFor(chunkCount, fill);
+		}
+		else if (chunkCount == 1u)
 		{
-			VertexLayout::Bridge<AttributeAiMeshFill>(layout.ResolveByIndex(i).GetType(), this, mesh);
+			fill(0u);
 		}
 	}
 
@@ -58,6 +302,14 @@ namespace DV
 	{
 		return layout;
 	}
+	const PositionQuantization& VertexBuffer::GetQuantization() const noexcept
+	{
+		return quantization;
+	}
+	void VertexBuffer::SetQuantization(const PositionQuantization& quantization_in) noexcept
+	{
+		quantization = quantization_in;
+	}
 	size_t VertexBuffer::Count() const noxnd
 	{
 		return buffer.size() / layout.Size();
@@ -164,13 +416,6 @@ namespace DV
 	}
 	bool VertexLayout::Has(ElementType type) const noexcept
 	{
-		for (auto& e : elements)
-		{
-			if (e.GetType() == type)
-			{
-				return true;
-			}
-		}
-		return false;
+		return offsets[size_t(type)] != absent;
 	}
 }
@@ -3,13 +3,14 @@
 #include <array>
 #include <type_traits>
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
 #include <assimp/scene.h>
 #include <Framework\noexcept_if.h>
 #include <Framework\Utility.h>
 #include <Fmtlib\include\fmt\printf.h>
 #include <Engine\Graphics.h>
 
-#define DVTX_ELEMENT_AI_EXTRACTOR(member) static SysType Extract( const aiMesh& mesh, size_t i ) noexcept {return *reinterpret_cast<const SysType*>(&mesh.member[i]);}
+#define DVTX_ELEMENT_AI_EXTRACTOR(member) static SysType Extract( const aiMesh& mesh, size_t i, const PositionQuantization& ) noexcept {return *reinterpret_cast<const SysType*>(&mesh.member[i]);}
 
 #define LAYOUT_ELEMENT_TYPES \
 	X( Position2D ) \
@@ -21,6 +22,10 @@
 	X( Float3Color ) \
 	X( Float4Color ) \
 	X( BGRAColor ) \
+	X( QuantizedPosition3D ) \
+	X( OctNormal ) \
+	X( OctTangent ) \
+	X( HalfTexture2D ) \
 	X( Count )
 
 namespace DV
@@ -33,6 +38,27 @@ namespace DV
 		unsigned char b;
 	};
 
+	// quantized positions are 16 bit fractions of a cube around the mesh: origin + q * extent.
+	// one extent for all axes, so the decode is a uniform scale and normals transform as before
+	struct PositionQuantization
+	{
+		DirectX::XMFLOAT3 origin = { 0.0f,0.0f,0.0f };
+		float extent = 1.0f;
+
+		// the cube around the points, from its lowest corner
+		static PositionQuantization FromPoints(const DirectX::XMFLOAT3* pPoints, size_t count) noexcept;
+		DirectX::PackedVector::XMUSHORTN4 Encode(const DirectX::XMFLOAT3& position) const noexcept;
+		DirectX::XMFLOAT3 Decode(const DirectX::PackedVector::XMUSHORTN4& position) const noexcept;
+		// takes quantized positions to the mesh's space, goes before the mesh's transform
+		DirectX::XMMATRIX GetDecodeXM() const noexcept;
+	};
+
+	// unit vector folded onto the octahedron and flattened, both components in [-1,1];
+	// the zero vector comes out as (0,0), which decodes to +z
+	DirectX::XMFLOAT2 EncodeOctahedral(const DirectX::XMFLOAT3& v) noexcept;
+	// normalized, like the shaders' DecodeOctahedral
+	DirectX::XMFLOAT3 DecodeOctahedral(const DirectX::XMFLOAT2& e) noexcept;
+
 	class VertexLayout
 	{
 	public:
@@ -119,6 +145,60 @@ namespace DV
 			static constexpr const char* code = "C8";
 			DVTX_ELEMENT_AI_EXTRACTOR(mColors[0])
 		};
+		template<> struct Map<ElementType::QuantizedPosition3D>
+		{
+			// w is unused, 16 bit formats only come in twos and fours
+			using SysType = DirectX::PackedVector::XMUSHORTN4;
+			static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16B16A16_UNORM;
+			static constexpr const char* semantic = "Position";
+			static constexpr const char* code = "Pq";
+			static SysType Extract(const aiMesh& mesh, size_t i, const PositionQuantization& quantization) noexcept
+			{
+				return quantization.Encode(reinterpret_cast<const DirectX::XMFLOAT3&>(mesh.mVertices[i]));
+			}
+		};
+		template<> struct Map<ElementType::OctNormal>
+		{
+			using SysType = DirectX::PackedVector::XMSHORTN2;
+			static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16_SNORM;
+			static constexpr const char* semantic = "Normal";
+			static constexpr const char* code = "No";
+			static SysType Extract(const aiMesh& mesh, size_t i, const PositionQuantization&) noexcept
+			{
+				const auto oct = EncodeOctahedral(reinterpret_cast<const DirectX::XMFLOAT3&>(mesh.mNormals[i]));
+				return { oct.x,oct.y };
+			}
+		};
+		template<> struct Map<ElementType::OctTangent>
+		{
+			// x,y the tangent mapped to [0,1], z unused, w 1 where the bitangent is n x t, 0 where it is t x n;
+			// 10 bits is plenty for a vector that only orients the normal map
+			using SysType = DirectX::PackedVector::XMUDECN4;
+			static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R10G10B10A2_UNORM;
+			static constexpr const char* semantic = "Tangent";
+			static constexpr const char* code = "Nto";
+			static SysType Extract(const aiMesh& mesh, size_t i, const PositionQuantization&) noexcept
+			{
+				const auto& n = mesh.mNormals[i];
+				const auto& t = mesh.mTangents[i];
+				const auto& b = mesh.mBitangents[i];
+				const auto oct = EncodeOctahedral(reinterpret_cast<const DirectX::XMFLOAT3&>(t));
+				const bool rightHanded = ((n ^ t) * b) >= 0.0f;
+				return { oct.x * 0.5f + 0.5f,oct.y * 0.5f + 0.5f,0.0f,rightHanded ? 1.0f : 0.0f };
+			}
+		};
+		template<> struct Map<ElementType::HalfTexture2D>
+		{
+			using SysType = DirectX::PackedVector::XMHALF2;
+			static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16_FLOAT;
+			static constexpr const char* semantic = "Texcoord";
+			static constexpr const char* code = "Th";
+			static SysType Extract(const aiMesh& mesh, size_t i, const PositionQuantization&) noexcept
+			{
+				const auto& tc = mesh.mTextureCoords[0][i];
+				return { tc.x,tc.y };
+			}
+		};
 		template<> struct Map<ElementType::Count>
 		{
 			using SysType = long double;
@@ -164,6 +244,11 @@ namespace DV
 			ElementType type;
 			size_t offset;
 		};
+	public:
+		VertexLayout() noexcept
+		{
+			offsets.fill(absent);
+		}
 	public:
 		template <ElementType Type>
 		const Element& Resolve()const noxnd
@@ -181,6 +266,20 @@ namespace DV
 #endif
 			return elements.front();
 		}
+		// byte offset of the element in a vertex, one load from the table instead of a search
+		// through the elements; what the per vertex accessors go through
+		template <ElementType Type>
+		size_t Offset()const noxnd
+		{
+#if _DEBUG
+			if (offsets[size_t(Type)] == absent)
+			{
+				auto error = fmt::sprintf(L"Couldn't resolve type name %s", Typenames[size_t(Type)]);
+				_wassert(error.c_str(),__FILEW__,__LINE__);
+			}
+#endif
+			return offsets[size_t(Type)];
+		}
 		const Element& ResolveByIndex(size_t index)const noxnd
 		{
 #if _DEBUG
@@ -194,7 +293,10 @@ namespace DV
 		VertexLayout& operator +(ElementType Type)noxnd
 		{
 			if (!Has(Type))
+			{
+				offsets[size_t(Type)] = Size();
 				elements.emplace_back(Type, Size());
+			}
 			return *this;
 		}
 
@@ -231,7 +333,10 @@ namespace DV
 			return code;
 		}
 	private:
+		static constexpr size_t absent = ~size_t(0);
 		std::vector<Element> elements;
+		// offset of each element type, absent for those the layout doesn't have
+		std::array<size_t, size_t(ElementType::Count)> offsets;
 	};
 
 	class Vertex
@@ -259,14 +364,13 @@ namespace DV
 		template<VertexLayout::ElementType Type>
 		auto& Attr() noxnd
 		{
-			auto pAttribute = pData + layout.Resolve<Type>().GetOffset();
+			auto pAttribute = pData + layout.Offset<Type>();
 			return *reinterpret_cast<typename VertexLayout::Map<Type>::SysType*>(pAttribute);
 		}
 		template<VertexLayout::ElementType Type>
 		void Set(typename VertexLayout::Map<Type>::SysType&& val)
 		{
-			const auto& element = layout.Resolve<Type>();
-			auto pAttribute = pData + element.GetOffset();
+			auto pAttribute = pData + layout.Offset<Type>();
 
 			SetAttribute<Type>(pAttribute, std::forward<typename VertexLayout::Map<Type>::SysType>(val));
 		}
@@ -324,13 +428,54 @@ namespace DV
 		Vertex vertex;
 	};
 
+	// one attribute of every vertex in a buffer, stepping by the stride; for loops over the whole
+	// buffer, which then find the attribute once instead of once per vertex
+	template<VertexLayout::ElementType Type, bool IsConst = false>
+	class AttributeSpan
+	{
+		using Byte = std::conditional_t<IsConst, const unsigned char, unsigned char>;
+	public:
+		using SysType = std::conditional_t<IsConst,
+			const typename VertexLayout::Map<Type>::SysType,
+			typename VertexLayout::Map<Type>::SysType>;
+	public:
+		AttributeSpan(Byte* pFirst, size_t stride, size_t count) noexcept
+			:
+			pFirst(pFirst),
+			stride(stride),
+			count(count)
+		{}
+		SysType& operator[](size_t i) const noxnd
+		{
+			assert(i < count);
+			return *reinterpret_cast<SysType*>(pFirst + stride * i);
+		}
+		size_t Count() const noexcept
+		{
+			return count;
+		}
+	private:
+		Byte* pFirst;
+		size_t stride;
+		size_t count;
+	};
+	template<VertexLayout::ElementType Type>
+	using ConstAttributeSpan = AttributeSpan<Type, true>;
+
 	class VertexBuffer
 	{
+	public:
+		// vertices per fill chunk; meshes bigger than one chunk fill theirs on parallel threads
+		static constexpr size_t fillChunkSize = 1u << 15;
 	public:
 		VertexBuffer::VertexBuffer(VertexLayout layout, size_t size = 0) noxnd;
 		VertexBuffer(VertexLayout layout, const aiMesh& mesh);
 	public:
 		const VertexLayout& GetLayout() const noexcept;
+		// how the QuantizedPosition3D elements are encoded, if the layout has them
+		const PositionQuantization& GetQuantization() const noexcept;
+		// changing it moves every decoded position, e.g. scaling it scales the mesh
+		void SetQuantization(const PositionQuantization& quantization_in) noexcept;
 		size_t Count()const noxnd;
 		size_t Size() const noxnd;
 		const unsigned char* data()const noxnd;
@@ -353,8 +498,20 @@ namespace DV
 		{
 			return const_cast<VertexBuffer&>(*this)[i];
 		}
+
+		template<VertexLayout::ElementType Type>
+		AttributeSpan<Type> Span() noxnd
+		{
+			return { buffer.data() + layout.Offset<Type>(),layout.Size(),Count() };
+		}
+		template<VertexLayout::ElementType Type>
+		ConstAttributeSpan<Type> Span() const noxnd
+		{
+			return { buffer.data() + layout.Offset<Type>(),layout.Size(),Count() };
+		}
 	private:
 		VertexLayout layout;
+		PositionQuantization quantization;
 		std::vector<unsigned char> buffer;
 	};
 
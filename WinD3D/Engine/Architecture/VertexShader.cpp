@@ -15,11 +15,12 @@ VertexShader::VertexShader(Graphics& gfx, const std::string& path)
 		nullptr,
 		&pVertexShader
 	));
+	footprint = pBytecodeBlob->GetBufferSize();
 }
 
-void VertexShader::Bind(Graphics& gfx) noexcept
+void VertexShader::Bind(Graphics& gfx, CommandStream& cmd) noexcept
 {
-	GetContext(gfx)->VSSetShader(pVertexShader.Get(), nullptr, 0u);
+	cmd.SetVertexShader(pVertexShader.Get());
 }
 
 ID3DBlob* VertexShader::GetBytecode() const noexcept
@@ -31,12 +32,11 @@ std::shared_ptr<VertexShader> VertexShader::Resolve(Graphics& gfx, const std::st
 {
 	return Codex::Resolve<VertexShader>(gfx, path);
 }
-std::string VertexShader::GenerateUID(const std::string& path)
+BindableKey VertexShader::GenerateUID(const std::string& path)
 {
-	using namespace std::string_literals;
-	return typeid(VertexShader).name() + "#"s + path;
+	return BindableKey::Of<VertexShader>().Mix(path);
 }
-std::string VertexShader::GetUID() const noexcept
+BindableKey VertexShader::GetUID() const noexcept
 {
 	return GenerateUID(path);
 }
\ No newline at end of file
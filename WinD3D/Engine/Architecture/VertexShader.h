@@ -7,11 +7,11 @@ class VertexShader : public Bindable
 public:
 	VertexShader(Graphics& gfx, const std::string& path);
 public:
-	void Bind(Graphics& gfx) noexcept override;
+	void Bind(Graphics& gfx, CommandStream& cmd) noexcept override;
 	ID3DBlob* GetBytecode() const noexcept;
 	static std::shared_ptr<VertexShader> Resolve(Graphics& gfx, const std::string& path);
-	static std::string GenerateUID(const std::string& path);
-	std::string GetUID() const noexcept override;
+	static BindableKey GenerateUID(const std::string& path);
+	BindableKey GetUID() const noexcept override;
 protected:
 	std::string path;
 	Microsoft::WRL::ComPtr<ID3DBlob> pBytecodeBlob;
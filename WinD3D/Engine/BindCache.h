@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// shadow of the pipeline bindings last issued on the immediate context, so that
+// bindables can skip calls that would set what is already set
+class BindCache
+{
+public:
+	enum class Stage
+	{
+		Topology,
+		IndexBuffer,
+		VertexBuffer,
+		InputLayout,
+		VertexShader,
+		PixelShader,
+		VertexConstantBuffer,
+		PixelConstantBuffer,
+		PixelResource,
+		PixelSampler,
+		Blend,
+		DepthStencil,
+		Rasterizer,
+		Count
+	};
+	struct Stats
+	{
+		size_t issued = 0u;
+		size_t skipped = 0u;
+	};
+public:
+	BindCache() noexcept
+	{
+		Invalidate();
+	}
+	// true if the call has to be issued, records identity as bound in that case
+	bool Update(Stage stage, unsigned slot, const void* identity) noexcept
+	{
+		if (slot >= slotsPerStage)
+		{
+			current.issued++;
+			return true;
+		}
+		auto& bound = bindings[size_t(stage) * slotsPerStage + slot];
+		if (bound == uintptr_t(identity))
+		{
+			current.skipped++;
+			return false;
+		}
+		bound = uintptr_t(identity);
+		current.issued++;
+		return true;
+	}
+	// anything that touches the context behind the bindables' back (frame clears, imgui) has to call this
+	void Invalidate() noexcept
+	{
+		bindings.fill(unknown);
+	}
+	void NextFrame() noexcept
+	{
+		Invalidate();
+		last = current;
+		current = {};
+	}
+	const Stats& GetLastFrameStats() const noexcept
+	{
+		return last;
+	}
+private:
+	static constexpr size_t slotsPerStage = 16u;
+	// never a valid resource address or enum value, nullptr is a legit binding (null pixel shader)
+	static constexpr uintptr_t unknown = ~uintptr_t(0);
+	std::array<uintptr_t, size_t(Stage::Count) * slotsPerStage> bindings;
+	Stats current;
+	Stats last;
+};
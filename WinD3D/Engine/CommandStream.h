@@ -0,0 +1,226 @@
+#pragma once
+#include <d3d11.h>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <Framework/noexcept_if.h>
+
+// replay target of a CommandStream, one call per recorded command in recording order; Graphics
+// implements it over the immediate context, anything else (e.g. a recorder in a test) works headless
+class CommandBackend
+{
+public:
+	virtual ~CommandBackend() = default;
+	virtual void SetTopology(D3D11_PRIMITIVE_TOPOLOGY type) noexcept = 0;
+	virtual void SetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format) noexcept = 0;
+	virtual void SetVertexBuffer(ID3D11Buffer* pBuffer, UINT stride) noexcept = 0;
+	virtual void SetInputLayout(ID3D11InputLayout* pLayout) noexcept = 0;
+	virtual void SetVertexShader(ID3D11VertexShader* pShader) noexcept = 0;
+	virtual void SetPixelShader(ID3D11PixelShader* pShader) noexcept = 0;
+	virtual void SetVertexConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept = 0;
+	virtual void SetPixelConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept = 0;
+	virtual void SetPixelResource(UINT slot, ID3D11ShaderResourceView* pView) noexcept = 0;
+	virtual void SetPixelSampler(UINT slot, ID3D11SamplerState* pSampler) noexcept = 0;
+	virtual void SetBlend(ID3D11BlendState* pState) noexcept = 0;
+	virtual void SetDepthStencil(ID3D11DepthStencilState* pState) noexcept = 0;
+	virtual void SetRasterizer(ID3D11RasterizerState* pState) noexcept = 0;
+	// pData is 16 byte aligned and only valid for the duration of the call
+	virtual void UpdateBuffer(ID3D11Buffer* pBuffer, const void* pData, size_t size) noxnd = 0;
+	virtual void DrawIndexed(UINT count, UINT startIndex, INT baseVertex) noxnd = 0;
+	virtual void DrawIndexedInstanced(UINT count, UINT instances, UINT startIndex, INT baseVertex) noxnd = 0;
+};
+
+// flat list of pipeline commands recorded without touching the device context, so that
+// submission can be built on any thread and replayed later, in order, by a backend
+class CommandStream
+{
+public:
+	enum class Op : uint8_t
+	{
+		SetTopology,
+		SetIndexBuffer,
+		SetVertexBuffer,
+		SetInputLayout,
+		SetVertexShader,
+		SetPixelShader,
+		SetVertexConstantBuffer,
+		SetPixelConstantBuffer,
+		SetPixelResource,
+		SetPixelSampler,
+		SetBlend,
+		SetDepthStencil,
+		SetRasterizer,
+		UpdateBuffer,
+		DrawIndexed,
+		DrawIndexedInstanced,
+	};
+	// POD and non-owning, whoever recorded the object keeps it alive until replay
+	struct Command
+	{
+		Op op;
+		// binding slot, instance count for instanced draws
+		uint32_t slot;
+		// op dependent: stride, index format, index count or payload size
+		uint32_t arg;
+		// byte offset of an UpdateBuffer's data in the payload, start index of a draw
+		uint32_t offset;
+		// base vertex of a draw
+		int32_t base;
+		// the bound object, also its identity for redundant bind elimination
+		void* object;
+	};
+public:
+	void SetTopology(D3D11_PRIMITIVE_TOPOLOGY type) noexcept
+	{
+		Push(Op::SetTopology, 0u, uint32_t(type), (void*)uintptr_t(type));
+	}
+	void SetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format) noexcept
+	{
+		Push(Op::SetIndexBuffer, 0u, uint32_t(format), pBuffer);
+	}
+	void SetVertexBuffer(ID3D11Buffer* pBuffer, UINT stride) noexcept
+	{
+		Push(Op::SetVertexBuffer, 0u, stride, pBuffer);
+	}
+	void SetInputLayout(ID3D11InputLayout* pLayout) noexcept
+	{
+		Push(Op::SetInputLayout, 0u, 0u, pLayout);
+	}
+	void SetVertexShader(ID3D11VertexShader* pShader) noexcept
+	{
+		Push(Op::SetVertexShader, 0u, 0u, pShader);
+	}
+	void SetPixelShader(ID3D11PixelShader* pShader) noexcept
+	{
+		Push(Op::SetPixelShader, 0u, 0u, pShader);
+	}
+	void SetVertexConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept
+	{
+		Push(Op::SetVertexConstantBuffer, slot, 0u, pBuffer);
+	}
+	void SetPixelConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept
+	{
+		Push(Op::SetPixelConstantBuffer, slot, 0u, pBuffer);
+	}
+	void SetPixelResource(UINT slot, ID3D11ShaderResourceView* pView) noexcept
+	{
+		Push(Op::SetPixelResource, slot, 0u, pView);
+	}
+	void SetPixelSampler(UINT slot, ID3D11SamplerState* pSampler) noexcept
+	{
+		Push(Op::SetPixelSampler, slot, 0u, pSampler);
+	}
+	void SetBlend(ID3D11BlendState* pState) noexcept
+	{
+		Push(Op::SetBlend, 0u, 0u, pState);
+	}
+	void SetDepthStencil(ID3D11DepthStencilState* pState) noexcept
+	{
+		Push(Op::SetDepthStencil, 0u, 0u, pState);
+	}
+	void SetRasterizer(ID3D11RasterizerState* pState) noexcept
+	{
+		Push(Op::SetRasterizer, 0u, 0u, pState);
+	}
+	// data is copied into the stream, the source can go away right after recording
+	void UpdateBuffer(ID3D11Buffer* pBuffer, const void* pData, size_t size) noexcept
+	{
+		std::memcpy(UpdateBuffer(pBuffer, size), pData, size);
+	}
+	// returns the block for the caller to fill in place, valid until the next record call
+	void* UpdateBuffer(ID3D11Buffer* pBuffer, size_t size) noexcept
+	{
+		// keep every block 16 byte aligned so replay can hand out aligned pointers
+		const auto offset = (payload.size() + 15u) & ~size_t(15u);
+		payload.resize(offset + size);
+		commands.push_back({ Op::UpdateBuffer, 0u, uint32_t(size), uint32_t(offset), 0, pBuffer });
+		return payload.data() + offset;
+	}
+	void DrawIndexed(UINT count, UINT startIndex = 0u, INT baseVertex = 0) noexcept
+	{
+		commands.push_back({ Op::DrawIndexed, 0u, count, startIndex, baseVertex, nullptr });
+	}
+	void DrawIndexedInstanced(UINT count, UINT instances, UINT startIndex = 0u, INT baseVertex = 0) noexcept
+	{
+		commands.push_back({ Op::DrawIndexedInstanced, instances, count, startIndex, baseVertex, nullptr });
+	}
+	// keeps capacity, streams are meant to be reused frame to frame
+	void Clear() noexcept
+	{
+		commands.clear();
+		payload.clear();
+	}
+	size_t GetCommandCount() const noexcept
+	{
+		return commands.size();
+	}
+	const std::vector<Command>& GetCommands() const noexcept
+	{
+		return commands;
+	}
+	void Replay(CommandBackend& backend) const noxnd
+	{
+		for (const auto& c : commands)
+		{
+			switch (c.op)
+			{
+			case Op::SetTopology:
+				backend.SetTopology(D3D11_PRIMITIVE_TOPOLOGY(c.arg));
+				break;
+			case Op::SetIndexBuffer:
+				backend.SetIndexBuffer(static_cast<ID3D11Buffer*>(c.object), DXGI_FORMAT(c.arg));
+				break;
+			case Op::SetVertexBuffer:
+				backend.SetVertexBuffer(static_cast<ID3D11Buffer*>(c.object), c.arg);
+				break;
+			case Op::SetInputLayout:
+				backend.SetInputLayout(static_cast<ID3D11InputLayout*>(c.object));
+				break;
+			case Op::SetVertexShader:
+				backend.SetVertexShader(static_cast<ID3D11VertexShader*>(c.object));
+				break;
+			case Op::SetPixelShader:
+				backend.SetPixelShader(static_cast<ID3D11PixelShader*>(c.object));
+				break;
+			case Op::SetVertexConstantBuffer:
+				backend.SetVertexConstantBuffer(c.slot, static_cast<ID3D11Buffer*>(c.object));
+				break;
+			case Op::SetPixelConstantBuffer:
+				backend.SetPixelConstantBuffer(c.slot, static_cast<ID3D11Buffer*>(c.object));
+				break;
+			case Op::SetPixelResource:
+				backend.SetPixelResource(c.slot, static_cast<ID3D11ShaderResourceView*>(c.object));
+				break;
+			case Op::SetPixelSampler:
+				backend.SetPixelSampler(c.slot, static_cast<ID3D11SamplerState*>(c.object));
+				break;
+			case Op::SetBlend:
+				backend.SetBlend(static_cast<ID3D11BlendState*>(c.object));
+				break;
+			case Op::SetDepthStencil:
+				backend.SetDepthStencil(static_cast<ID3D11DepthStencilState*>(c.object));
+				break;
+			case Op::SetRasterizer:
+				backend.SetRasterizer(static_cast<ID3D11RasterizerState*>(c.object));
+				break;
+			case Op::UpdateBuffer:
+				backend.UpdateBuffer(static_cast<ID3D11Buffer*>(c.object), payload.data() + c.offset, size_t(c.arg));
+				break;
+			case Op::DrawIndexed:
+				backend.DrawIndexed(c.arg, c.offset, c.base);
+				break;
+			case Op::DrawIndexedInstanced:
+				backend.DrawIndexedInstanced(c.arg, c.slot, c.offset, c.base);
+				break;
+			}
+		}
+	}
+private:
+	void Push(Op op, uint32_t slot, uint32_t arg, void* object) noexcept
+	{
+		commands.push_back({ op, slot, arg, 0u, 0, object });
+	}
+private:
+	std::vector<Command> commands;
+	std::vector<unsigned char> payload;
+};
@@ -0,0 +1,217 @@
+#include "BoundingVolumeHierarchy.h"
+#include <Framework/PerfLog.h>
+#include <algorithm>
+#include <numeric>
+#include <cfloat>
+
+namespace dx = DirectX;
+
+namespace
+{
+	// half the surface area, the factor of 2 cancels out in every cost comparison
+	float HalfArea(dx::FXMVECTOR min, dx::FXMVECTOR max) noexcept
+	{
+		dx::XMFLOAT3 d;
+		dx::XMStoreFloat3(&d, dx::XMVectorMax(dx::XMVectorSubtract(max, min), dx::XMVectorZero()));
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+	float Component(const dx::XMFLOAT3& v, uint32_t axis) noexcept
+	{
+		return (&v.x)[axis];
+	}
+}
+
+void BoundingVolumeHierarchy::Build(const std::vector<DirectX::BoundingBox>& boxes)
+{
+	PERF_SCOPE("BVH::Build");
+	nodes.clear();
+	primitives.resize(boxes.size());
+	std::iota(primitives.begin(), primitives.end(), 0u);
+	if (boxes.empty())
+	{
+		return;
+	}
+	std::vector<dx::XMFLOAT3> mins(boxes.size());
+	std::vector<dx::XMFLOAT3> maxs(boxes.size());
+	std::vector<dx::XMFLOAT3> centroids(boxes.size());
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		const auto center = dx::XMLoadFloat3(&boxes[i].Center);
+		const auto extents = dx::XMLoadFloat3(&boxes[i].Extents);
+		dx::XMStoreFloat3(&mins[i], dx::XMVectorSubtract(center, extents));
+		dx::XMStoreFloat3(&maxs[i], dx::XMVectorAdd(center, extents));
+		centroids[i] = boxes[i].Center;
+	}
+	// a binary tree with at least one primitive per leaf never has more than 2n - 1 nodes
+	nodes.reserve(boxes.size() * 2u - 1u);
+	BuildNode(0u, uint32_t(boxes.size()), mins, maxs, centroids);
+}
+
+uint32_t BoundingVolumeHierarchy::BuildNode(uint32_t first, uint32_t count, const std::vector<DirectX::XMFLOAT3>& mins,
+	const std::vector<DirectX::XMFLOAT3>& maxs, const std::vector<DirectX::XMFLOAT3>& centroids)
+{
+	const auto index = uint32_t(nodes.size());
+	nodes.emplace_back();
+
+	auto boundsMin = dx::XMVectorReplicate(FLT_MAX);
+	auto boundsMax = dx::XMVectorReplicate(-FLT_MAX);
+	auto centroidMin = boundsMin;
+	auto centroidMax = boundsMax;
+	for (auto i = first; i < first + count; i++)
+	{
+		const auto p = primitives[i];
+		boundsMin = dx::XMVectorMin(boundsMin, dx::XMLoadFloat3(&mins[p]));
+		boundsMax = dx::XMVectorMax(boundsMax, dx::XMLoadFloat3(&maxs[p]));
+		const auto centroid = dx::XMLoadFloat3(&centroids[p]);
+		centroidMin = dx::XMVectorMin(centroidMin, centroid);
+		centroidMax = dx::XMVectorMax(centroidMax, centroid);
+	}
+	dx::XMStoreFloat3(&nodes[index].min, boundsMin);
+	dx::XMStoreFloat3(&nodes[index].max, boundsMax);
+
+	if (count <= maxLeafSize)
+	{
+		nodes[index].offset = first;
+		nodes[index].count = count;
+		return index;
+	}
+
+	// split along the axis the centroids spread the most
+	dx::XMFLOAT3 extent;
+	dx::XMFLOAT3 lowest;
+	dx::XMStoreFloat3(&extent, dx::XMVectorSubtract(centroidMax, centroidMin));
+	dx::XMStoreFloat3(&lowest, centroidMin);
+	const uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0u : (extent.y >= extent.z ? 1u : 2u);
+	const auto axisExtent = Component(extent, axis);
+	const auto axisMin = Component(lowest, axis);
+
+	auto mid = first + count / 2u;
+	bool split = false;
+	if (axisExtent > 0.0f)
+	{
+		struct Bin
+		{
+			dx::XMVECTOR min = dx::XMVectorReplicate(FLT_MAX);
+			dx::XMVECTOR max = dx::XMVectorReplicate(-FLT_MAX);
+			uint32_t count = 0u;
+		};
+		Bin bins[binCount];
+		const auto scale = float(binCount) / axisExtent;
+		const auto binOf = [&](uint32_t p)
+		{
+			return std::min(uint32_t((Component(centroids[p], axis) - axisMin) * scale), binCount - 1u);
+		};
+		for (auto i = first; i < first + count; i++)
+		{
+			const auto p = primitives[i];
+			auto& bin = bins[binOf(p)];
+			bin.min = dx::XMVectorMin(bin.min, dx::XMLoadFloat3(&mins[p]));
+			bin.max = dx::XMVectorMax(bin.max, dx::XMLoadFloat3(&maxs[p]));
+			bin.count++;
+		}
+		// cost of everything right of each split plane, swept from the right
+		float rightCosts[binCount] = {};
+		uint32_t rightCounts[binCount] = {};
+		Bin right;
+		for (auto b = binCount - 1u; b > 0u; b--)
+		{
+			right.min = dx::XMVectorMin(right.min, bins[b].min);
+			right.max = dx::XMVectorMax(right.max, bins[b].max);
+			right.count += bins[b].count;
+			rightCounts[b] = right.count;
+			rightCosts[b] = float(right.count) * HalfArea(right.min, right.max);
+		}
+		// then the left side swept from the left, split b puts bins [0, b) on the left
+		auto bestCost = FLT_MAX;
+		uint32_t bestSplit = 0u;
+		Bin left;
+		for (auto b = 1u; b < binCount; b++)
+		{
+			left.min = dx::XMVectorMin(left.min, bins[b - 1u].min);
+			left.max = dx::XMVectorMax(left.max, bins[b - 1u].max);
+			left.count += bins[b - 1u].count;
+			if (left.count == 0u || rightCounts[b] == 0u)
+			{
+				continue;
+			}
+			const auto cost = float(left.count) * HalfArea(left.min, left.max) + rightCosts[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = b;
+			}
+		}
+		// a split that costs more than testing everything isn't worth it, unless the leaf would grow too big
+		const auto leafCost = float(count) * HalfArea(boundsMin, boundsMax);
+		if (bestSplit != 0u && bestCost >= leafCost && count <= maxLeafSize * 4u)
+		{
+			nodes[index].offset = first;
+			nodes[index].count = count;
+			return index;
+		}
+		if (bestSplit != 0u)
+		{
+			mid = uint32_t(std::partition(primitives.begin() + first, primitives.begin() + first + count,
+				[&](uint32_t p) { return binOf(p) < bestSplit; }) - primitives.begin());
+			split = true;
+		}
+	}
+	if (!split)
+	{
+		// centroids coincide or fell into one bin, halve by count instead
+		std::nth_element(primitives.begin() + first, primitives.begin() + mid, primitives.begin() + first + count,
+			[&](uint32_t a, uint32_t b) { return Component(centroids[a], axis) < Component(centroids[b], axis); });
+	}
+
+	BuildNode(first, mid - first, mins, maxs, centroids);
+	const auto second = BuildNode(mid, first + count - mid, mins, maxs, centroids);
+	nodes[index].offset = second;
+	nodes[index].count = 0u;
+	return index;
+}
+
+void BoundingVolumeHierarchy::Refit(const std::vector<DirectX::BoundingBox>& boxes) noexcept
+{
+	PERF_SCOPE("BVH::Refit");
+	// children always come after their parent, so walking backwards sees them refit first
+	for (auto i = nodes.size(); i-- > 0u; )
+	{
+		auto& node = nodes[i];
+		auto lo = dx::XMVectorReplicate(FLT_MAX);
+		auto hi = dx::XMVectorReplicate(-FLT_MAX);
+		if (node.count != 0u)
+		{
+			for (auto j = node.offset; j < node.offset + node.count; j++)
+			{
+				const auto& box = boxes[primitives[j]];
+				const auto center = dx::XMLoadFloat3(&box.Center);
+				const auto extents = dx::XMLoadFloat3(&box.Extents);
+				lo = dx::XMVectorMin(lo, dx::XMVectorSubtract(center, extents));
+				hi = dx::XMVectorMax(hi, dx::XMVectorAdd(center, extents));
+			}
+		}
+		else
+		{
+			const auto& a = nodes[i + 1u];
+			const auto& b = nodes[node.offset];
+			lo = dx::XMVectorMin(dx::XMLoadFloat3(&a.min), dx::XMLoadFloat3(&b.min));
+			hi = dx::XMVectorMax(dx::XMLoadFloat3(&a.max), dx::XMLoadFloat3(&b.max));
+		}
+		dx::XMStoreFloat3(&node.min, lo);
+		dx::XMStoreFloat3(&node.max, hi);
+	}
+}
+
+bool BoundingVolumeHierarchy::IntersectsRay(const Node& node, DirectX::FXMVECTOR origin, DirectX::FXMVECTOR invDirection, float maxDistance, float& entry) noexcept
+{
+	// slab test, the w lane is ignored
+	const auto t1 = dx::XMVectorMultiply(dx::XMVectorSubtract(dx::XMLoadFloat3(&node.min), origin), invDirection);
+	const auto t2 = dx::XMVectorMultiply(dx::XMVectorSubtract(dx::XMLoadFloat3(&node.max), origin), invDirection);
+	dx::XMFLOAT3 tNear;
+	dx::XMFLOAT3 tFar;
+	dx::XMStoreFloat3(&tNear, dx::XMVectorMin(t1, t2));
+	dx::XMStoreFloat3(&tFar, dx::XMVectorMax(t1, t2));
+	entry = std::max({ tNear.x,tNear.y,tNear.z,0.0f });
+	const auto exit = std::min({ tFar.x,tFar.y,tFar.z,maxDistance });
+	return entry <= exit;
+}
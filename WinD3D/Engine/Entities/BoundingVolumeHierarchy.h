@@ -0,0 +1,150 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+#include <cstdint>
+
+// binned SAH tree over a list of boxes; primitives are referred to by their index in the
+// list the tree was built from, so the same tree serves meshes in a scene and triangles in a mesh
+class BoundingVolumeHierarchy
+{
+public:
+	void Build(const std::vector<DirectX::BoundingBox>& boxes);
+	// recomputes node bounds for moved primitives, boxes must list the primitives of the build
+	void Refit(const std::vector<DirectX::BoundingBox>& boxes) noexcept;
+	size_t GetPrimitiveCount() const noexcept
+	{
+		return primitives.size();
+	}
+	size_t GetNodeCount() const noexcept
+	{
+		return nodes.size();
+	}
+	// calls visit(primitive) for the primitives of every leaf not entirely outside frustum;
+	// leaves aren't split further, so a few primitives just outside may be visited too
+	template<typename F>
+	void QueryFrustum(const DirectX::BoundingFrustum& frustum, F&& visit) const
+	{
+		if (nodes.empty())
+		{
+			return;
+		}
+		// node and whether it is already known to be inside, so its subtree needs no more tests
+		std::vector<std::pair<uint32_t, bool>> stack;
+		stack.reserve(64u);
+		stack.push_back({ 0u,false });
+		while (!stack.empty())
+		{
+			const auto [index, inside] = stack.back();
+			stack.pop_back();
+			const auto& node = nodes[index];
+			auto containment = DirectX::CONTAINS;
+			if (!inside)
+			{
+				DirectX::BoundingBox box;
+				DirectX::BoundingBox::CreateFromPoints(box, DirectX::XMLoadFloat3(&node.min), DirectX::XMLoadFloat3(&node.max));
+				containment = frustum.Contains(box);
+				if (containment == DirectX::DISJOINT)
+				{
+					continue;
+				}
+			}
+			if (node.count != 0u)
+			{
+				for (auto i = node.offset; i < node.offset + node.count; i++)
+				{
+					visit(primitives[i]);
+				}
+				continue;
+			}
+			stack.push_back({ node.offset,containment == DirectX::CONTAINS });
+			stack.push_back({ index + 1u,containment == DirectX::CONTAINS });
+		}
+	}
+	// visits the primitives whose boxes the ray enters before the nearest hit so far, nearer
+	// nodes first; hit(primitive, maxDistance) returns the distance of a nearer hit on the
+	// primitive, or maxDistance for a miss. direction must be normalized, returns the nearest hit
+	template<typename F>
+	float QueryRay(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance, F&& hit) const
+	{
+		if (nodes.empty())
+		{
+			return maxDistance;
+		}
+		const auto invDirection = DirectX::XMVectorReciprocal(direction);
+		float entry;
+		if (!IntersectsRay(nodes[0], origin, invDirection, maxDistance, entry))
+		{
+			return maxDistance;
+		}
+		// node and the distance at which the ray enters it
+		std::vector<std::pair<uint32_t, float>> stack;
+		stack.reserve(64u);
+		stack.push_back({ 0u,entry });
+		while (!stack.empty())
+		{
+			const auto [index, nodeEntry] = stack.back();
+			stack.pop_back();
+			// a nearer hit may have turned up since the node was pushed
+			if (nodeEntry >= maxDistance)
+			{
+				continue;
+			}
+			const auto& node = nodes[index];
+			if (node.count != 0u)
+			{
+				for (auto i = node.offset; i < node.offset + node.count; i++)
+				{
+					maxDistance = hit(primitives[i], maxDistance);
+				}
+				continue;
+			}
+			float nearEntry;
+			float farEntry;
+			const bool nearHit = IntersectsRay(nodes[index + 1u], origin, invDirection, maxDistance, nearEntry);
+			const bool farHit = IntersectsRay(nodes[node.offset], origin, invDirection, maxDistance, farEntry);
+			auto nearChild = index + 1u;
+			auto farChild = node.offset;
+			if (nearHit && farHit && farEntry < nearEntry)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearEntry, farEntry);
+			}
+			// far child goes on the stack first so the near one is visited next
+			if (nearHit && farHit)
+			{
+				stack.push_back({ farChild,farEntry });
+				stack.push_back({ nearChild,nearEntry });
+			}
+			else if (nearHit)
+			{
+				stack.push_back({ nearChild,nearEntry });
+			}
+			else if (farHit)
+			{
+				stack.push_back({ farChild,farEntry });
+			}
+		}
+		return maxDistance;
+	}
+private:
+	struct Node
+	{
+		DirectX::XMFLOAT3 min;
+		// leaf: first of its entries in primitives, interior: index of the second child,
+		// the first child always directly follows its parent
+		uint32_t offset;
+		DirectX::XMFLOAT3 max;
+		// primitives in a leaf, 0 for interior nodes
+		uint32_t count;
+	};
+private:
+	uint32_t BuildNode(uint32_t first, uint32_t count, const std::vector<DirectX::XMFLOAT3>& mins,
+		const std::vector<DirectX::XMFLOAT3>& maxs, const std::vector<DirectX::XMFLOAT3>& centroids);
+	static bool IntersectsRay(const Node& node, DirectX::FXMVECTOR origin, DirectX::FXMVECTOR invDirection, float maxDistance, float& entry) noexcept;
+private:
+	static constexpr uint32_t binCount = 16u;
+	static constexpr uint32_t maxLeafSize = 4u;
+	std::vector<Node> nodes;
+	std::vector<uint32_t> primitives;
+};
@@ -1,17 +1,298 @@
 #include "Mesh.h"
+#include <Engine/Architecture/Material.h>
+#include <Engine/Architecture/Technique.h>
+#include <Engine/Architecture/TechniqueProbe.h>
+#include <Engine/Architecture/DynamicConstant.h>
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace dx = DirectX;
+
+namespace
+{
+	// records technique states and buffers of a drawable, in visiting order
+	class LodRecorder : public TechniqueProbe
+	{
+		friend class LodApplier;
+	protected:
+		void OnSetTechnique() override
+		{
+			active.push_back(pTech->IsActive());
+		}
+		bool OnVisitBuffer(DC::Buffer& buf) override
+		{
+			buffers.push_back(buf);
+			return false;
+		}
+	private:
+		std::vector<bool> active;
+		std::vector<DC::Buffer> buffers;
+	};
+
+	// applies what a recorder saw to a drawable made from the same material
+	class LodApplier : public TechniqueProbe
+	{
+	public:
+		LodApplier(const LodRecorder& recorder) noexcept
+			:
+			recorder(recorder)
+		{}
+	protected:
+		void OnSetTechnique() override
+		{
+			pTech->SetActiveState(recorder.active[techIdx]);
+		}
+		bool OnVisitBuffer(DC::Buffer& buf) override
+		{
+			buf.CopyFrom(recorder.buffers[bufIdx]);
+			return true;
+		}
+	private:
+		const LodRecorder& recorder;
+	};
+}
 
 // Mesh
-Mesh::Mesh(Graphics& gfx, const Material& mat, const aiMesh& mesh, float scale) noxnd
-	:Drawable(gfx, mat, mesh, scale)
-{}
+Mesh::Mesh(Graphics& gfx, const Material& mat, const ModelCache::MeshView& mesh, bool buildLods) noxnd
+	:Drawable(gfx, mat,
+		mat.MakeVertexBindable(gfx, mesh.name, mesh.pVertices, mesh.vertexCount * mesh.stride),
+		mat.MakeIndexBindable(gfx, mesh.name, 0u, [&mesh]
+		{
+			return std::vector<uint32_t>(mesh.lods[0].pIndices, mesh.lods[0].pIndices + mesh.lods[0].count);
+		})),
+	opaque(!mat.IsMasked())
+{
+	static_assert(maxLods <= ModelCache::maxLods, "cache must hold every lod");
+	assert(mesh.stride == mat.GetVertexLayout().Size());
+	positions.resize(mesh.vertexCount);
+	const auto& layout = mat.GetVertexLayout();
+	if (layout.Has(DV::Type::QuantizedPosition3D))
+	{
+		// the gpu decodes them as part of the transform, see Drawable::SetDecode
+		const auto offset = layout.Offset<DV::Type::QuantizedPosition3D>();
+		for (size_t i = 0; i < mesh.vertexCount; i++)
+		{
+			dx::PackedVector::XMUSHORTN4 encoded;
+			std::memcpy(&encoded, mesh.pVertices + i * mesh.stride + offset, sizeof(encoded));
+			positions[i] = mesh.quantization.Decode(encoded);
+		}
+		SetDecode(mesh.quantization.GetDecodeXM());
+	}
+	else
+	{
+		const auto offset = layout.Offset<DV::Type::Position3D>();
+		for (size_t i = 0; i < mesh.vertexCount; i++)
+		{
+			std::memcpy(&positions[i], mesh.pVertices + i * mesh.stride + offset, sizeof(dx::XMFLOAT3));
+		}
+	}
+	indices.assign(mesh.lods[0].pIndices, mesh.lods[0].pIndices + mesh.lods[0].count);
+	BuildBounds();
+	for (size_t lod = 1u; lod < std::min(mesh.lodCount, maxLods); lod++)
+	{
+		const auto& span = mesh.lods[lod];
+		AddLod(gfx, mat, mesh.name, { span.pIndices, span.pIndices + span.count });
+	}
+	if (buildLods)
+	{
+		BuildLods(gfx, mat, mesh.name);
+	}
+}
+
+Mesh::Mesh(Graphics& gfx, const Material& mat, std::shared_ptr<VertexBuffer> pVertices_in, std::vector<std::shared_ptr<IndexBuffer>> lodBuffers,
+	const DV::PositionQuantization& quantization, std::vector<DirectX::XMFLOAT3> positions_in, std::vector<uint32_t> indices_in) noxnd
+	:Drawable(gfx, mat, std::move(pVertices_in), lodBuffers.front()),
+	positions(std::move(positions_in)),
+	indices(std::move(indices_in)),
+	opaque(!mat.IsMasked())
+{
+	assert(lodBuffers.size() <= maxLods);
+	if (mat.GetVertexLayout().Has(DV::Type::QuantizedPosition3D))
+	{
+		SetDecode(quantization.GetDecodeXM());
+	}
+	BuildBounds();
+	for (size_t lod = 1u; lod < lodBuffers.size(); lod++)
+	{
+		lods.push_back(std::make_unique<Drawable>(gfx, mat, pVertices, std::move(lodBuffers[lod])));
+		lods.back()->SetDecode(GetDecodeXM());
+		lodIndices.emplace_back();
+	}
+}
+
+void Mesh::BuildBounds() noexcept
+{
+	dx::BoundingBox::CreateFromPoints(box, positions.size(), positions.data(), sizeof(dx::XMFLOAT3));
+	dx::BoundingSphere::CreateFromPoints(sphere, positions.size(), positions.data(), sizeof(dx::XMFLOAT3));
+
+	std::vector<dx::BoundingBox> triangleBoxes;
+	triangleBoxes.reserve(indices.size() / 3u);
+	for (size_t i = 0; i + 2u < indices.size(); i += 3u)
+	{
+		const auto a = dx::XMLoadFloat3(&positions[indices[i]]);
+		const auto b = dx::XMLoadFloat3(&positions[indices[i + 1u]]);
+		const auto c = dx::XMLoadFloat3(&positions[indices[i + 2u]]);
+		auto& box = triangleBoxes.emplace_back();
+		dx::BoundingBox::CreateFromPoints(box, dx::XMVectorMin(a, dx::XMVectorMin(b, c)), dx::XMVectorMax(a, dx::XMVectorMax(b, c)));
+	}
+	triangles.Build(triangleBoxes);
+}
+
+void Mesh::BuildLods(Graphics& gfx, const Material& mat, std::string_view name) noxnd
+{
+	// every lod aims at half the triangles of the one before; the error allowed is about a
+	// pixel at the lod's switch point on a 720 line screen, and doubles with it
+	auto switchCoverage = lodCoverage;
+	while (lods.size() + 1u < maxLods)
+	{
+		const auto& coarsest = lodIndices.empty() ? indices : lodIndices.back();
+		if (coarsest.size() / 3u < minLodTriangles * 2u)
+		{
+			break;
+		}
+		const auto maxError = sphere.Radius / (switchCoverage * 360.0f);
+		auto simplified = MeshSimplifier::Simplify(positions, coarsest, coarsest.size() / 6u * 3u, maxError);
+		// borders and seams don't move, once those are all that's left it stops paying off
+		if (simplified.size() > coarsest.size() * 3u / 4u)
+		{
+			break;
+		}
+		// collapses leave triangles where they were, not in cache order
+		AddLod(gfx, mat, name, MeshOptimizer::OptimizeTriangles(positions, simplified));
+		switchCoverage *= 0.5f;
+	}
+}
+
+void Mesh::AddLod(Graphics& gfx, const Material& mat, std::string_view name, std::vector<uint32_t> indices_in) noxnd
+{
+	lods.push_back(std::make_unique<Drawable>(gfx, mat, pVertices,
+		mat.MakeIndexBindable(gfx, name, lods.size() + 1u, indices_in)));
+	lods.back()->SetDecode(GetDecodeXM());
+	lodIndices.push_back(std::move(indices_in));
+}
+
+void Mesh::Submit(FrameCommander& frame, DirectX::FXMMATRIX world, size_t lod) const noxnd
+{
+	if (lod == 0u)
+	{
+		Drawable::Submit(frame, world);
+	}
+	else
+	{
+		lods[lod - 1u]->Submit(frame, world);
+	}
+}
+
+size_t Mesh::GetLodCount() const noexcept
+{
+	return lods.size() + 1u;
+}
+
+size_t Mesh::GetTriangleCount(size_t lod) const noexcept
+{
+	return (lod == 0u ? GetIndexCount() : lods[lod - 1u]->GetIndexCount()) / 3u;
+}
+
+size_t Mesh::SelectLod(float coverage, size_t current) const noexcept
+{
+	// switch point of lod i is lodCoverage / 2^(i - 1)
+	const auto switchPoint = [](size_t lod)
+	{
+		return lodCoverage / float(1u << (lod - 1u));
+	};
+	auto lod = std::min(current, lods.size());
+	while (lod < lods.size() && coverage < switchPoint(lod + 1u) * (1.0f - lodHysteresis))
+	{
+		lod++;
+	}
+	while (lod > 0u && coverage > switchPoint(lod) * (1.0f + lodHysteresis))
+	{
+		lod--;
+	}
+	return lod;
+}
+
+void Mesh::Accept(TechniqueProbe& probe)
+{
+	Drawable::Accept(probe);
+	if (lods.empty())
+	{
+		return;
+	}
+	// lods are built from the same material, so techniques and buffers line up one to one
+	LodRecorder recorder;
+	Drawable::Accept(recorder);
+	for (auto& pLod : lods)
+	{
+		LodApplier applier{ recorder };
+		pLod->Accept(applier);
+	}
+}
+
+void Mesh::ShareBuffers(const std::shared_ptr<VertexBuffer>& pVertices_in, const std::shared_ptr<IndexBuffer>& pIndices_in,
+	const std::vector<SharedRange>& lodRanges) noexcept
+{
+	assert(lodRanges.size() == GetLodCount());
+	for (size_t lod = 0; lod < lodRanges.size(); lod++)
+	{
+		const auto& r = lodRanges[lod];
+		assert(r.indexCount == GetTriangleCount(lod) * 3u);
+		Drawable& drawable = lod == 0u ? *this : *lods[lod - 1u];
+		drawable.ShareBuffers(pVertices_in, pIndices_in, r.startIndex, r.indexCount, r.baseVertex);
+	}
+}
+
+const DirectX::BoundingBox& Mesh::GetBoundingBox() const noexcept
+{
+	return box;
+}
+
+const DirectX::BoundingSphere& Mesh::GetBoundingSphere() const noexcept
+{
+	return sphere;
+}
+
+float Mesh::IntersectRay(DirectX::FXMMATRIX world, DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance) const noexcept
+{
+	// test in the mesh's space; the transform may scale, so distances are converted both ways
+	const auto inverse = dx::XMMatrixInverse(nullptr, world);
+	const auto localOrigin = dx::XMVector3TransformCoord(origin, inverse);
+	auto localDirection = dx::XMVector3TransformNormal(direction, inverse);
+	const auto localPerWorld = dx::XMVectorGetX(dx::XMVector3Length(localDirection));
+	localDirection = dx::XMVectorScale(localDirection, 1.0f / localPerWorld);
+
+	bool hit = false;
+	const auto nearest = triangles.QueryRay(localOrigin, localDirection, maxDistance * localPerWorld,
+		[&](uint32_t triangle, float nearestSoFar)
+		{
+			const auto pIndices = &indices[size_t(triangle) * 3u];
+			float distance;
+			if (dx::TriangleTests::Intersects(localOrigin, localDirection,
+				dx::XMLoadFloat3(&positions[pIndices[0]]),
+				dx::XMLoadFloat3(&positions[pIndices[1]]),
+				dx::XMLoadFloat3(&positions[pIndices[2]]), distance) && distance < nearestSoFar)
+			{
+				hit = true;
+				return distance;
+			}
+			return nearestSoFar;
+		});
+	return hit ? nearest / localPerWorld : maxDistance;
+}
+
+bool Mesh::CanOcclude() const noexcept
+{
+	return opaque;
+}
 
-void Mesh::Submit(FrameCommander& frame, DirectX::FXMMATRIX accumulatedTranform) const noxnd
+const std::vector<DirectX::XMFLOAT3>& Mesh::GetPositions() const noexcept
 {
-	DirectX::XMStoreFloat4x4(&transform, accumulatedTranform);
-	Drawable::Submit(frame);
+	return positions;
 }
 
-DirectX::XMMATRIX Mesh::GetTransformXM() const noexcept
+const std::vector<uint32_t>& Mesh::GetIndices(size_t lod) const noexcept
 {
-	return DirectX::XMLoadFloat4x4(&transform);
+	return lod == 0u ? indices : lodIndices[lod - 1u];
 }
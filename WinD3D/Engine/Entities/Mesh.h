@@ -2,19 +2,78 @@
 #include <Engine/Graphics.h>
 #include <Engine/Architecture/Drawable.h>
 #include <Framework/noexcept_if.h>
+#include <DirectXCollision.h>
+#include "BoundingVolumeHierarchy.h"
+#include "ModelCache.h"
 
 class Material;
 class FrameCommander;
-struct aiMesh;
 
 
+// placed by whoever submits it, so the same mesh can be drawn under any number of nodes
 class Mesh : public Drawable
 {
 public:
-	Mesh(Graphics& gfx, const Material& mat, const aiMesh& mesh, float scale = 1.0f) noxnd;
+	// a lod's indices in buffers shared with other meshes
+	struct SharedRange
+	{
+		UINT startIndex;
+		UINT indexCount;
+		INT baseVertex;
+	};
 public:
-	DirectX::XMMATRIX GetTransformXM() const noexcept override;
-	void Submit(FrameCommander& frame, DirectX::FXMMATRIX accumulatedTranform) const noxnd;
+	static constexpr size_t maxLods = 4u;
+	// projected bounding sphere radius, in half screen heights, below which lod 1 is used;
+	// every further lod halves it
+	static constexpr float lodCoverage = 0.25f;
+	// how far past a switch point coverage has to go before switching, against popping back and forth
+	static constexpr float lodHysteresis = 0.1f;
+	// meshes aren't simplified below this
+	static constexpr size_t minLodTriangles = 64u;
+public:
+	// vertices must be in mat's layout; buildLods simplifies further lods after the ones given
+	Mesh(Graphics& gfx, const Material& mat, const ModelCache::MeshView& mesh, bool buildLods = false) noxnd;
+	// from buffers the codex still holds, lod 0 first; positions and indices are the CPU copy of
+	// what they hold, in any vertex order, and the lods past 0 get none
+	Mesh(Graphics& gfx, const Material& mat, std::shared_ptr<VertexBuffer> pVertices_in, std::vector<std::shared_ptr<IndexBuffer>> lodBuffers,
+		const DV::PositionQuantization& quantization, std::vector<DirectX::XMFLOAT3> positions_in, std::vector<uint32_t> indices_in) noxnd;
+public:
+	void Submit(FrameCommander& frame, DirectX::FXMMATRIX world, size_t lod = 0u) const noxnd;
+	size_t GetLodCount() const noexcept;
+	size_t GetTriangleCount(size_t lod) const noexcept;
+	// lod for a projected coverage (see lodCoverage), given the lod used so far
+	size_t SelectLod(float coverage, size_t current) const noexcept;
+	// probes the full detail techniques, then carries their states and constants over to the lods
+	void Accept(TechniqueProbe& probe);
+	// draws every lod from its range of shared buffers holding the same vertices and indices,
+	// e.g. a static batch's, from then on
+	void ShareBuffers(const std::shared_ptr<VertexBuffer>& pVertices_in, const std::shared_ptr<IndexBuffer>& pIndices_in,
+		const std::vector<SharedRange>& lodRanges) noexcept;
+	// bounds of the vertices in the mesh's local space, quantized positions decoded
+	const DirectX::BoundingBox& GetBoundingBox() const noexcept;
+	const DirectX::BoundingSphere& GetBoundingSphere() const noexcept;
+	// distance along the world space ray to its nearest hit on the mesh placed by world,
+	// or maxDistance if there is none nearer; direction must be normalized
+	float IntersectRay(DirectX::FXMMATRIX world, DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance) const noexcept;
+	// opaque and single sided, so its triangles hide whatever is behind their front faces
+	bool CanOcclude() const noexcept;
+	const std::vector<DirectX::XMFLOAT3>& GetPositions() const noexcept;
+	// empty for the lods of a mesh made from codex buffers
+	const std::vector<uint32_t>& GetIndices(size_t lod = 0u) const noexcept;
+private:
+	// bounds and triangle bvh of positions and indices
+	void BuildBounds() noexcept;
+	void BuildLods(Graphics& gfx, const Material& mat, std::string_view name) noxnd;
+	void AddLod(Graphics& gfx, const Material& mat, std::string_view name, std::vector<uint32_t> indices_in) noxnd;
 private:
-	mutable DirectX::XMFLOAT4X4 transform;
+	DirectX::BoundingBox box;
+	DirectX::BoundingSphere sphere;
+	// CPU side copy of the geometry for picking, positions decoded
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<uint32_t> indices;
+	BoundingVolumeHierarchy triangles;
+	bool opaque;
+	// lod 1 and up, coarser indices over the mesh's vertices
+	std::vector<std::unique_ptr<Drawable>> lods;
+	std::vector<std::vector<uint32_t>> lodIndices;
 };
\ No newline at end of file
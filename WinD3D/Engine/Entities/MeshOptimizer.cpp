@@ -0,0 +1,366 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace dx = DirectX;
+
+namespace
+{
+	// fifo by timestamps: a vertex is cached while fewer than cacheSize misses came after its own
+	class CacheModel
+	{
+	public:
+		CacheModel(size_t vertexCount)
+			:
+			timestamps(vertexCount, 0u)
+		{}
+		// misses among the triangle's vertices
+		unsigned int Touch(const uint32_t* pTriangle) noexcept
+		{
+			unsigned int misses = 0u;
+			for (size_t k = 0; k < 3u; k++)
+			{
+				const auto v = pTriangle[k];
+				if (time - timestamps[v] > MeshOptimizer::cacheSize)
+				{
+					timestamps[v] = time++;
+					misses++;
+				}
+			}
+			return misses;
+		}
+		void Flush() noexcept
+		{
+			time += uint32_t(MeshOptimizer::cacheSize) + 1u;
+		}
+	private:
+		std::vector<uint32_t> timestamps;
+		uint32_t time = uint32_t(MeshOptimizer::cacheSize) + 1u;
+	};
+
+	size_t CountVertices(const std::vector<uint32_t>& indices) noexcept
+	{
+		return indices.empty() ? 0u : size_t(*std::max_element(indices.begin(), indices.end())) + 1u;
+	}
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeTriangles(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices)
+{
+	if (indices.size() < 6u)
+	{
+		return indices;
+	}
+	const auto vertexCount = positions.empty() ? CountVertices(indices) : positions.size();
+	auto ordered = Tipsify(indices, vertexCount);
+	if (positions.empty())
+	{
+		return ordered;
+	}
+	return SortClusters(positions, ordered, SplitClusters(ordered, vertexCount));
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeFetch(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	std::vector<uint32_t> remap(vertexCount, ~0u);
+	uint32_t next = 0u;
+	for (auto& i : indices)
+	{
+		if (remap[i] == ~0u)
+		{
+			remap[i] = next++;
+		}
+		i = remap[i];
+	}
+	return remap;
+}
+
+void MeshOptimizer::Optimize(DV::VertexBuffer& vertices, std::vector<uint32_t>& indices)
+{
+	const auto& layout = vertices.GetLayout();
+	std::vector<dx::XMFLOAT3> positions;
+	if (layout.Has(DV::Type::Position3D))
+	{
+		const auto source = vertices.Span<DV::Type::Position3D>();
+		positions.reserve(source.Count());
+		for (size_t i = 0; i < source.Count(); i++)
+		{
+			positions.push_back(source[i]);
+		}
+	}
+	else if (layout.Has(DV::Type::QuantizedPosition3D))
+	{
+		const auto source = vertices.Span<DV::Type::QuantizedPosition3D>();
+		const auto& quantization = vertices.GetQuantization();
+		positions.reserve(source.Count());
+		for (size_t i = 0; i < source.Count(); i++)
+		{
+			positions.push_back(quantization.Decode(source[i]));
+		}
+	}
+	indices = OptimizeTriangles(positions, indices);
+	const auto remap = OptimizeFetch(indices, vertices.Count());
+	const auto usedCount = size_t(std::count_if(remap.begin(), remap.end(), [](uint32_t r) { return r != ~0u; }));
+	DV::VertexBuffer reordered{ layout, usedCount };
+	reordered.SetQuantization(vertices.GetQuantization());
+	for (size_t i = 0; i < remap.size(); i++)
+	{
+		if (remap[i] != ~0u)
+		{
+			reordered[remap[i]] = vertices[i];
+		}
+	}
+	vertices = std::move(reordered);
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::Analyze(const std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	CacheModel cache{ vertexCount };
+	std::vector<bool> used(vertexCount, false);
+	size_t misses = 0u;
+	for (size_t i = 0; i + 2u < indices.size(); i += 3u)
+	{
+		misses += cache.Touch(&indices[i]);
+		for (size_t k = 0; k < 3u; k++)
+		{
+			used[indices[i + k]] = true;
+		}
+	}
+	const auto usedCount = size_t(std::count(used.begin(), used.end(), true));
+	CacheStats stats;
+	stats.acmr = indices.size() >= 3u ? float(misses) / float(indices.size() / 3u) : 0.0f;
+	stats.atvr = usedCount > 0u ? float(misses) / float(usedCount) : 0.0f;
+	return stats;
+}
+
+std::vector<uint32_t> MeshOptimizer::Tipsify(const std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	const auto triangleCount = indices.size() / 3u;
+	// triangles around every vertex, packed
+	std::vector<uint32_t> offsets(vertexCount + 1u, 0u);
+	for (size_t i = 0; i < triangleCount * 3u; i++)
+	{
+		offsets[indices[i] + 1u]++;
+	}
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	std::vector<uint32_t> adjacency(triangleCount * 3u);
+	{
+		auto fill = offsets;
+		for (size_t i = 0; i < triangleCount * 3u; i++)
+		{
+			adjacency[fill[indices[i]]++] = uint32_t(i / 3u);
+		}
+	}
+	// triangles not emitted yet, per vertex
+	std::vector<uint32_t> live(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		live[v] = offsets[v + 1u] - offsets[v];
+	}
+	std::vector<uint32_t> timestamps(vertexCount, 0u);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve(triangleCount * 3u);
+	uint32_t time = uint32_t(cacheSize) + 1u;
+	size_t cursor = 0u;
+
+	// emits every triangle around the fanning vertex, then fans around whichever of their
+	// vertices will still be cached once its own remaining triangles are out, oldest first
+	int64_t fan = indices[0];
+	while (fan >= 0)
+	{
+		candidates.clear();
+		for (auto a = offsets[size_t(fan)]; a < offsets[size_t(fan) + 1u]; a++)
+		{
+			const auto t = adjacency[a];
+			if (emitted[t])
+			{
+				continue;
+			}
+			for (size_t k = 0; k < 3u; k++)
+			{
+				const auto v = indices[size_t(t) * 3u + k];
+				result.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - timestamps[v] > cacheSize)
+				{
+					timestamps[v] = time++;
+				}
+			}
+			emitted[t] = true;
+		}
+		int64_t next = -1;
+		int64_t best = -1;
+		for (const auto v : candidates)
+		{
+			if (live[v] == 0u)
+			{
+				continue;
+			}
+			int64_t priority = 0;
+			if (int64_t(time - timestamps[v]) + 2 * int64_t(live[v]) <= int64_t(cacheSize))
+			{
+				priority = time - timestamps[v];
+			}
+			if (priority > best)
+			{
+				best = priority;
+				next = v;
+			}
+		}
+		// dead end: the latest vertex with triangles left, else the next one in order
+		while (next < 0 && !deadEnds.empty())
+		{
+			const auto v = deadEnds.back();
+			deadEnds.pop_back();
+			if (live[v] > 0u)
+			{
+				next = v;
+			}
+		}
+		for (; next < 0 && cursor < vertexCount; cursor++)
+		{
+			if (live[cursor] > 0u)
+			{
+				next = int64_t(cursor);
+			}
+		}
+		fan = next;
+	}
+	return result;
+}
+
+std::vector<size_t> MeshOptimizer::SplitClusters(const std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	const auto triangleCount = indices.size() / 3u;
+	// hard boundaries, where all three vertices miss the cache
+	std::vector<size_t> hard;
+	{
+		CacheModel cache{ vertexCount };
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			const auto misses = cache.Touch(&indices[t * 3u]);
+			if (misses == 3u || t == 0u)
+			{
+				hard.push_back(t);
+			}
+		}
+	}
+	// within them a new cluster starts whenever the running hit rate since the last cut has
+	// come within clusterThreshold of the whole run's; a short tail goes back to the cluster before
+	std::vector<size_t> clusters;
+	CacheModel cache{ vertexCount };
+	for (size_t h = 0; h < hard.size(); h++)
+	{
+		const auto start = hard[h];
+		const auto end = h + 1u < hard.size() ? hard[h + 1u] : triangleCount;
+		cache.Flush();
+		size_t runMisses = 0u;
+		for (auto t = start; t < end; t++)
+		{
+			runMisses += cache.Touch(&indices[t * 3u]);
+		}
+		const auto target = clusterThreshold * float(runMisses) / float(end - start);
+
+		clusters.push_back(start);
+		cache.Flush();
+		size_t misses = 0u;
+		size_t triangles = 0u;
+		for (auto t = start; t < end; t++)
+		{
+			misses += cache.Touch(&indices[t * 3u]);
+			triangles++;
+			if (float(misses) / float(triangles) <= target && t + 1u < end)
+			{
+				clusters.push_back(t + 1u);
+				cache.Flush();
+				misses = 0u;
+				triangles = 0u;
+			}
+		}
+		if (triangles > 0u && float(misses) / float(triangles) > target && clusters.back() != start)
+		{
+			clusters.pop_back();
+		}
+	}
+	return clusters;
+}
+
+std::vector<uint32_t> MeshOptimizer::SortClusters(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices, const std::vector<size_t>& clusters)
+{
+	struct Cluster
+	{
+		size_t begin;
+		size_t end;
+		// area weighted
+		dx::XMFLOAT3 centroid = { 0.0f,0.0f,0.0f };
+		dx::XMFLOAT3 normal = { 0.0f,0.0f,0.0f };
+		float area = 0.0f;
+		float sortKey = 0.0f;
+	};
+	const auto triangleCount = indices.size() / 3u;
+	std::vector<Cluster> sorted;
+	sorted.reserve(clusters.size());
+	dx::XMFLOAT3 meshCentroid = { 0.0f,0.0f,0.0f };
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		auto& cluster = sorted.emplace_back();
+		cluster.begin = clusters[c];
+		cluster.end = c + 1u < clusters.size() ? clusters[c + 1u] : triangleCount;
+		for (auto t = cluster.begin; t < cluster.end; t++)
+		{
+			const auto& p0 = positions[indices[t * 3u]];
+			const auto& p1 = positions[indices[t * 3u + 1u]];
+			const auto& p2 = positions[indices[t * 3u + 2u]];
+			const dx::XMFLOAT3 e1 = { p1.x - p0.x,p1.y - p0.y,p1.z - p0.z };
+			const dx::XMFLOAT3 e2 = { p2.x - p0.x,p2.y - p0.y,p2.z - p0.z };
+			// front faces wind clockwise in a left handed space, this points out of them
+			const dx::XMFLOAT3 n = { e1.y * e2.z - e1.z * e2.y,e1.z * e2.x - e1.x * e2.z,e1.x * e2.y - e1.y * e2.x };
+			const auto area = 0.5f * std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+			cluster.centroid.x += area * (p0.x + p1.x + p2.x) / 3.0f;
+			cluster.centroid.y += area * (p0.y + p1.y + p2.y) / 3.0f;
+			cluster.centroid.z += area * (p0.z + p1.z + p2.z) / 3.0f;
+			cluster.normal.x += n.x;
+			cluster.normal.y += n.y;
+			cluster.normal.z += n.z;
+			cluster.area += area;
+		}
+		meshCentroid.x += cluster.centroid.x;
+		meshCentroid.y += cluster.centroid.y;
+		meshCentroid.z += cluster.centroid.z;
+		meshArea += cluster.area;
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCentroid = { meshCentroid.x / meshArea,meshCentroid.y / meshArea,meshCentroid.z / meshArea };
+	}
+	// clusters facing away from the middle of the mesh are likely in front of the rest from
+	// wherever they can be seen, drawing them first lets depth testing reject what's behind
+	for (auto& cluster : sorted)
+	{
+		const auto length = std::sqrt(cluster.normal.x * cluster.normal.x + cluster.normal.y * cluster.normal.y + cluster.normal.z * cluster.normal.z);
+		if (cluster.area > 0.0f && length > 0.0f)
+		{
+			cluster.sortKey = (
+				(cluster.centroid.x / cluster.area - meshCentroid.x) * cluster.normal.x +
+				(cluster.centroid.y / cluster.area - meshCentroid.y) * cluster.normal.y +
+				(cluster.centroid.z / cluster.area - meshCentroid.z) * cluster.normal.z) / length;
+		}
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b)
+	{
+		return a.sortKey > b.sortKey;
+	});
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (const auto& cluster : sorted)
+	{
+		result.insert(result.end(), indices.begin() + cluster.begin * 3u, indices.begin() + cluster.end * 3u);
+	}
+	return result;
+}
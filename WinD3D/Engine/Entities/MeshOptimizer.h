@@ -0,0 +1,39 @@
+#pragma once
+#include <Engine/Architecture/VertexLayout.h>
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+// reorders triangle lists for the GPU without changing what they draw: triangles for the
+// post-transform vertex cache (tipsify) and then, in cache friendly clusters, outward facing
+// parts first against overdraw; vertices in the order the triangles first use them
+class MeshOptimizer
+{
+public:
+	// the post-transform cache is modelled as a fifo of this many vertices
+	static constexpr size_t cacheSize = 16u;
+	// a cluster is cut wherever its hit rate has come within this factor of the whole run's;
+	// smaller clusters sort better for overdraw but start with a cold cache
+	static constexpr float clusterThreshold = 1.05f;
+	struct CacheStats
+	{
+		// vertices transformed per triangle, about 0.5 at best for a closed mesh, 3 at worst
+		float acmr = 0.0f;
+		// vertices transformed per vertex used, 1 at best
+		float atvr = 0.0f;
+	};
+public:
+	// positions may be empty, then only the cache order is optimized
+	static std::vector<uint32_t> OptimizeTriangles(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices);
+	// renumbers vertices by first use, unused ones are dropped; returns the new index of every
+	// old vertex, ~0u for the dropped ones
+	static std::vector<uint32_t> OptimizeFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+	// both of the above, vertices are reordered to match
+	static void Optimize(DV::VertexBuffer& vertices, std::vector<uint32_t>& indices);
+	static CacheStats Analyze(const std::vector<uint32_t>& indices, size_t vertexCount);
+private:
+	static std::vector<uint32_t> Tipsify(const std::vector<uint32_t>& indices, size_t vertexCount);
+	// first triangle of every cluster, cut where the cache runs cold or its hit rate allows
+	static std::vector<size_t> SplitClusters(const std::vector<uint32_t>& indices, size_t vertexCount);
+	static std::vector<uint32_t> SortClusters(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices, const std::vector<size_t>& clusters);
+};
@@ -0,0 +1,258 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <numeric>
+#include <cmath>
+#include <cfloat>
+
+namespace dx = DirectX;
+
+namespace
+{
+	// symmetric 4x4 plane quadric, in double since collapses keep summing them up
+	struct Quadric
+	{
+		double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+		double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+		double a22 = 0.0, a23 = 0.0;
+		double a33 = 0.0;
+		// summed triangle area, so errors come out as mean squared distances
+		double weight = 0.0;
+
+		static Quadric FromPlane(double a, double b, double c, double d, double w) noexcept
+		{
+			Quadric q;
+			q.a00 = w * a * a; q.a01 = w * a * b; q.a02 = w * a * c; q.a03 = w * a * d;
+			q.a11 = w * b * b; q.a12 = w * b * c; q.a13 = w * b * d;
+			q.a22 = w * c * c; q.a23 = w * c * d;
+			q.a33 = w * d * d;
+			q.weight = w;
+			return q;
+		}
+		Quadric& operator+=(const Quadric& o) noexcept
+		{
+			a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+			a11 += o.a11; a12 += o.a12; a13 += o.a13;
+			a22 += o.a22; a23 += o.a23;
+			a33 += o.a33;
+			weight += o.weight;
+			return *this;
+		}
+		double Evaluate(const dx::XMFLOAT3& p) const noexcept
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const auto e =
+				a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+				a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y +
+				a22 * z * z + 2.0 * a23 * z +
+				a33;
+			return weight > 0.0 ? std::abs(e) / weight : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		uint32_t from;
+		uint32_t to;
+		bool operator<(const Collapse& o) const noexcept
+		{
+			// ties broken on the indices, the order must not depend on anything but the input
+			return cost != o.cost ? cost < o.cost : (from != o.from ? from < o.from : to < o.to);
+		}
+	};
+
+	uint64_t EdgeKey(uint32_t a, uint32_t b) noexcept
+	{
+		return a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+	}
+
+	dx::XMVECTOR Normal(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b, const dx::XMFLOAT3& c) noexcept
+	{
+		const auto pa = dx::XMLoadFloat3(&a);
+		return dx::XMVector3Cross(dx::XMVectorSubtract(dx::XMLoadFloat3(&b), pa), dx::XMVectorSubtract(dx::XMLoadFloat3(&c), pa));
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices_in,
+	size_t targetIndexCount, float maxError, float* pError)
+{
+	auto indices = indices_in;
+	double appliedError = 0.0;
+	const auto vertexCount = positions.size();
+
+	// edges used by anything but exactly two triangles are open (or non-manifold), their vertices stay put
+	std::vector<uint8_t> locked(vertexCount, 0u);
+	{
+		std::unordered_map<uint64_t, uint32_t> edgeUses;
+		edgeUses.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3u)
+		{
+			for (size_t e = 0; e < 3u; e++)
+			{
+				edgeUses[EdgeKey(indices[i + e], indices[i + (e + 1u) % 3u])]++;
+			}
+		}
+		for (const auto& [key, uses] : edgeUses)
+		{
+			if (uses != 2u)
+			{
+				locked[uint32_t(key >> 32)] = 1u;
+				locked[uint32_t(key)] = 1u;
+			}
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < indices.size(); i += 3u)
+	{
+		const auto& p0 = positions[indices[i]];
+		dx::XMFLOAT3 n;
+		const auto cross = Normal(p0, positions[indices[i + 1u]], positions[indices[i + 2u]]);
+		const auto area = dx::XMVectorGetX(dx::XMVector3Length(cross)) * 0.5f;
+		if (area <= 0.0f)
+		{
+			continue;
+		}
+		dx::XMStoreFloat3(&n, dx::XMVector3Normalize(cross));
+		const auto q = Quadric::FromPlane(n.x, n.y, n.z, -(double(n.x) * p0.x + double(n.y) * p0.y + double(n.z) * p0.z), area);
+		for (size_t j = 0; j < 3u; j++)
+		{
+			quadrics[indices[i + j]] += q;
+		}
+	}
+
+	const auto maxCost = double(maxError) * double(maxError);
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint8_t> touched(vertexCount);
+	// triangles around each vertex, as offsets into adjacency
+	std::vector<uint32_t> adjacencyStarts(vertexCount + 1u);
+	std::vector<uint32_t> adjacency;
+	while (indices.size() > targetIndexCount)
+	{
+		collapses.clear();
+		for (size_t i = 0; i < indices.size(); i += 3u)
+		{
+			for (size_t e = 0; e < 3u; e++)
+			{
+				const auto a = indices[i + e];
+				const auto b = indices[i + (e + 1u) % 3u];
+				// each interior edge is seen from both of its triangles, take it from the one where a < b
+				if (a > b)
+				{
+					continue;
+				}
+				auto merged = quadrics[a];
+				merged += quadrics[b];
+				const auto costToA = locked[b] ? DBL_MAX : merged.Evaluate(positions[a]);
+				const auto costToB = locked[a] ? DBL_MAX : merged.Evaluate(positions[b]);
+				if (costToA == DBL_MAX && costToB == DBL_MAX)
+				{
+					continue;
+				}
+				collapses.push_back(costToB <= costToA ? Collapse{ costToB,a,b } : Collapse{ costToA,b,a });
+			}
+		}
+		std::sort(collapses.begin(), collapses.end());
+
+		adjacencyStarts.assign(vertexCount + 1u, 0u);
+		for (const auto v : indices)
+		{
+			adjacencyStarts[v + 1u]++;
+		}
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			adjacencyStarts[v + 1u] += adjacencyStarts[v];
+		}
+		adjacency.resize(indices.size());
+		{
+			auto fill = adjacencyStarts;
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				adjacency[fill[indices[i]]++] = uint32_t(i / 3u);
+			}
+		}
+
+		// a collapse removes about two triangles, stop a pass once the target is in reach
+		const auto trianglesToRemove = (indices.size() - targetIndexCount) / 3u;
+		size_t removed = 0u;
+		std::iota(remap.begin(), remap.end(), 0u);
+		std::fill(touched.begin(), touched.end(), uint8_t(0u));
+		for (const auto& c : collapses)
+		{
+			if (c.cost > maxCost || removed >= trianglesToRemove)
+			{
+				break;
+			}
+			if (touched[c.from] || touched[c.to])
+			{
+				continue;
+			}
+			// moving from onto to must not flip any triangle that survives the collapse
+			bool flips = false;
+			for (auto t = adjacencyStarts[c.from]; t < adjacencyStarts[c.from + 1u] && !flips; t++)
+			{
+				const auto tri = &indices[size_t(adjacency[t]) * 3u];
+				if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+				{
+					continue;
+				}
+				std::array<dx::XMFLOAT3, 3> moved = { positions[tri[0]],positions[tri[1]],positions[tri[2]] };
+				for (size_t j = 0; j < 3u; j++)
+				{
+					if (tri[j] == c.from)
+					{
+						moved[j] = positions[c.to];
+					}
+				}
+				const auto before = Normal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+				const auto after = Normal(moved[0], moved[1], moved[2]);
+				flips = dx::XMVectorGetX(dx::XMVector3Dot(before, after)) <= 0.0f;
+			}
+			if (flips)
+			{
+				continue;
+			}
+			// everything around from changes shape, leave it alone for the rest of the pass
+			for (auto t = adjacencyStarts[c.from]; t < adjacencyStarts[c.from + 1u]; t++)
+			{
+				const auto tri = &indices[size_t(adjacency[t]) * 3u];
+				touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1u;
+				if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+				{
+					removed++;
+				}
+			}
+			remap[c.from] = c.to;
+			quadrics[c.to] += quadrics[c.from];
+			appliedError = std::max(appliedError, c.cost);
+		}
+		if (removed == 0u)
+		{
+			break;
+		}
+
+		size_t write = 0u;
+		for (size_t i = 0; i < indices.size(); i += 3u)
+		{
+			const auto a = remap[indices[i]];
+			const auto b = remap[indices[i + 1u]];
+			const auto c = remap[indices[i + 2u]];
+			if (a != b && b != c && c != a)
+			{
+				indices[write++] = a;
+				indices[write++] = b;
+				indices[write++] = c;
+			}
+		}
+		indices.resize(write);
+	}
+
+	if (pError != nullptr)
+	{
+		*pError = float(std::sqrt(appliedError));
+	}
+	return indices;
+}
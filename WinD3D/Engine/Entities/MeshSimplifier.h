@@ -0,0 +1,17 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+// quadric error metric simplification that only rewrites indices: every collapse moves a
+// vertex onto a neighbour, so all levels of detail share the original vertex buffer.
+// vertices on open edges (mesh borders, attribute seams) never move, keeping uvs and outlines intact
+class MeshSimplifier
+{
+public:
+	// collapses edges cheapest first until indices are down to targetIndexCount or the next
+	// collapse would move the surface by more than maxError (mesh units); deterministic for
+	// the same input. pError receives the largest error actually introduced
+	static std::vector<uint32_t> Simplify(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices,
+		size_t targetIndexCount, float maxError, float* pError = nullptr);
+};
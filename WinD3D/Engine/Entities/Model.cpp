@@ -1,11 +1,14 @@
 #include "Model.h"
-#include <assimp/Importer.hpp>
 #include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include "ModelException.h"
 #include "Node.h"
 #include "Mesh.h"
 #include <Engine/Architecture/Material.h>
+#include <Framework/PerfLog.h>
+#include <Framework/ParallelFor.h>
+#include <Engine/OcclusionBuffer.h>
+#include <cfloat>
+#include <algorithm>
+#include <unordered_map>
 
 namespace dx = DirectX;
 
@@ -17,47 +20,218 @@ DirectX::XMMATRIX ScaleTranslation(DirectX::XMMATRIX matrix, float scale)
 	return matrix;
 }
 
-Model::Model(Graphics& gfx, std::string_view pathString, const float scale)
+Model::Model(Graphics& gfx, std::string_view pathString, const float scale, bool splitLargeMeshes, bool staticBatch)
+	:
+	Model(gfx, ModelSource{ std::string(pathString), scale, splitLargeMeshes }, staticBatch)
+{}
+
+Model::Model(Graphics& gfx, ModelSource&& source, bool staticBatch)
+	:
+	Model(source)
 {
-	Assimp::Importer imp;
-	const auto pScene = imp.ReadFile(pathString.data(),
-		aiProcess_Triangulate |
-		aiProcess_JoinIdenticalVertices |
-		aiProcess_ConvertToLeftHanded |
-		aiProcess_GenNormals |
-		aiProcess_CalcTangentSpace
-	);
+	// materials decode textures, meshes convert vertices and build lods; every task fills
+	// only its own slot, so the model comes out the same at any thread count
+	std::vector<std::unique_ptr<Material>> materials(source.GetMaterialCount());
+	{
+		PERF_SCOPE("Model::Materials");
+		ParallelFor(materials.size(), [&](size_t i)
+		{
+			materials[i] = source.MakeMaterial(gfx, i);
+		});
+	}
+	std::vector<std::unique_ptr<Mesh>> meshes(source.GetMeshCount());
+	{
+		PERF_SCOPE("Model::Meshes");
+		ParallelFor(meshes.size(), [&](size_t i)
+		{
+			meshes[i] = source.MakeMesh(gfx, *materials[source.GetMeshMaterial(i)], i);
+		});
+	}
+	// in scene order, so mesh instances are too
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		AddMesh(i, std::move(meshes[i]));
+	}
+	// batches read the imported vertices, which cooking lets go of
+	if (staticBatch)
+	{
+		SetStaticBatches(BuildStaticBatches(gfx, source, materials));
+	}
+	source.Cook(materials);
+	UpdateBounds();
+}
 
-	if (pScene == nullptr)
+Model::Model(const ModelSource& source)
+{
+	meshPtrs.resize(source.GetMeshCount());
+	meshNodes.resize(source.GetMeshCount());
+	if (const auto pScene = source.GetScene())
+	{
+		pRoot = ParseNode(*pScene->mRootNode, source.GetScale(), TransformHierarchy::noParent);
+	}
+	else
 	{
-		throw ModelException(__LINE__, __FILE__, imp.GetErrorString());
+		size_t next = 0u;
+		pRoot = ParseNode(source.GetCache(), next, source.GetScale(), TransformHierarchy::noParent);
 	}
+}
 
-	// parse materials
-	std::vector<Material> materials;
-	materials.reserve(pScene->mNumMaterials);
-	for (size_t i = 0; i < pScene->mNumMaterials; i++)
+void Model::AddMesh(size_t index, std::unique_ptr<Mesh> pMesh) noxnd
+{
+	assert(index < meshPtrs.size() && meshPtrs[index] == nullptr);
+	for (const auto node : meshNodes[index])
 	{
-		materials.emplace_back(gfx, *pScene->mMaterials[i], pathString);
+		nodePtrs[node]->meshPtrs.push_back(pMesh.get());
+		meshInstances.push_back({ node, uint32_t(index), pMesh.get() });
 	}
+	meshPtrs[index] = std::move(pMesh);
+	instancesAdded = true;
+}
 
-	for (size_t i = 0; i < pScene->mNumMeshes; i++)
+std::vector<std::unique_ptr<StaticBatch>> Model::BuildStaticBatches(Graphics& gfx, const ModelSource& source,
+	const std::vector<std::unique_ptr<Material>>& materials)
+{
+	PERF_SCOPE("Model::BuildStaticBatches");
+	std::vector<std::vector<uint32_t>> meshes(materials.size());
+	for (uint32_t mesh = 0; mesh < uint32_t(source.GetMeshCount()); mesh++)
+	{
+		// made from codex buffers, there are no vertices to copy
+		if (source.GetMeshView(mesh).lodCount > 0u)
+		{
+			meshes[source.GetMeshMaterial(mesh)].push_back(mesh);
+		}
+	}
+	std::vector<std::unique_ptr<StaticBatch>> batches;
+	for (size_t i = 0; i < meshes.size(); i++)
 	{
-		const auto& mesh = *pScene->mMeshes[i];
-		meshPtrs.push_back(std::make_unique<Mesh>(gfx, materials[mesh.mMaterialIndex], mesh, scale));
+		// a lone mesh has nothing to share its buffers with, its instances share them anyway
+		if (meshes[i].size() < 2u || materials[i] == nullptr)
+		{
+			continue;
+		}
+		batches.push_back(std::make_unique<StaticBatch>(gfx, *materials[i], "#batch" + std::to_string(i), source, std::move(meshes[i])));
 	}
+	return batches;
+}
 
-	int nextId = 0;
-	pRoot = ParseNode(nextId, *pScene->mRootNode, scale);
+void Model::SetStaticBatches(std::vector<std::unique_ptr<StaticBatch>> batches) noxnd
+{
+	for (const auto& pBatch : batches)
+	{
+		const auto& meshes = pBatch->GetMeshes();
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			assert(meshPtrs[meshes[i]] != nullptr);
+			pBatch->Share(i, *meshPtrs[meshes[i]]);
+		}
+	}
+}
+
+void Model::AddOccluders(OcclusionBuffer& occlusion) noexcept
+{
+	UpdateBounds();
+	for (const auto i : occluders)
+	{
+		const auto& mi = meshInstances[i];
+		occlusion.AddOccluder(hierarchy.GetWorld(mi.node), mi.pMesh->GetPositions(), mi.pMesh->GetIndices());
+	}
 }
 
-void Model::Submit(FrameCommander& frame) const noxnd
+void Model::Submit(FrameCommander& frame, const DirectX::BoundingFrustum& frustum, OcclusionBuffer* pOcclusion) noxnd
 {
-	// I'm still not happy about updating parameters (i.e. mutating a bindable GPU state
-	// which is part of a mesh which is part of a node which is part of the model that is
-	// const in this call) Can probably do this elsewhere
+	PERF_SCOPE("Model::Submit");
 	//pWindow->ApplyParameters();
-	pRoot->Submit(frame, dx::XMMatrixIdentity());
+	UpdateBounds();
+	cullStats = {};
+	// frustum culling runs while the occlusion buffer may still be rasterizing
+	candidates.clear();
+	bvh.QueryFrustum(frustum, [&](uint32_t i)
+	{
+		// the bvh culls per leaf, the sphere catches what a leaf lets through
+		dx::BoundingSphere sphere;
+		meshInstances[i].pMesh->GetBoundingSphere().Transform(sphere, hierarchy.GetWorld(meshInstances[i].node));
+		if (frustum.Intersects(sphere))
+		{
+			candidates.push_back(i);
+		}
+	});
+	if (pOcclusion != nullptr)
+	{
+		pOcclusion->Resolve();
+	}
+	// frustum slope turns a sphere's radius and distance into its size in half screen heights
+	const auto eye = dx::XMLoadFloat3(&frustum.Origin);
+	for (const auto i : candidates)
+	{
+		if (pOcclusion != nullptr && pOcclusion->IsOccluded(meshBounds[i]))
+		{
+			cullStats.occluded++;
+			continue;
+		}
+		const auto& mi = meshInstances[i];
+		const auto world = hierarchy.GetWorld(mi.node);
+		dx::BoundingSphere sphere;
+		mi.pMesh->GetBoundingSphere().Transform(sphere, world);
+		const auto distance = dx::XMVectorGetX(dx::XMVector3Length(dx::XMVectorSubtract(dx::XMLoadFloat3(&sphere.Center), eye)));
+		const auto coverage = distance > sphere.Radius ? sphere.Radius / (distance * frustum.TopSlope) : FLT_MAX;
+		const auto lod = mi.pMesh->SelectLod(coverage, lodLevels[i]);
+		lodLevels[i] = uint8_t(lod);
+		mi.pMesh->Submit(frame, world, lod);
+		cullStats.visible++;
+		cullStats.triangles += mi.pMesh->GetTriangleCount(lod);
+	}
+	cullStats.culled = meshInstances.size() - candidates.size();
+}
+
+const Model::CullStats& Model::GetCullStats() const noexcept
+{
+	return cullStats;
+}
+
+Node* Model::Pick(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction) noexcept
+{
+	PERF_SCOPE("Model::Pick");
+	UpdateBounds();
+	const auto normalized = dx::XMVector3Normalize(direction);
+	Node* pNearest = nullptr;
+	bvh.QueryRay(origin, normalized, FLT_MAX, [&](uint32_t i, float nearest)
+	{
+		const auto& mi = meshInstances[i];
+		const auto distance = mi.pMesh->IntersectRay(hierarchy.GetWorld(mi.node), origin, normalized, nearest);
+		if (distance < nearest)
+		{
+			pNearest = nodePtrs[mi.node];
+		}
+		return distance;
+	});
+	return pNearest;
+}
+
+void Model::UpdateBounds() noexcept
+{
+	const auto moved = hierarchy.Update();
+	if (!moved && !instancesAdded)
+	{
+		return;
+	}
+	meshBounds.resize(meshInstances.size());
+	lodLevels.resize(meshInstances.size(), 0u);
+	for (size_t i = 0; i < meshInstances.size(); i++)
+	{
+		const auto& mi = meshInstances[i];
+		mi.pMesh->GetBoundingBox().Transform(meshBounds[i], hierarchy.GetWorld(mi.node));
+	}
+	// added meshes build, afterwards moved nodes only stretch the existing tree
+	if (!instancesAdded)
+	{
+		bvh.Refit(meshBounds);
+	}
+	else
+	{
+		bvh.Build(meshBounds);
+		PickOccluders();
+		instancesAdded = false;
+	}
 }
 
 void Model::SetRootTransform(DirectX::FXMMATRIX tf) noexcept
@@ -70,26 +244,86 @@ void Model::Accept(ModelProbe& probe)
 	pRoot->Accept(probe);
 }
 
-std::unique_ptr<Node> Model::ParseNode(int& nextId, const aiNode& node, float scale) noexcept
+void Model::PickOccluders() noexcept
+{
+	occluders.clear();
+	std::vector<uint32_t> opaque;
+	for (uint32_t i = 0; i < uint32_t(meshInstances.size()); i++)
+	{
+		if (meshInstances[i].pMesh->CanOcclude())
+		{
+			opaque.push_back(i);
+		}
+	}
+	// big meshes hide the most, walls and pillars rather than props
+	const auto area = [this](uint32_t i)
+	{
+		const auto& e = meshBounds[i].Extents;
+		return e.x * e.y + e.y * e.z + e.z * e.x;
+	};
+	std::sort(opaque.begin(), opaque.end(), [&](uint32_t a, uint32_t b)
+	{
+		return area(a) > area(b);
+	});
+	size_t triangles = 0u;
+	for (const auto i : opaque)
+	{
+		const auto count = meshInstances[i].pMesh->GetIndices().size() / 3u;
+		if (triangles + count <= occluderTriangleBudget)
+		{
+			occluders.push_back(i);
+			triangles += count;
+		}
+	}
+}
+
+std::unique_ptr<Node> Model::ParseNode(const aiNode& node, float scale, uint32_t parent) noexcept
 {
 	namespace dx = DirectX;
 	const auto transform = ScaleTranslation(dx::XMMatrixTranspose(dx::XMLoadFloat4x4(
 		reinterpret_cast<const dx::XMFLOAT4X4*>(&node.mTransformation)
 	)), scale);
 
-	std::vector<Mesh*> curMeshPtrs;
-	curMeshPtrs.reserve(node.mNumMeshes);
+	const auto id = hierarchy.Add(parent, transform);
+
+	// meshes join their nodes as they are added
 	for (size_t i = 0; i < node.mNumMeshes; i++)
 	{
-		const auto meshIdx = node.mMeshes[i];
-		curMeshPtrs.push_back(meshPtrs.at(meshIdx).get());
+		meshNodes.at(node.mMeshes[i]).push_back(id);
 	}
 
-	auto pNode = std::make_unique<Node>(nextId++, node.mName.C_Str(), std::move(curMeshPtrs), transform);
+	auto pNode = std::make_unique<Node>(int(id), node.mName.C_Str(), std::vector<Mesh*>{}, hierarchy);
+	nodePtrs.push_back(pNode.get());
 	for (size_t i = 0; i < node.mNumChildren; i++)
 	{
-		pNode->AddChild(ParseNode(nextId, *node.mChildren[i], scale));
+		pNode->AddChild(ParseNode(*node.mChildren[i], scale, id));
+	}
+	hierarchy.CloseSubtree(id);
+
+	return pNode;
+}
+
+std::unique_ptr<Node> Model::ParseNode(const ModelCache& cache, size_t& next, float scale, uint32_t parent) noexcept
+{
+	const auto node = cache.GetNode(next++);
+	// cooked as assimp had it
+	const auto transform = ScaleTranslation(dx::XMMatrixTranspose(dx::XMLoadFloat4x4(node.pTransform)), scale);
+
+	const auto id = hierarchy.Add(parent, transform);
+
+	// meshes join their nodes as they are added
+	for (size_t i = 0; i < node.meshCount; i++)
+	{
+		meshNodes.at(node.pMeshes[i]).push_back(id);
+	}
+
+	auto pNode = std::make_unique<Node>(int(id), node.name, std::vector<Mesh*>{}, hierarchy);
+	nodePtrs.push_back(pNode.get());
+	for (size_t i = 0; i < node.childCount; i++)
+	{
+		pNode->AddChild(ParseNode(cache, next, scale, id));
 	}
+	hierarchy.CloseSubtree(id);
 
 	return pNode;
 }
\ No newline at end of file
@@ -4,12 +4,17 @@
 #include <memory>
 #include "Node.h"
 #include "Mesh.h"
+#include "TransformHierarchy.h"
+#include "BoundingVolumeHierarchy.h"
+#include "ModelSource.h"
+#include "StaticBatch.h"
 #include <filesystem>
 #include <Framework/noexcept_if.h>
 
 class Node;
 class Mesh;
 class FrameCommander;
+class OcclusionBuffer;
 class ModelWindow;
 struct aiMesh;
 struct aiMaterial;
@@ -18,16 +23,86 @@ struct aiNode;
 class Model
 {
 public:
-	Model(Graphics& gfx, std::string_view pathString, float scale = 1.0f);
+	// meshes of the last submit
+	struct CullStats
+	{
+		size_t visible = 0u;
+		// outside the frustum
+		size_t culled = 0u;
+		// inside the frustum but hidden behind occluders
+		size_t occluded = 0u;
+		// drawn by the visible meshes at their selected lods
+		size_t triangles = 0u;
+	};
+	// triangles all occluders together may have, largest meshes get picked first
+	static constexpr size_t occluderTriangleBudget = 32768u;
 public:
-	void Submit(FrameCommander& frame) const noxnd;
+	// splitLargeMeshes as for ModelSource; staticBatch puts the meshes into a static batch per
+	// material (see BuildStaticBatches)
+	Model(Graphics& gfx, std::string_view pathString, float scale = 1.0f, bool splitLargeMeshes = false, bool staticBatch = false);
+	// the node tree of source without any meshes, they are handed over with AddMesh
+	explicit Model(const ModelSource& source);
+	// nodes refer back to the hierarchy
+	Model(const Model&) = delete;
+	Model& operator=(const Model&) = delete;
+public:
+	// index is the mesh's in the scene, it shows up under every node that refers to it
+	void AddMesh(size_t index, std::unique_ptr<Mesh> pMesh) noxnd;
+	// every material's meshes, if it has more than one, in a batch of their own; reads only the
+	// source, so it can run on another thread while the model is drawn
+	static std::vector<std::unique_ptr<StaticBatch>> BuildStaticBatches(Graphics& gfx, const ModelSource& source,
+		const std::vector<std::unique_ptr<Material>>& materials);
+	// moves the batched meshes onto the batches' buffers, the batches can go afterwards; every
+	// mesh has to be added by then
+	void SetStaticBatches(std::vector<std::unique_ptr<StaticBatch>> batches) noxnd;
+	// hands the occluder meshes to the buffer, for it to rasterize before Submit
+	void AddOccluders(OcclusionBuffer& occlusion) noexcept;
+	// submits the meshes that may be inside frustum and, given an occlusion buffer, are not hidden in it
+	void Submit(FrameCommander& frame, const DirectX::BoundingFrustum& frustum, OcclusionBuffer* pOcclusion = nullptr) noxnd;
+	const CullStats& GetCullStats() const noexcept;
+	// node owning the nearest mesh triangle the world space ray hits, nullptr if it hits nothing
+	Node* Pick(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction) noexcept;
 	void SetRootTransform(DirectX::FXMMATRIX tf) noexcept;
 	void Accept(class ModelProbe& probe);
 private:
 	static std::unique_ptr<Mesh> ParseMesh(Graphics& gfx, const aiMesh& mesh, const aiMaterial* const* pMaterials, const std::filesystem::path& path, float scale);
-	std::unique_ptr<Node> ParseNode(int& nextId, const aiNode& node, float scale) noexcept;
+	Model(Graphics& gfx, ModelSource&& source, bool staticBatch);
+	std::unique_ptr<Node> ParseNode(const aiNode& node, float scale, uint32_t parent) noexcept;
+	// consumes the node at next and its subtree
+	std::unique_ptr<Node> ParseNode(const ModelCache& cache, size_t& next, float scale, uint32_t parent) noexcept;
+	// brings world matrices, mesh bounds and the bvh over them up to date
+	void UpdateBounds() noexcept;
+	void PickOccluders() noexcept;
+private:
+	struct MeshInstance
+	{
+		uint32_t node;
+		uint32_t mesh;
+		const Mesh* pMesh;
+	};
 private:
+	// world matrices are brought up to date lazily, on submit
+	TransformHierarchy hierarchy;
+	// every mesh reference of every node, in the order the meshes were added
+	std::vector<MeshInstance> meshInstances;
+	// nodes referring to each scene mesh, by mesh index
+	std::vector<std::vector<uint32_t>> meshNodes;
+	// meshes were added since the bvh was built
+	bool instancesAdded = false;
+	// world space boxes of meshInstances, the primitives of bvh
+	std::vector<DirectX::BoundingBox> meshBounds;
+	BoundingVolumeHierarchy bvh;
+	CullStats cullStats;
+	// meshInstances that draw into the occlusion buffer
+	std::vector<uint32_t> occluders;
+	// meshInstances the frustum let through in the current submit
+	std::vector<uint32_t> candidates;
+	// lod each mesh instance was last drawn at, kept for the hysteresis
+	std::vector<uint8_t> lodLevels;
+	// indexed by node id
+	std::vector<Node*> nodePtrs;
 	std::unique_ptr<Node> pRoot;
-	// sharing meshes here perhaps dangerous?
+	// by scene mesh index, null until added; a mesh may be referenced by several nodes,
+	// every submit passes its own world matrix
 	std::vector<std::unique_ptr<Mesh>> meshPtrs;
 };
\ No newline at end of file
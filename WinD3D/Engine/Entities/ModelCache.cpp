@@ -0,0 +1,461 @@
+#include "ModelCache.h"
+#include <Framework\WinSetup.h>
+#include <assimp/Importer.hpp>
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/scene.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+namespace
+{
+	// 'wdmc'
+	constexpr uint32_t magic = 0x636D6477u;
+
+	// notes every file the importer opens, the model and whatever it pulls in
+	class DependencyIOSystem : public Assimp::DefaultIOSystem
+	{
+	public:
+		Assimp::IOStream* Open(const char* pFile, const char* pMode) override
+		{
+			const auto pStream = DefaultIOSystem::Open(pFile, pMode);
+			if (pStream != nullptr)
+			{
+				files.emplace_back(pFile);
+			}
+			return pStream;
+		}
+	public:
+		std::vector<std::string> files;
+	};
+}
+
+ModelCache::MeshView ModelCache::MeshData::View() const noexcept
+{
+	MeshView view = {};
+	view.name = name;
+	view.material = material;
+	view.pVertices = vertices.data();
+	view.vertexCount = stride > 0u ? vertices.size() / stride : 0u;
+	view.stride = stride;
+	view.quantization = quantization;
+	view.lodCount = std::min(lods.size(), maxLods);
+	for (size_t lod = 0; lod < view.lodCount; lod++)
+	{
+		view.lods[lod] = { lods[lod].data(), lods[lod].size() };
+	}
+	return view;
+}
+
+ModelCache::~ModelCache()
+{
+	Close();
+}
+
+bool ModelCache::Open(std::string_view path, unsigned importFlags, float scale) noexcept
+{
+	Close();
+	try
+	{
+		file = CreateFileA(MakeCachePath(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			file = nullptr;
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || size_t(fileSize.QuadPart) < sizeof(Header))
+		{
+			Close();
+			return false;
+		}
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+		if (mapping != nullptr)
+		{
+			pData = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0u, 0u, 0u));
+		}
+		size = size_t(fileSize.QuadPart);
+		if (pData == nullptr || !Validate())
+		{
+			Close();
+			return false;
+		}
+		const auto& header = *At<Header>(0u);
+		std::vector<std::string> dependencies;
+		for (uint32_t i = 0; i < header.dependencyCount; i++)
+		{
+			dependencies.emplace_back(String(At<uint64_t>(header.dependencies)[i]));
+		}
+		if (header.key != MakeKey(dependencies, importFlags, scale))
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+	catch (...)
+	{
+		Close();
+		return false;
+	}
+}
+
+void ModelCache::Close() noexcept
+{
+	if (pData != nullptr)
+	{
+		UnmapViewOfFile(pData);
+		pData = nullptr;
+	}
+	if (mapping != nullptr)
+	{
+		CloseHandle(mapping);
+		mapping = nullptr;
+	}
+	if (file != nullptr)
+	{
+		CloseHandle(file);
+		file = nullptr;
+	}
+	size = 0u;
+}
+
+size_t ModelCache::GetNodeCount() const noexcept
+{
+	return At<Header>(0u)->nodeCount;
+}
+
+ModelCache::NodeView ModelCache::GetNode(size_t i) const noexcept
+{
+	const auto& header = *At<Header>(0u);
+	const auto& node = At<NodeRecord>(header.nodes)[i];
+	return {
+		&node.transform,
+		String(node.name),
+		node.childCount,
+		At<uint32_t>(header.nodeMeshes) + node.firstMesh,
+		node.meshCount
+	};
+}
+
+size_t ModelCache::GetMaterialCount() const noexcept
+{
+	return At<Header>(0u)->materialCount;
+}
+
+Material::Description ModelCache::GetMaterial(size_t i) const
+{
+	const auto& material = At<MaterialRecord>(At<Header>(0u)->materials)[i];
+	Material::Description description;
+	description.name = String(material.name);
+	description.diffuseMap = String(material.diffuseMap);
+	description.specularMap = String(material.specularMap);
+	description.normalMap = String(material.normalMap);
+	description.diffuseColor = material.diffuseColor;
+	description.specularColor = material.specularColor;
+	description.shininess = material.shininess;
+	return description;
+}
+
+size_t ModelCache::GetMeshCount() const noexcept
+{
+	return At<Header>(0u)->meshCount;
+}
+
+ModelCache::MeshView ModelCache::GetMesh(size_t i) const noexcept
+{
+	const auto& mesh = At<MeshRecord>(At<Header>(0u)->meshes)[i];
+	MeshView view = {};
+	view.name = String(mesh.name);
+	view.material = mesh.material;
+	view.pVertices = At<unsigned char>(mesh.vertices);
+	view.vertexCount = mesh.vertexCount;
+	view.stride = mesh.stride;
+	view.quantization = mesh.quantization;
+	view.lodCount = mesh.lodCount;
+	for (size_t lod = 0; lod < mesh.lodCount; lod++)
+	{
+		view.lods[lod] = { At<uint32_t>(mesh.indices[lod]), mesh.indexCounts[lod] };
+	}
+	return view;
+}
+
+void ModelCache::TrackDependencies(Assimp::Importer& importer)
+{
+	// the importer owns its io system
+	importer.SetIOHandler(new DependencyIOSystem);
+}
+
+bool ModelCache::Write(std::string_view path, unsigned importFlags, float scale, const Assimp::Importer& importer,
+	const std::vector<Material::Description>& materials, const std::vector<MeshData>& meshes) noexcept
+{
+	try
+	{
+		const auto pScene = importer.GetScene();
+		const auto pTracker = dynamic_cast<const DependencyIOSystem*>(importer.GetIOHandler());
+		if (pScene == nullptr || pTracker == nullptr)
+		{
+			return false;
+		}
+		auto dependencies = pTracker->files;
+		std::sort(dependencies.begin(), dependencies.end());
+		dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+		const auto key = MakeKey(dependencies, importFlags, scale);
+		if (key == 0u)
+		{
+			return false;
+		}
+
+		// strings go in as they come up, arrays start on 16 bytes
+		std::vector<unsigned char> blob(sizeof(Header));
+		const auto append = [&blob](const void* pBytes, size_t count)
+		{
+			blob.resize((blob.size() + 15u) & ~size_t(15u));
+			const auto offset = uint64_t(blob.size());
+			const auto p = static_cast<const unsigned char*>(pBytes);
+			blob.insert(blob.end(), p, p + count);
+			return offset;
+		};
+		const auto appendString = [&blob](std::string_view s)
+		{
+			const auto offset = uint64_t(blob.size());
+			blob.insert(blob.end(), s.begin(), s.end());
+			blob.push_back(0u);
+			return offset;
+		};
+
+		std::vector<uint64_t> dependencyNames;
+		for (const auto& d : dependencies)
+		{
+			dependencyNames.push_back(appendString(d));
+		}
+
+		std::vector<NodeRecord> nodes;
+		std::vector<uint32_t> nodeMeshes;
+		const auto addNode = [&](const aiNode& node, const auto& self) -> void
+		{
+			static_assert(sizeof(aiMatrix4x4) == sizeof(DirectX::XMFLOAT4X4), "aiMatrix4x4 must be 16 packed floats");
+			NodeRecord record = {};
+			std::memcpy(&record.transform, &node.mTransformation, sizeof(record.transform));
+			record.name = appendString(node.mName.C_Str());
+			record.childCount = node.mNumChildren;
+			record.meshCount = node.mNumMeshes;
+			record.firstMesh = uint32_t(nodeMeshes.size());
+			nodeMeshes.insert(nodeMeshes.end(), node.mMeshes, node.mMeshes + node.mNumMeshes);
+			nodes.push_back(record);
+			for (unsigned int i = 0; i < node.mNumChildren; i++)
+			{
+				self(*node.mChildren[i], self);
+			}
+		};
+		addNode(*pScene->mRootNode, addNode);
+
+		std::vector<MaterialRecord> materialRecords;
+		for (const auto& m : materials)
+		{
+			MaterialRecord record = {};
+			record.name = appendString(m.name);
+			record.diffuseMap = appendString(m.diffuseMap);
+			record.specularMap = appendString(m.specularMap);
+			record.normalMap = appendString(m.normalMap);
+			record.diffuseColor = m.diffuseColor;
+			record.specularColor = m.specularColor;
+			record.shininess = m.shininess;
+			materialRecords.push_back(record);
+		}
+
+		std::vector<MeshRecord> meshRecords;
+		for (const auto& m : meshes)
+		{
+			if (m.stride == 0u || m.lods.empty() || m.lods.size() > maxLods)
+			{
+				return false;
+			}
+			MeshRecord record = {};
+			record.name = appendString(m.name);
+			record.vertices = append(m.vertices.data(), m.vertices.size());
+			for (size_t lod = 0; lod < m.lods.size(); lod++)
+			{
+				record.indices[lod] = append(m.lods[lod].data(), m.lods[lod].size() * sizeof(uint32_t));
+				record.indexCounts[lod] = uint32_t(m.lods[lod].size());
+			}
+			record.material = m.material;
+			record.vertexCount = uint32_t(m.vertices.size() / m.stride);
+			record.stride = m.stride;
+			record.lodCount = uint32_t(m.lods.size());
+			record.quantization = m.quantization;
+			meshRecords.push_back(record);
+		}
+
+		Header header = {};
+		header.magic = magic;
+		header.version = version;
+		header.key = key;
+		header.dependencies = append(dependencyNames.data(), dependencyNames.size() * sizeof(uint64_t));
+		header.nodes = append(nodes.data(), nodes.size() * sizeof(NodeRecord));
+		header.nodeMeshes = append(nodeMeshes.data(), nodeMeshes.size() * sizeof(uint32_t));
+		header.materials = append(materialRecords.data(), materialRecords.size() * sizeof(MaterialRecord));
+		header.meshes = append(meshRecords.data(), meshRecords.size() * sizeof(MeshRecord));
+		header.dependencyCount = uint32_t(dependencyNames.size());
+		header.nodeCount = uint32_t(nodes.size());
+		header.nodeMeshCount = uint32_t(nodeMeshes.size());
+		header.materialCount = uint32_t(materialRecords.size());
+		header.meshCount = uint32_t(meshRecords.size());
+		header.fileSize = blob.size();
+		std::memcpy(blob.data(), &header, sizeof(header));
+
+		// written aside and moved over, so a load never maps a half written cache
+		const auto cachePath = MakeCachePath(path);
+		const auto tempPath = cachePath + ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			out.write(reinterpret_cast<const char*>(blob.data()), std::streamsize(blob.size()));
+			if (!out)
+			{
+				return false;
+			}
+		}
+		std::error_code error;
+		std::filesystem::rename(tempPath, cachePath, error);
+		return !error;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+std::string ModelCache::MakeCachePath(std::string_view path)
+{
+	return std::string(path) + ".cache";
+}
+
+uint64_t ModelCache::MakeKey(const std::vector<std::string>& dependencies, unsigned importFlags, float scale) noexcept
+{
+	// fnv-1a
+	uint64_t hash = 14695981039346656037ull;
+	const auto mix = [&hash](const void* pBytes, size_t count)
+	{
+		const auto p = static_cast<const unsigned char*>(pBytes);
+		for (size_t i = 0; i < count; i++)
+		{
+			hash = (hash ^ p[i]) * 1099511628211ull;
+		}
+	};
+	mix(&version, sizeof(version));
+	mix(&importFlags, sizeof(importFlags));
+	mix(&scale, sizeof(scale));
+	for (const auto& d : dependencies)
+	{
+		std::error_code error;
+		const auto fileSize = uint64_t(std::filesystem::file_size(d, error));
+		if (error)
+		{
+			return 0u;
+		}
+		const auto writeTime = std::filesystem::last_write_time(d, error).time_since_epoch().count();
+		if (error)
+		{
+			return 0u;
+		}
+		// with the terminator, so names can't run into each other
+		mix(d.c_str(), d.size() + 1u);
+		mix(&fileSize, sizeof(fileSize));
+		mix(&writeTime, sizeof(writeTime));
+	}
+	return hash != 0u ? hash : 1u;
+}
+
+bool ModelCache::Validate() const noexcept
+{
+	const auto& header = *At<Header>(0u);
+	if (header.magic != magic || header.version != version || header.fileSize != size)
+	{
+		return false;
+	}
+	const auto fits = [this](uint64_t offset, uint64_t count, size_t stride)
+	{
+		return offset % 4u == 0u && offset <= size && count <= (size - offset) / stride;
+	};
+	const auto isString = [this](uint64_t offset)
+	{
+		return offset < size && std::memchr(pData + offset, 0, size - offset) != nullptr;
+	};
+	if (!fits(header.dependencies, header.dependencyCount, sizeof(uint64_t)) ||
+		!fits(header.nodes, header.nodeCount, sizeof(NodeRecord)) ||
+		!fits(header.nodeMeshes, header.nodeMeshCount, sizeof(uint32_t)) ||
+		!fits(header.materials, header.materialCount, sizeof(MaterialRecord)) ||
+		!fits(header.meshes, header.meshCount, sizeof(MeshRecord)))
+	{
+		return false;
+	}
+	for (uint32_t i = 0; i < header.dependencyCount; i++)
+	{
+		if (!isString(At<uint64_t>(header.dependencies)[i]))
+		{
+			return false;
+		}
+	}
+	// walking the preorder has to use up exactly the nodes there are
+	size_t pending = 1u;
+	for (uint32_t i = 0; i < header.nodeCount; i++)
+	{
+		const auto& node = At<NodeRecord>(header.nodes)[i];
+		if (pending == 0u || !isString(node.name) ||
+			node.firstMesh > header.nodeMeshCount || node.meshCount > header.nodeMeshCount - node.firstMesh)
+		{
+			return false;
+		}
+		pending += node.childCount;
+		pending--;
+	}
+	if (pending != 0u)
+	{
+		return false;
+	}
+	for (uint32_t i = 0; i < header.nodeMeshCount; i++)
+	{
+		if (At<uint32_t>(header.nodeMeshes)[i] >= header.meshCount)
+		{
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header.materialCount; i++)
+	{
+		const auto& m = At<MaterialRecord>(header.materials)[i];
+		if (!isString(m.name) || !isString(m.diffuseMap) || !isString(m.specularMap) || !isString(m.normalMap))
+		{
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header.meshCount; i++)
+	{
+		const auto& m = At<MeshRecord>(header.meshes)[i];
+		if (!isString(m.name) || m.material >= header.materialCount || m.stride == 0u ||
+			m.lodCount == 0u || m.lodCount > maxLods || !fits(m.vertices, m.vertexCount, m.stride) ||
+			!(m.quantization.extent > 0.0f))
+		{
+			return false;
+		}
+		for (uint32_t lod = 0; lod < m.lodCount; lod++)
+		{
+			if (!fits(m.indices[lod], m.indexCounts[lod], sizeof(uint32_t)))
+			{
+				return false;
+			}
+			const auto pIndices = At<uint32_t>(m.indices[lod]);
+			if (std::any_of(pIndices, pIndices + m.indexCounts[lod], [&m](uint32_t index) { return index >= m.vertexCount; }))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+std::string_view ModelCache::String(uint64_t offset) const noexcept
+{
+	return At<char>(offset);
+}
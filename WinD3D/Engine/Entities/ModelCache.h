@@ -0,0 +1,156 @@
+#pragma once
+#include <Engine/Architecture/Material.h>
+#include <DirectXMath.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+struct aiScene;
+namespace Assimp
+{
+	class Importer;
+}
+
+// cooked form of a model, stored next to its source file: the node tree, the material
+// descriptions and per mesh the vertices in their material's layout plus the indices of every
+// lod. laid out to be read in place from a mapped view. the key covers the import flags, the
+// scale and the size and write time of every file the import read, so a stale cache won't open
+class ModelCache
+{
+public:
+	static constexpr uint32_t version = 4u;
+	// at least Mesh::maxLods
+	static constexpr size_t maxLods = 4u;
+	struct IndexSpan
+	{
+		const uint32_t* pIndices;
+		size_t count;
+	};
+	// points into the mapped file, valid while the cache is open
+	struct NodeView
+	{
+		// as imported, row major like aiMatrix4x4
+		const DirectX::XMFLOAT4X4* pTransform;
+		std::string_view name;
+		size_t childCount;
+		const uint32_t* pMeshes;
+		size_t meshCount;
+	};
+	struct MeshView
+	{
+		std::string_view name;
+		size_t material;
+		const unsigned char* pVertices;
+		size_t vertexCount;
+		size_t stride;
+		// of the quantized positions, if the material's layout has them
+		DV::PositionQuantization quantization;
+		// lod 0 is the mesh itself
+		IndexSpan lods[maxLods];
+		size_t lodCount;
+	};
+	// what cooking a mesh takes, collected while the meshes are built from the import
+	struct MeshData
+	{
+		std::string name;
+		uint32_t material = 0u;
+		uint32_t stride = 0u;
+		DV::PositionQuantization quantization;
+		std::vector<unsigned char> vertices;
+		std::vector<std::vector<uint32_t>> lods;
+		// valid while the data is
+		MeshView View() const noexcept;
+	};
+public:
+	ModelCache() = default;
+	ModelCache(const ModelCache&) = delete;
+	ModelCache& operator=(const ModelCache&) = delete;
+	~ModelCache();
+public:
+	// maps the cache of the model at path, false if there is none or it isn't current
+	bool Open(std::string_view path, unsigned importFlags, float scale) noexcept;
+	void Close() noexcept;
+	// nodes are in depth-first preorder, every node followed by its children's subtrees
+	size_t GetNodeCount() const noexcept;
+	NodeView GetNode(size_t i) const noexcept;
+	size_t GetMaterialCount() const noexcept;
+	Material::Description GetMaterial(size_t i) const;
+	size_t GetMeshCount() const noexcept;
+	MeshView GetMesh(size_t i) const noexcept;
+public:
+	// makes importer note the files it reads, they go into the key; call before ReadFile
+	static void TrackDependencies(Assimp::Importer& importer);
+	// cooks what importer read; a cache that can't be written only means the next load imports again
+	static bool Write(std::string_view path, unsigned importFlags, float scale, const Assimp::Importer& importer,
+		const std::vector<Material::Description>& materials, const std::vector<MeshData>& meshes) noexcept;
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint64_t fileSize;
+		uint64_t dependencies;
+		uint64_t nodes;
+		uint64_t nodeMeshes;
+		uint64_t materials;
+		uint64_t meshes;
+		uint32_t dependencyCount;
+		uint32_t nodeCount;
+		uint32_t nodeMeshCount;
+		uint32_t materialCount;
+		uint32_t meshCount;
+		uint32_t pad;
+	};
+	// every offset is from the start of the file, strings are zero terminated
+	struct NodeRecord
+	{
+		DirectX::XMFLOAT4X4 transform;
+		uint64_t name;
+		uint32_t childCount;
+		uint32_t meshCount;
+		// into the node mesh array
+		uint32_t firstMesh;
+		uint32_t pad;
+	};
+	struct MaterialRecord
+	{
+		uint64_t name;
+		uint64_t diffuseMap;
+		uint64_t specularMap;
+		uint64_t normalMap;
+		DirectX::XMFLOAT3 diffuseColor;
+		DirectX::XMFLOAT3 specularColor;
+		float shininess;
+		uint32_t pad;
+	};
+	struct MeshRecord
+	{
+		uint64_t name;
+		uint64_t vertices;
+		uint64_t indices[maxLods];
+		uint32_t indexCounts[maxLods];
+		uint32_t material;
+		uint32_t vertexCount;
+		uint32_t stride;
+		uint32_t lodCount;
+		DV::PositionQuantization quantization;
+	};
+private:
+	static std::string MakeCachePath(std::string_view path);
+	// 0 if a dependency is missing
+	static uint64_t MakeKey(const std::vector<std::string>& dependencies, unsigned importFlags, float scale) noexcept;
+	bool Validate() const noexcept;
+	template<typename T>
+	const T* At(uint64_t offset) const noexcept
+	{
+		return reinterpret_cast<const T*>(pData + offset);
+	}
+	std::string_view String(uint64_t offset) const noexcept;
+private:
+	void* file = nullptr;
+	void* mapping = nullptr;
+	const unsigned char* pData = nullptr;
+	size_t size = 0u;
+};
@@ -0,0 +1,133 @@
+#include "ModelLoader.h"
+#include "Model.h"
+#include "ModelSource.h"
+#include "Mesh.h"
+#include "StaticBatch.h"
+#include <Engine/Architecture/Material.h>
+#include <Framework/PerfLog.h>
+#include <Framework/ParallelFor.h>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+
+ModelLoader::ModelLoader(Graphics& gfx, std::string path_in, float scale, bool splitLargeMeshes, bool staticBatch)
+	:
+	gfx(gfx),
+	path(std::move(path_in)),
+	scale(scale),
+	splitLargeMeshes(splitLargeMeshes),
+	staticBatch(staticBatch)
+{
+	loading = std::async(std::launch::async, [this]
+	{
+		Load();
+	});
+}
+
+ModelLoader::~ModelLoader()
+{
+	cancelled = true;
+	if (loading.valid())
+	{
+		loading.wait();
+	}
+}
+
+Model* ModelLoader::Poll(size_t maxMeshes)
+{
+	PERF_SCOPE("ModelLoader::Poll");
+	if (loading.valid() && loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		loading.get();
+	}
+	if (!imported.load(std::memory_order_acquire))
+	{
+		return nullptr;
+	}
+	// meshes are taken out under the lock and added outside it, workers keep pushing meanwhile
+	std::vector<FinishedMesh> batch;
+	std::vector<std::unique_ptr<StaticBatch>> staticBatches;
+	{
+		std::lock_guard<std::mutex> lock(finishedMutex);
+		const auto count = std::min(maxMeshes, finished.size());
+		batch.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			batch.push_back(std::move(finished.front()));
+			finished.pop_front();
+		}
+		// static batches move meshes onto their buffers, every one has to be there
+		if (meshesAdded + batch.size() == meshCount)
+		{
+			staticBatches = std::move(batches);
+			batches.clear();
+		}
+	}
+	for (auto& f : batch)
+	{
+		pModel->AddMesh(f.index, std::move(f.pMesh));
+	}
+	meshesAdded += batch.size();
+	if (!staticBatches.empty())
+	{
+		pModel->SetStaticBatches(std::move(staticBatches));
+	}
+	return pModel.get();
+}
+
+bool ModelLoader::IsDone() const noexcept
+{
+	return imported.load(std::memory_order_acquire) && meshesAdded == meshCount;
+}
+
+float ModelLoader::GetProgress() const noexcept
+{
+	if (!imported.load(std::memory_order_acquire))
+	{
+		return 0.0f;
+	}
+	return meshCount > 0u ? float(meshesAdded) / float(meshCount) : 1.0f;
+}
+
+void ModelLoader::Load()
+{
+	PERF_SCOPE("ModelLoader::Load");
+	ModelSource source{ path, scale, splitLargeMeshes };
+	meshCount = source.GetMeshCount();
+	pModel = std::make_unique<Model>(source);
+	imported.store(true, std::memory_order_release);
+
+	// one core is left to the render thread
+	const auto threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1u;
+	// textures are decoded here, most of the wait on a big scene
+	materials.resize(source.GetMaterialCount());
+	ParallelFor(materials.size(), [&](size_t i)
+	{
+		if (cancelled)
+		{
+			return;
+		}
+		materials[i] = source.MakeMaterial(gfx, i);
+	}, threadCount);
+	ParallelFor(meshCount, [&](size_t i)
+	{
+		if (cancelled)
+		{
+			return;
+		}
+		auto pMesh = source.MakeMesh(gfx, *materials[source.GetMeshMaterial(i)], i);
+		std::lock_guard<std::mutex> lock(finishedMutex);
+		finished.push_back({ i, std::move(pMesh) });
+	}, threadCount);
+	// batches only read the source, they are built while the model is drawn
+	if (staticBatch && !cancelled)
+	{
+		auto built = Model::BuildStaticBatches(gfx, source, materials);
+		std::lock_guard<std::mutex> lock(finishedMutex);
+		batches = std::move(built);
+	}
+	// a cancelled load leaves parts out, Cook skips it then
+	source.Cook(materials);
+	// meshes copied what they needed, the materials can go with the source
+	materials.clear();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <Engine/Graphics.h>
+#include <Framework/noexcept_if.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <future>
+#include <atomic>
+
+class Model;
+class Mesh;
+class Material;
+class StaticBatch;
+
+// opens or imports a model and builds its materials and meshes on worker threads; the render thread
+// polls it once a frame and gets a model that fills in a few meshes at a time
+class ModelLoader
+{
+public:
+	// meshes handed to the model per poll, every poll that adds any rebuilds the model's bvh
+	static constexpr size_t meshesPerPoll = 8u;
+public:
+	// splitLargeMeshes as for ModelSource, staticBatch as for Model; batches are built once
+	// every mesh is and go into the model with the poll that adds its last mesh, or after
+	ModelLoader(Graphics& gfx, std::string path, float scale = 1.0f, bool splitLargeMeshes = false, bool staticBatch = false);
+	ModelLoader(const ModelLoader&) = delete;
+	ModelLoader& operator=(const ModelLoader&) = delete;
+	// stops handing out work and waits for whatever is being built
+	~ModelLoader();
+public:
+	// nullptr until the node tree is read, afterwards the model with up to maxMeshes more of
+	// the finished meshes added; rethrows what the workers threw
+	Model* Poll(size_t maxMeshes = meshesPerPoll);
+	// every mesh is in the model
+	bool IsDone() const noexcept;
+	// meshes added over meshes in the scene, 0 before the import
+	float GetProgress() const noexcept;
+private:
+	void Load();
+private:
+	struct FinishedMesh
+	{
+		size_t index;
+		std::unique_ptr<Mesh> pMesh;
+	};
+private:
+	Graphics& gfx;
+	std::string path;
+	float scale;
+	bool splitLargeMeshes;
+	bool staticBatch;
+	// built by the loading thread, only touched by Poll once imported is set
+	std::unique_ptr<Model> pModel;
+	std::atomic<bool> imported = false;
+	std::atomic<bool> cancelled = false;
+	size_t meshCount = 0u;
+	size_t meshesAdded = 0u;
+	std::vector<std::unique_ptr<Material>> materials;
+	std::mutex finishedMutex;
+	std::deque<FinishedMesh> finished;
+	// under finishedMutex too
+	std::vector<std::unique_ptr<StaticBatch>> batches;
+	std::future<void> loading;
+};
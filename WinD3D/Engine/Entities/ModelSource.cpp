@@ -0,0 +1,202 @@
+#include "ModelSource.h"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/config.h>
+#include "ModelException.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include <Engine/Architecture/Material.h>
+#include <Framework/PerfLog.h>
+#include <unordered_map>
+
+namespace
+{
+	// the same for every model, and part of the cache key
+	constexpr unsigned baseImportFlags =
+		aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_ConvertToLeftHanded |
+		aiProcess_GenNormals |
+		aiProcess_CalcTangentSpace;
+}
+
+ModelSource::ModelSource(std::string path_in, float scale, bool splitLargeMeshes)
+	:
+	path(std::move(path_in)),
+	scale(scale),
+	importFlags(baseImportFlags | (splitLargeMeshes ? unsigned(aiProcess_SplitLargeMeshes) : 0u))
+{
+	{
+		PERF_SCOPE("ModelSource::OpenCache");
+		if (cache.Open(path, importFlags, scale))
+		{
+			return;
+		}
+	}
+	PERF_SCOPE("ModelSource::Import");
+	pImporter = std::make_unique<Assimp::Importer>();
+	ModelCache::TrackDependencies(*pImporter);
+	pImporter->SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT, int(splitVertexLimit));
+	pScene = pImporter->ReadFile(path, importFlags);
+	if (pScene == nullptr)
+	{
+		throw ModelException(__LINE__, __FILE__, pImporter->GetErrorString());
+	}
+	// the codex keys mesh buffers by name, and split parts come out named like their mesh;
+	// assimp leaves the scene to its user to edit
+	std::unordered_map<std::string, size_t> nameCounts;
+	for (unsigned int i = 0; i < pScene->mNumMeshes; i++)
+	{
+		auto& name = pScene->mMeshes[i]->mName;
+		if (const auto n = nameCounts[name.C_Str()]++; n > 0u)
+		{
+			name.Set(std::string(name.C_Str()) + "#" + std::to_string(n));
+		}
+	}
+	cooked.resize(pScene->mNumMeshes);
+}
+
+ModelSource::~ModelSource() = default;
+
+const std::string& ModelSource::GetPath() const noexcept
+{
+	return path;
+}
+
+float ModelSource::GetScale() const noexcept
+{
+	return scale;
+}
+
+const aiScene* ModelSource::GetScene() const noexcept
+{
+	return pScene;
+}
+
+const ModelCache& ModelSource::GetCache() const noexcept
+{
+	return cache;
+}
+
+size_t ModelSource::GetMaterialCount() const noexcept
+{
+	return pScene != nullptr ? pScene->mNumMaterials : cache.GetMaterialCount();
+}
+
+size_t ModelSource::GetMeshCount() const noexcept
+{
+	return pScene != nullptr ? pScene->mNumMeshes : cache.GetMeshCount();
+}
+
+size_t ModelSource::GetMeshMaterial(size_t i) const noexcept
+{
+	return pScene != nullptr ? pScene->mMeshes[i]->mMaterialIndex : cache.GetMesh(i).material;
+}
+
+std::unique_ptr<Material> ModelSource::MakeMaterial(Graphics& gfx, size_t i) const
+{
+	if (pScene == nullptr)
+	{
+		return std::make_unique<Material>(gfx, cache.GetMaterial(i), path);
+	}
+	return std::make_unique<Material>(gfx, *pScene->mMaterials[i], path);
+}
+
+std::unique_ptr<Mesh> ModelSource::MakeMesh(Graphics& gfx, const Material& material, size_t i)
+{
+	if (pScene == nullptr)
+	{
+		return std::make_unique<Mesh>(gfx, material, cache.GetMesh(i));
+	}
+	const auto& mesh = *pScene->mMeshes[i];
+	if (auto pMesh = MakeResidentMesh(gfx, material, mesh))
+	{
+		return pMesh;
+	}
+	// vertices and triangles are put in gpu friendly order once, here, the cache keeps that order
+	auto vertices = material.ExtractVertices(mesh, scale);
+	auto indices = material.ExtractIndices(mesh);
+	MeshOptimizer::Optimize(vertices, indices);
+	auto& data = cooked[i];
+	data.name = mesh.mName.C_Str();
+	data.material = mesh.mMaterialIndex;
+	data.stride = uint32_t(material.GetVertexLayout().Size());
+	data.quantization = vertices.GetQuantization();
+	data.vertices.assign(vertices.data(), vertices.data() + vertices.Size());
+	data.lods.push_back(std::move(indices));
+	auto pMesh = std::make_unique<Mesh>(gfx, material, data.View(), true);
+	// the lods too, saves simplifying on the next load
+	for (size_t lod = 1u; lod < pMesh->GetLodCount(); lod++)
+	{
+		data.lods.push_back(pMesh->GetIndices(lod));
+	}
+	return pMesh;
+}
+
+std::unique_ptr<Mesh> ModelSource::MakeResidentMesh(Graphics& gfx, const Material& material, const aiMesh& mesh) const
+{
+	// the buffers hold what an earlier load of the model made; converting, optimizing and
+	// simplifying it again would only feed resolves that hit. the picking copy is read in
+	// import order, the indices reference the same vertices either way
+	const auto name = std::string_view(mesh.mName.C_Str());
+	auto pVertices = material.FindVertexBindable(name);
+	if (pVertices == nullptr)
+	{
+		return nullptr;
+	}
+	std::vector<std::shared_ptr<IndexBuffer>> lodBuffers;
+	while (lodBuffers.size() < Mesh::maxLods)
+	{
+		auto pIndices = material.FindIndexBindable(name, lodBuffers.size());
+		if (pIndices == nullptr)
+		{
+			break;
+		}
+		lodBuffers.push_back(std::move(pIndices));
+	}
+	if (lodBuffers.empty())
+	{
+		return nullptr;
+	}
+	std::vector<DirectX::XMFLOAT3> positions(mesh.mNumVertices);
+	for (unsigned int v = 0; v < mesh.mNumVertices; v++)
+	{
+		positions[v] = { mesh.mVertices[v].x * scale,mesh.mVertices[v].y * scale,mesh.mVertices[v].z * scale };
+	}
+	return std::make_unique<Mesh>(gfx, material, std::move(pVertices), std::move(lodBuffers),
+		material.ExtractQuantization(mesh, scale), std::move(positions), material.ExtractIndices(mesh));
+}
+
+ModelCache::MeshView ModelSource::GetMeshView(size_t i) const noexcept
+{
+	return pScene != nullptr ? cooked[i].View() : cache.GetMesh(i);
+}
+
+void ModelSource::Cook(const std::vector<std::unique_ptr<Material>>& materials)
+{
+	if (pScene == nullptr)
+	{
+		return;
+	}
+	PERF_SCOPE("ModelSource::Cook");
+	std::vector<Material::Description> descriptions;
+	for (const auto& pMaterial : materials)
+	{
+		if (pMaterial == nullptr)
+		{
+			return;
+		}
+		descriptions.push_back(pMaterial->GetDescription());
+	}
+	for (const auto& data : cooked)
+	{
+		if (data.lods.empty())
+		{
+			return;
+		}
+	}
+	ModelCache::Write(path, importFlags, scale, *pImporter, descriptions, cooked);
+	cooked.clear();
+	cooked.shrink_to_fit();
+}
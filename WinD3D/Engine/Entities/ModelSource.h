@@ -0,0 +1,63 @@
+#pragma once
+#include <Engine/Graphics.h>
+#include <Framework/noexcept_if.h>
+#include "ModelCache.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class Mesh;
+class Material;
+struct aiScene;
+struct aiMesh;
+namespace Assimp
+{
+	class Importer;
+}
+
+// where a model's parts come from: its cache when that is current, otherwise an assimp import
+// that gets cooked into a new cache once every part has been made from it
+class ModelSource
+{
+public:
+	// mesh vertices a 16 bit index reaches, what splitting cuts meshes down to
+	static constexpr unsigned splitVertexLimit = 0x10000u;
+public:
+	// meshes past 65536 vertices get 32 bit index buffers, unless split into parts that fit 16 bits;
+	// throws ModelException if there is no current cache and the import fails
+	ModelSource(std::string path, float scale = 1.0f, bool splitLargeMeshes = false);
+	ModelSource(const ModelSource&) = delete;
+	ModelSource& operator=(const ModelSource&) = delete;
+	~ModelSource();
+public:
+	const std::string& GetPath() const noexcept;
+	float GetScale() const noexcept;
+	// the import, nullptr when reading from the cache
+	const aiScene* GetScene() const noexcept;
+	const ModelCache& GetCache() const noexcept;
+	size_t GetMaterialCount() const noexcept;
+	size_t GetMeshCount() const noexcept;
+	// material index of mesh i
+	size_t GetMeshMaterial(size_t i) const noexcept;
+	// these may run for different i at once; an imported mesh whose buffers the codex still holds
+	// is made from those, and isn't cooked
+	std::unique_ptr<Material> MakeMaterial(Graphics& gfx, size_t i) const;
+	std::unique_ptr<Mesh> MakeMesh(Graphics& gfx, const Material& material, size_t i);
+	// what mesh i was made from; of an import, valid once MakeMesh made it and until Cook,
+	// and without vertices or lods if it was made from the codex
+	ModelCache::MeshView GetMeshView(size_t i) const noexcept;
+	// writes the cache of an import once every material and mesh was made from it, else does nothing
+	void Cook(const std::vector<std::unique_ptr<Material>>& materials);
+private:
+	// nullptr unless the codex holds the vertices and lod 0 of mesh
+	std::unique_ptr<Mesh> MakeResidentMesh(Graphics& gfx, const Material& material, const aiMesh& mesh) const;
+private:
+	std::string path;
+	float scale;
+	unsigned importFlags;
+	ModelCache cache;
+	std::unique_ptr<Assimp::Importer> pImporter;
+	const aiScene* pScene = nullptr;
+	// what MakeMesh made from the import, by mesh index
+	std::vector<ModelCache::MeshData> cooked;
+};
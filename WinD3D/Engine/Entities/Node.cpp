@@ -1,33 +1,16 @@
 #include "Node.h"
 #include "Mesh.h"
 #include "ModelProbe.h"
+#include "TransformHierarchy.h"
 
 namespace dx = DirectX;
 
-Node::Node(int id, std::string_view name, std::vector<Mesh*> meshPtrs, const DirectX::XMMATRIX& transform_in) noxnd
-	:id(id),
+Node::Node(int id, std::string_view name, std::vector<Mesh*> meshPtrs, TransformHierarchy& hierarchy) noxnd
+	:name(name),
+	id(id),
 	meshPtrs(std::move(meshPtrs)),
-	name(name)
-{
-	dx::XMStoreFloat4x4(&transform, transform_in);
-	dx::XMStoreFloat4x4(&appliedTransform, dx::XMMatrixIdentity());
-}
-
-void Node::Submit(FrameCommander& frame, DirectX::FXMMATRIX accumulatedTransform) const noxnd
-{
-	const auto built =
-		dx::XMLoadFloat4x4(&appliedTransform) *
-		dx::XMLoadFloat4x4(&transform) *
-		accumulatedTransform;
-	for (const auto pm : meshPtrs)
-	{
-		pm->Submit(frame, built);
-	}
-	for (const auto& pc : childPtrs)
-	{
-		pc->Submit(frame, built);
-	}
-}
+	hierarchy(hierarchy)
+{}
 
 void Node::AddChild(std::unique_ptr<Node> pChild) noxnd
 {
@@ -37,12 +20,12 @@ void Node::AddChild(std::unique_ptr<Node> pChild) noxnd
 
 void Node::SetAppliedTransform(DirectX::FXMMATRIX transform) noexcept
 {
-	dx::XMStoreFloat4x4(&appliedTransform, transform);
+	hierarchy.SetApplied(uint32_t(id), transform);
 }
 
 const DirectX::XMFLOAT4X4& Node::GetAppliedTransform() const noexcept
 {
-	return appliedTransform;
+	return hierarchy.GetApplied(uint32_t(id));
 }
 
 int Node::GetId() const noexcept
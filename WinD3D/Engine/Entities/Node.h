@@ -5,15 +5,15 @@
 
 class Model;
 class Mesh;
-class FrameCommander;
+class TransformHierarchy;
 
 class Node
 {
 	friend Model;
 public:
-	Node(int id, std::string_view name, std::vector<Mesh*> meshPtrs, const DirectX::XMMATRIX& transform) noxnd;
+	// id is the node's index in hierarchy, which holds its transforms
+	Node(int id, std::string_view name, std::vector<Mesh*> meshPtrs, TransformHierarchy& hierarchy) noxnd;
 public:
-	void Submit(FrameCommander& frame, DirectX::FXMMATRIX accumulatedTransform) const noxnd;
 	void SetAppliedTransform(DirectX::FXMMATRIX transform) noexcept;
 	const DirectX::XMFLOAT4X4& GetAppliedTransform() const noexcept;
 	int GetId() const noexcept;
@@ -34,6 +34,5 @@ private:
 	int id;
 	std::vector<std::unique_ptr<Node>> childPtrs;
 	std::vector<Mesh*> meshPtrs;
-	DirectX::XMFLOAT4X4 transform;
-	DirectX::XMFLOAT4X4 appliedTransform;
+	TransformHierarchy& hierarchy;
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "StaticBatch.h"
+#include "ModelSource.h"
+#include <Engine/Architecture/Material.h>
+#include <Framework/PerfLog.h>
+#include <algorithm>
+#include <cstring>
+
+StaticBatch::StaticBatch(Graphics& gfx, const Material& material, std::string_view name, const ModelSource& source, std::vector<uint32_t> meshes_in) noxnd
+	:
+	meshes(std::move(meshes_in))
+{
+	PERF_SCOPE("StaticBatch::Build");
+	const auto stride = material.GetVertexLayout().Size();
+	size_t vertexCount = 0u;
+	size_t indexCount = 0u;
+	for (const auto mesh : meshes)
+	{
+		const auto view = source.GetMeshView(mesh);
+		assert(view.stride == stride);
+		vertexCount += view.vertexCount;
+		for (size_t lod = 0; lod < std::min(view.lodCount, Mesh::maxLods); lod++)
+		{
+			indexCount += view.lods[lod].count;
+		}
+	}
+
+	// indices stay per mesh, the base vertex of each draw finds its mesh's vertices; so meshes
+	// that fit 16 bit indices keep them however big the batch gets
+	std::vector<unsigned char> vertices(vertexCount * stride);
+	std::vector<uint32_t> indices;
+	indices.reserve(indexCount);
+	size_t baseVertex = 0u;
+	for (const auto mesh : meshes)
+	{
+		const auto view = source.GetMeshView(mesh);
+		std::memcpy(vertices.data() + baseVertex * stride, view.pVertices, view.vertexCount * stride);
+		auto& meshRanges = ranges.emplace_back();
+		for (size_t lod = 0; lod < std::min(view.lodCount, Mesh::maxLods); lod++)
+		{
+			const auto& span = view.lods[lod];
+			meshRanges.push_back({ UINT(indices.size()),UINT(span.count),INT(baseVertex) });
+			indices.insert(indices.end(), span.pIndices, span.pIndices + span.count);
+		}
+		baseVertex += view.vertexCount;
+	}
+	pVertices = material.MakeVertexBindable(gfx, name, vertices.data(), vertices.size());
+	pIndices = material.MakeIndexBindable(gfx, name, 0u, indices);
+}
+
+const std::vector<uint32_t>& StaticBatch::GetMeshes() const noexcept
+{
+	return meshes;
+}
+
+void StaticBatch::Share(size_t i, Mesh& mesh) const noexcept
+{
+	mesh.ShareBuffers(pVertices, pIndices, ranges[i]);
+}
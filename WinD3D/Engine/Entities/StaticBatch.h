@@ -0,0 +1,41 @@
+#pragma once
+#include <Engine/Graphics.h>
+#include <Framework/noexcept_if.h>
+#include "Mesh.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class Material;
+class ModelSource;
+class VertexBuffer;
+class IndexBuffer;
+
+// the meshes of a model that share a material, every lod of each, in one vertex and one index
+// buffer; the meshes are moved onto their ranges of those and let their own buffers go.
+// nothing is baked: vertices keep their mesh's space and quantization, so all instances of a
+// mesh draw one range and still instance together, and culling and lods go by instance as
+// before. draws aren't merged, what it saves is switching buffers between them, as jobs of a
+// material sort next to each other. baking node transforms in could merge runs of instances into
+// one draw, but copies the vertices per instance, quantizes them to the batch's bounds and gives
+// up the instancing that already draws repeats of a mesh at once
+class StaticBatch
+{
+public:
+	// every mesh must use material; vertices and lods are read from source
+	StaticBatch(Graphics& gfx, const Material& material, std::string_view name, const ModelSource& source, std::vector<uint32_t> meshes_in) noxnd;
+	StaticBatch(const StaticBatch&) = delete;
+	StaticBatch& operator=(const StaticBatch&) = delete;
+public:
+	// scene indices of the batched meshes
+	const std::vector<uint32_t>& GetMeshes() const noexcept;
+	// moves the i-th batched mesh, made from the source the batch was, onto the batch's buffers
+	void Share(size_t i, Mesh& mesh) const noexcept;
+private:
+	std::vector<uint32_t> meshes;
+	// by batched mesh, by lod
+	std::vector<std::vector<Mesh::SharedRange>> ranges;
+	std::shared_ptr<VertexBuffer> pVertices;
+	std::shared_ptr<IndexBuffer> pIndices;
+};
@@ -2,6 +2,30 @@
 #include <fmt/printf.h>
 #include "Surface.h"
 #include <Framework/Utility.h>
+#include <objbase.h>
+
+namespace
+{
+	// WIC needs COM on the decoding thread, and textures get decoded on loader workers too;
+	// a thread that already has COM in another mode keeps it
+	class ComScope
+	{
+	public:
+		ComScope() noexcept
+			:
+			hr(CoInitializeEx(nullptr, COINIT_MULTITHREADED))
+		{}
+		~ComScope()
+		{
+			if (SUCCEEDED(hr))
+			{
+				CoUninitialize();
+			}
+		}
+	private:
+		HRESULT hr;
+	};
+}
 
 // surface exception stuff
 Surface::LoadException::LoadException(int line, const char* file, std::string_view filepath, std::string Note, HRESULT hr) noexcept
@@ -31,6 +55,7 @@ const std::string& Surface::LoadException::GetNote() const noexcept
 
 Surface::Surface(std::string_view filepath)
 {
+	static thread_local const ComScope com;
 	HRESULT hr = DirectX::LoadFromWICFile(ToWide(filepath).c_str(), DirectX::WIC_FLAGS_NONE, nullptr, image);
 
 	if (FAILED(hr))
@@ -0,0 +1,73 @@
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <cassert>
+
+namespace dx = DirectX;
+
+uint32_t TransformHierarchy::Add(uint32_t parent, DirectX::FXMMATRIX local) noxnd
+{
+	const auto node = uint32_t(parents.size());
+	assert(parent == noParent || parent < node);
+	parents.push_back(parent);
+	subtreeEnds.push_back(node + 1u);
+	locals.emplace_back();
+	dx::XMStoreFloat4x4(&locals.back(), local);
+	applied.emplace_back();
+	dx::XMStoreFloat4x4(&applied.back(), dx::XMMatrixIdentity());
+	composed.push_back(local);
+	world.push_back(dx::XMMatrixIdentity());
+	dirty.push_back(1u);
+	firstDirty = std::min(firstDirty, node);
+	return node;
+}
+
+DirectX::XMMATRIX TransformHierarchy::GetRestWorld(uint32_t node) const noexcept
+{
+	auto rest = dx::XMLoadFloat4x4(&locals[node]);
+	for (auto parent = parents[node]; parent != noParent; parent = parents[parent])
+	{
+		rest = rest * dx::XMLoadFloat4x4(&locals[parent]);
+	}
+	return rest;
+}
+
+void TransformHierarchy::CloseSubtree(uint32_t node) noexcept
+{
+	subtreeEnds[node] = uint32_t(parents.size());
+}
+
+void TransformHierarchy::SetApplied(uint32_t node, DirectX::FXMMATRIX applied_in) noexcept
+{
+	dx::XMStoreFloat4x4(&applied[node], applied_in);
+	composed[node] = applied_in * dx::XMLoadFloat4x4(&locals[node]);
+	dirty[node] = 1u;
+	firstDirty = std::min(firstDirty, node);
+}
+
+bool TransformHierarchy::Update() noexcept
+{
+	const auto count = uint32_t(parents.size());
+	if (firstDirty >= count)
+	{
+		return false;
+	}
+	for (auto i = firstDirty; i < count; )
+	{
+		if (!dirty[i])
+		{
+			i++;
+			continue;
+		}
+		// the whole subtree depends on i, and parents precede children, so one linear sweep does it
+		const auto end = subtreeEnds[i];
+		for (auto j = i; j < end; j++)
+		{
+			const auto parent = parents[j];
+			world[j] = parent == noParent ? composed[j] : composed[j] * world[parent];
+			dirty[j] = 0u;
+		}
+		i = end;
+	}
+	firstDirty = count;
+	return true;
+}
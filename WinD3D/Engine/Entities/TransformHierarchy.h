@@ -0,0 +1,48 @@
+#pragma once
+#include <DirectXMath.h>
+#include <Framework/noexcept_if.h>
+#include <vector>
+#include <cstdint>
+
+// node transforms of a model flattened into parent-before-child arrays; world matrices
+// are cached and only the subtrees under a changed applied transform are recomputed
+class TransformHierarchy
+{
+public:
+	static constexpr uint32_t noParent = ~uint32_t(0);
+public:
+	// nodes must be added in depth-first preorder, the returned index is the node's id
+	uint32_t Add(uint32_t parent, DirectX::FXMMATRIX local) noxnd;
+	// call after the last descendant of node has been added
+	void CloseSubtree(uint32_t node) noexcept;
+	void SetApplied(uint32_t node, DirectX::FXMMATRIX applied) noexcept;
+	const DirectX::XMFLOAT4X4& GetApplied(uint32_t node) const noexcept
+	{
+		return applied[node];
+	}
+	// brings every world matrix up to date, false if none had to change
+	bool Update() noexcept;
+	DirectX::XMMATRIX GetWorld(uint32_t node) const noexcept
+	{
+		return world[node];
+	}
+	// world matrix with every applied transform left out, i.e. as imported; reads only what
+	// Add wrote, so other threads may call it while the hierarchy is changed and updated
+	DirectX::XMMATRIX GetRestWorld(uint32_t node) const noexcept;
+	size_t GetCount() const noexcept
+	{
+		return parents.size();
+	}
+private:
+	std::vector<uint32_t> parents;
+	// one past the last descendant, so a subtree is the range [node, subtreeEnd[node])
+	std::vector<uint32_t> subtreeEnds;
+	std::vector<DirectX::XMFLOAT4X4> locals;
+	std::vector<DirectX::XMFLOAT4X4> applied;
+	// applied * local, the only per-node factor world recomputation needs
+	std::vector<DirectX::XMMATRIX> composed;
+	std::vector<DirectX::XMMATRIX> world;
+	std::vector<uint8_t> dirty;
+	// nothing before this index is dirty
+	uint32_t firstDirty = 0u;
+};
@@ -5,6 +5,7 @@
 #include "ImGUI\imgui_impl_win32.h"
 
 #include "GraphicsThrows.m"
+#include <Framework/PerfLog.h>
 
 #pragma comment(lib,"d3d11.lib")
 #pragma comment(lib,"D3DCompiler.lib")
@@ -74,7 +75,9 @@ const char* Graphics::DeviceRemovedException::GetType()const noexcept
 Graphics::Graphics(HWND hWnd, unsigned width, unsigned height)
 	:imguiEnabled(true), 
 	projection(DirectX::XMMatrixIdentity()), 
-	camera(DirectX::XMMatrixIdentity())
+	camera(DirectX::XMMatrixIdentity()),
+	width(width),
+	height(height)
 {
 	DXGI_SWAP_CHAIN_DESC DSwapDesc = {};
 	DSwapDesc.BufferDesc.Width = width;
@@ -188,6 +191,8 @@ bool Graphics::IsImguiEnabled() const noexcept
 
 void Graphics::BeginFrame(float r, float g, float b) noexcept
 {
+	PERF_SCOPE("Graphics::BeginFrame");
+	bindCache.NextFrame();
 	if (imguiEnabled)
 	{
 		ImGui_ImplDX11_NewFrame();
@@ -195,16 +200,22 @@ void Graphics::BeginFrame(float r, float g, float b) noexcept
 		ImGui::NewFrame();
 	}
 	const float color[] = { r,g,b,1.0f };
+	// loader threads upload textures through the context too
+	std::lock_guard<std::mutex> lock(contextMutex);
 	pContext->ClearRenderTargetView(pTarget.Get(), color);
 	pContext->ClearDepthStencilView(pDSV.Get(), D3D11_CLEAR_STENCIL | D3D11_CLEAR_DEPTH, 1.0f, 0u);
 }
 void Graphics::EndFrame()
 {
+	PERF_SCOPE("Graphics::EndFrame");
+	std::lock_guard<std::mutex> lock(contextMutex);
 	// imgui render
 	if (imguiEnabled)
 	{
 		ImGui::Render();
 		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+		// imgui sets its own pipeline state
+		bindCache.Invalidate();
 	}
 
 	HRESULT hr;
@@ -240,9 +251,166 @@ DirectX::XMMATRIX Graphics::GetProjection() const noexcept
 {
 	return projection;
 }
-void Graphics::DrawIndexed(UINT count) noexcept(!IS_DEBUG)
+DirectX::BoundingFrustum Graphics::GetFrustum() const noexcept
 {
-	GFX_THROW_INFO_ONLY(pContext->DrawIndexed(count, 0u, 0u));
+	DirectX::BoundingFrustum frustum;
+	DirectX::BoundingFrustum::CreateFromMatrix(frustum, projection);
+	frustum.Transform(frustum, DirectX::XMMatrixInverse(nullptr, camera));
+	return frustum;
+}
+const BindCache& Graphics::GetBindCache() const noexcept
+{
+	return bindCache;
+}
+unsigned Graphics::GetWidth() const noexcept
+{
+	return width;
+}
+unsigned Graphics::GetHeight() const noexcept
+{
+	return height;
+}
+void Graphics::DrawIndexed(UINT count, UINT startIndex, INT baseVertex) noexcept(!IS_DEBUG)
+{
+	GFX_THROW_INFO_ONLY(pContext->DrawIndexed(count, startIndex, baseVertex));
+}
+void Graphics::DrawIndexedInstanced(UINT count, UINT instances, UINT startIndex, INT baseVertex) noexcept(!IS_DEBUG)
+{
+	GFX_THROW_INFO_ONLY(pContext->DrawIndexedInstanced(count, instances, startIndex, baseVertex, 0u));
+}
+
+// CommandStream replay target for the immediate context
+class Graphics::ContextBackend : public CommandBackend
+{
+public:
+	ContextBackend(Graphics& gfx) noexcept
+		:
+		gfx(gfx),
+		pContext(gfx.pContext.Get()),
+		cache(gfx.bindCache)
+	{}
+	void SetTopology(D3D11_PRIMITIVE_TOPOLOGY type) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::Topology, 0u, (const void*)uintptr_t(type)))
+		{
+			pContext->IASetPrimitiveTopology(type);
+		}
+	}
+	void SetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::IndexBuffer, 0u, pBuffer))
+		{
+			pContext->IASetIndexBuffer(pBuffer, format, 0u);
+		}
+	}
+	void SetVertexBuffer(ID3D11Buffer* pBuffer, UINT stride) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::VertexBuffer, 0u, pBuffer))
+		{
+			const UINT offset = 0u;
+			pContext->IASetVertexBuffers(0u, 1u, &pBuffer, &stride, &offset);
+		}
+	}
+	void SetInputLayout(ID3D11InputLayout* pLayout) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::InputLayout, 0u, pLayout))
+		{
+			pContext->IASetInputLayout(pLayout);
+		}
+	}
+	void SetVertexShader(ID3D11VertexShader* pShader) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::VertexShader, 0u, pShader))
+		{
+			pContext->VSSetShader(pShader, nullptr, 0u);
+		}
+	}
+	void SetPixelShader(ID3D11PixelShader* pShader) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::PixelShader, 0u, pShader))
+		{
+			pContext->PSSetShader(pShader, nullptr, 0u);
+		}
+	}
+	void SetVertexConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::VertexConstantBuffer, slot, pBuffer))
+		{
+			pContext->VSSetConstantBuffers(slot, 1u, &pBuffer);
+		}
+	}
+	void SetPixelConstantBuffer(UINT slot, ID3D11Buffer* pBuffer) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::PixelConstantBuffer, slot, pBuffer))
+		{
+			pContext->PSSetConstantBuffers(slot, 1u, &pBuffer);
+		}
+	}
+	void SetPixelResource(UINT slot, ID3D11ShaderResourceView* pView) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::PixelResource, slot, pView))
+		{
+			pContext->PSSetShaderResources(slot, 1u, &pView);
+		}
+	}
+	void SetPixelSampler(UINT slot, ID3D11SamplerState* pSampler) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::PixelSampler, slot, pSampler))
+		{
+			pContext->PSSetSamplers(slot, 1u, &pSampler);
+		}
+	}
+	void SetBlend(ID3D11BlendState* pState) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::Blend, 0u, pState))
+		{
+			pContext->OMSetBlendState(pState, nullptr, 0xFFFFFFFFu);
+		}
+	}
+	void SetDepthStencil(ID3D11DepthStencilState* pState) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::DepthStencil, 0u, pState))
+		{
+			pContext->OMSetDepthStencilState(pState, 0xFF);
+		}
+	}
+	void SetRasterizer(ID3D11RasterizerState* pState) noexcept override
+	{
+		if (cache.Update(BindCache::Stage::Rasterizer, 0u, pState))
+		{
+			pContext->RSSetState(pState);
+		}
+	}
+	void UpdateBuffer(ID3D11Buffer* pBuffer, const void* pData, size_t size) noexcept(!IS_DEBUG) override
+	{
+		HRESULT hr;
+#ifndef NDEBUG
+		auto& infoManager = gfx.infoManager;
+#endif
+		D3D11_MAPPED_SUBRESOURCE msr = {};
+		GFX_THROW_INFO(pContext->Map(pBuffer, 0u, D3D11_MAP_WRITE_DISCARD, 0u, &msr));
+		memcpy(msr.pData, pData, size);
+		pContext->Unmap(pBuffer, 0u);
+	}
+	void DrawIndexed(UINT count, UINT startIndex, INT baseVertex) noexcept(!IS_DEBUG) override
+	{
+		gfx.DrawIndexed(count, startIndex, baseVertex);
+	}
+	void DrawIndexedInstanced(UINT count, UINT instances, UINT startIndex, INT baseVertex) noexcept(!IS_DEBUG) override
+	{
+		gfx.DrawIndexedInstanced(count, instances, startIndex, baseVertex);
+	}
+private:
+	Graphics& gfx;
+	ID3D11DeviceContext* pContext;
+	BindCache& cache;
+};
+
+void Graphics::Execute(const CommandStream& commands) noexcept(!IS_DEBUG)
+{
+	std::lock_guard<std::mutex> lock(contextMutex);
+	ContextBackend backend{ *this };
+	commands.Replay(backend);
 }
 
 
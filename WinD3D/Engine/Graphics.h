@@ -6,6 +6,10 @@
 #include <wrl.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <mutex>
+#include "BindCache.h"
+#include "CommandStream.h"
 
 class Graphics
 {
@@ -60,16 +64,33 @@ public:
 	void EndFrame();
 	DirectX::XMMATRIX GetCamera()const noexcept;
 	void SetCamera(DirectX::XMMATRIX Camera)noexcept;
-	void DrawIndexed(UINT count)noexcept(!IS_DEBUG);
+	// start and base offset into buffers several drawables share
+	void DrawIndexed(UINT count, UINT startIndex = 0u, INT baseVertex = 0)noexcept(!IS_DEBUG);
+	void DrawIndexedInstanced(UINT count, UINT instances, UINT startIndex = 0u, INT baseVertex = 0)noexcept(!IS_DEBUG);
+	// replays a recorded stream on the immediate context, skipping binds that are already in place
+	void Execute(const CommandStream& commands)noexcept(!IS_DEBUG);
 	DirectX::XMMATRIX GetProjection() const noexcept;
 	void SetProjection(DirectX::FXMMATRIX proj) noexcept;
+	// view frustum of the current camera and projection, in world space
+	DirectX::BoundingFrustum GetFrustum() const noexcept;
+	const BindCache& GetBindCache() const noexcept;
+	unsigned GetWidth() const noexcept;
+	unsigned GetHeight() const noexcept;
+private:
+	class ContextBackend;
 private:
 	DirectX::XMMATRIX projection;
 	DirectX::XMMATRIX camera;
+	unsigned width;
+	unsigned height;
 #ifndef NDEBUG
 	DXGIInfoManager infoManager;
 #endif
 	bool imguiEnabled;
+	// immediate context is not free-threaded, resource creation off the
+	// render thread has to go through this when it touches the context
+	std::mutex contextMutex;
+	BindCache bindCache;
 private:
 	Microsoft::WRL::ComPtr<ID3D11Device> pDevice;
 	Microsoft::WRL::ComPtr<IDXGISwapChain> pSwap;
@@ -0,0 +1,432 @@
+#include "OcclusionBuffer.h"
+#include <Framework/PerfLog.h>
+#include <algorithm>
+#include <thread>
+#include <cassert>
+#include <utility>
+#include <cmath>
+#include <cfloat>
+
+namespace dx = DirectX;
+
+namespace
+{
+	// clips a clip space triangle to the near plane z = 0, returns how many vertices are left (0, 3 or 4)
+	size_t ClipNear(const dx::XMFLOAT4* in, dx::XMFLOAT4* out) noexcept
+	{
+		size_t count = 0u;
+		for (size_t i = 0; i < 3u; i++)
+		{
+			const auto& a = in[i];
+			const auto& b = in[(i + 1u) % 3u];
+			if (a.z >= 0.0f)
+			{
+				out[count++] = a;
+			}
+			if ((a.z >= 0.0f) != (b.z >= 0.0f))
+			{
+				const auto t = a.z / (a.z - b.z);
+				dx::XMStoreFloat4(&out[count++], dx::XMVectorLerp(dx::XMLoadFloat4(&a), dx::XMLoadFloat4(&b), t));
+			}
+		}
+		return count;
+	}
+}
+
+OcclusionBuffer::OcclusionBuffer()
+	:
+	pool(std::min(std::max(std::thread::hardware_concurrency(), 2u) - 1u, 3u))
+{
+	dx::XMStoreFloat4x4(&viewProj, dx::XMMatrixIdentity());
+	bins.resize(tilesX * tilesY);
+	auto w = width;
+	auto h = height;
+	levels.push_back({ w,h,{},std::vector<float>(size_t(w) * h, 1.0f) });
+	while (w > 1u || h > 1u)
+	{
+		w = (w + 1u) / 2u;
+		h = (h + 1u) / 2u;
+		levels.push_back({ w,h,std::vector<float>(size_t(w) * h, 1.0f),std::vector<float>(size_t(w) * h, 1.0f) });
+	}
+	rasterizer = std::thread([this] { Loop(); });
+}
+
+OcclusionBuffer::~OcclusionBuffer()
+{
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+		signal.wait(lock, [this] { return !pending || finished; });
+		stopping = true;
+	}
+	signal.notify_all();
+	rasterizer.join();
+}
+
+void OcclusionBuffer::Begin(DirectX::FXMMATRIX viewProj_in)
+{
+	Resolve();
+	ready = false;
+	dx::XMStoreFloat4x4(&viewProj, viewProj_in);
+	occluders.clear();
+	stats = {};
+}
+
+void OcclusionBuffer::AddOccluder(DirectX::FXMMATRIX world, const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices)
+{
+	auto& o = occluders.emplace_back();
+	dx::XMStoreFloat4x4(&o.world, world);
+	o.pPositions = &positions;
+	o.pIndices = &indices;
+	stats.occluders++;
+	stats.triangles += indices.size() / 3u;
+}
+
+void OcclusionBuffer::Rasterize()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		assert(!pending && "Resolve the last rasterization first");
+		pending = true;
+		finished = false;
+	}
+	signal.notify_all();
+}
+
+void OcclusionBuffer::Resolve()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	if (!pending)
+	{
+		return;
+	}
+	signal.wait(lock, [this] { return finished; });
+	pending = false;
+	if (pError)
+	{
+		std::rethrow_exception(std::exchange(pError, nullptr));
+	}
+	ready = true;
+}
+
+void OcclusionBuffer::Loop() noexcept
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	while (true)
+	{
+		signal.wait(lock, [this] { return stopping || (pending && !finished); });
+		if (stopping)
+		{
+			return;
+		}
+		lock.unlock();
+		std::exception_ptr error;
+		try
+		{
+			PERF_SCOPE("Occlusion::Rasterize");
+			Setup();
+			pool.Run(size_t(tilesX) * tilesY, [this](size_t tile)
+			{
+				RasterizeTile(uint32_t(tile));
+			});
+			BuildPyramid();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		lock.lock();
+		pError = error;
+		finished = true;
+		signal.notify_all();
+	}
+}
+
+bool OcclusionBuffer::IsOccluded(const DirectX::BoundingBox& box) noexcept
+{
+	stats.tested++;
+	if (!ready)
+	{
+		return false;
+	}
+	dx::XMFLOAT3 corners[dx::BoundingBox::CORNER_COUNT];
+	box.GetCorners(corners);
+	const auto vp = dx::XMLoadFloat4x4(&viewProj);
+	auto minX = FLT_MAX;
+	auto minY = FLT_MAX;
+	auto maxX = -FLT_MAX;
+	auto maxY = -FLT_MAX;
+	auto minZ = FLT_MAX;
+	for (const auto& corner : corners)
+	{
+		dx::XMFLOAT4 clip;
+		dx::XMStoreFloat4(&clip, dx::XMVector3Transform(dx::XMLoadFloat3(&corner), vp));
+		// reaching past the near plane, the box may be right in front of the camera
+		if (clip.z < 0.0f)
+		{
+			return false;
+		}
+		const auto invW = 1.0f / clip.w;
+		const auto x = (clip.x * invW * 0.5f + 0.5f) * float(width);
+		const auto y = (0.5f - clip.y * invW * 0.5f) * float(height);
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		minZ = std::min(minZ, clip.z * invW);
+	}
+	// off screen is for frustum culling to decide
+	if (maxX < 0.0f || maxY < 0.0f || minX >= float(width) || minY >= float(height))
+	{
+		return false;
+	}
+	// every pixel the box touches, not only those whose centers it covers
+	const auto x0 = uint32_t(std::max(minX, 0.0f));
+	const auto y0 = uint32_t(std::max(minY, 0.0f));
+	const auto x1 = uint32_t(std::min(maxX, float(width - 1u)));
+	const auto y1 = uint32_t(std::min(maxY, float(height - 1u)));
+	// start on the level where the box covers at most 2x2 texels
+	size_t level = 0u;
+	while (level + 1u < levels.size() && ((x1 >> level) - (x0 >> level) > 1u || (y1 >> level) - (y0 >> level) > 1u))
+	{
+		level++;
+	}
+	const auto occluded = IsRegionOccluded(level, x0, y0, x1, y1, minZ);
+	if (occluded)
+	{
+		stats.occluded++;
+	}
+	return occluded;
+}
+
+const OcclusionBuffer::Stats& OcclusionBuffer::GetStats() const noexcept
+{
+	return stats;
+}
+
+size_t OcclusionBuffer::GetLevelCount() const noexcept
+{
+	return levels.size();
+}
+
+uint32_t OcclusionBuffer::GetLevelWidth(size_t level) const noexcept
+{
+	return levels[level].width;
+}
+
+uint32_t OcclusionBuffer::GetLevelHeight(size_t level) const noexcept
+{
+	return levels[level].height;
+}
+
+const float* OcclusionBuffer::GetMinDepth(size_t level) const noexcept
+{
+	return level == 0u ? levels[0].maxDepth.data() : levels[level].minDepth.data();
+}
+
+const float* OcclusionBuffer::GetMaxDepth(size_t level) const noexcept
+{
+	return levels[level].maxDepth.data();
+}
+
+void OcclusionBuffer::Setup()
+{
+	triangles.clear();
+	for (auto& bin : bins)
+	{
+		bin.clear();
+	}
+	const auto vp = dx::XMLoadFloat4x4(&viewProj);
+	std::vector<dx::XMFLOAT4> clip;
+	for (const auto& o : occluders)
+	{
+		const auto& positions = *o.pPositions;
+		const auto& indices = *o.pIndices;
+		clip.resize(positions.size());
+		dx::XMVector3TransformStream(clip.data(), sizeof(dx::XMFLOAT4), positions.data(), sizeof(dx::XMFLOAT3),
+			positions.size(), dx::XMLoadFloat4x4(&o.world) * vp);
+		for (size_t i = 0; i + 2u < indices.size(); i += 3u)
+		{
+			const dx::XMFLOAT4 tri[3] = { clip[indices[i]],clip[indices[i + 1u]],clip[indices[i + 2u]] };
+			if (tri[0].z >= 0.0f && tri[1].z >= 0.0f && tri[2].z >= 0.0f)
+			{
+				SetupTriangle(tri);
+				continue;
+			}
+			dx::XMFLOAT4 clipped[4];
+			const auto count = ClipNear(tri, clipped);
+			if (count >= 3u)
+			{
+				SetupTriangle(clipped);
+			}
+			if (count == 4u)
+			{
+				const dx::XMFLOAT4 second[3] = { clipped[0],clipped[2],clipped[3] };
+				SetupTriangle(second);
+			}
+		}
+	}
+	stats.rasterized = triangles.size();
+
+	for (uint32_t i = 0; i < uint32_t(triangles.size()); i++)
+	{
+		const auto& t = triangles[i];
+		for (auto ty = t.minY / tileHeight; ty <= t.maxY / tileHeight; ty++)
+		{
+			for (auto tx = t.minX / tileWidth; tx <= t.maxX / tileWidth; tx++)
+			{
+				bins[ty * tilesX + tx].push_back(i);
+			}
+		}
+	}
+}
+
+void OcclusionBuffer::SetupTriangle(const DirectX::XMFLOAT4* clip) noexcept
+{
+	float x[3];
+	float y[3];
+	float z[3];
+	for (size_t i = 0; i < 3u; i++)
+	{
+		const auto invW = 1.0f / clip[i].w;
+		x[i] = (clip[i].x * invW * 0.5f + 0.5f) * float(width);
+		y[i] = (0.5f - clip[i].y * invW * 0.5f) * float(height);
+		z[i] = clip[i].z * invW;
+	}
+	// front faces are clockwise on screen, same as the rasterizer state; backfaces and slivers go
+	const auto area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(area > 0.0f))
+	{
+		return;
+	}
+	// pixels whose centers fall inside the bounds
+	const auto minX = std::max(std::ceil(std::min({ x[0],x[1],x[2] }) - 0.5f), 0.0f);
+	const auto minY = std::max(std::ceil(std::min({ y[0],y[1],y[2] }) - 0.5f), 0.0f);
+	const auto maxX = std::min(std::floor(std::max({ x[0],x[1],x[2] }) - 0.5f), float(width - 1u));
+	const auto maxY = std::min(std::floor(std::max({ y[0],y[1],y[2] }) - 0.5f), float(height - 1u));
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	Triangle t;
+	for (size_t i = 0; i < 3u; i++)
+	{
+		const auto j = (i + 1u) % 3u;
+		t.a[i] = y[i] - y[j];
+		t.b[i] = x[j] - x[i];
+		t.c[i] = (y[j] - y[i]) * x[i] - (x[j] - x[i]) * y[i];
+	}
+	t.zx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	t.zy = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+	t.z0 = z[0] - t.zx * x[0] - t.zy * y[0];
+	t.minX = uint32_t(minX);
+	t.minY = uint32_t(minY);
+	t.maxX = uint32_t(maxX);
+	t.maxY = uint32_t(maxY);
+	triangles.push_back(t);
+}
+
+void OcclusionBuffer::RasterizeTile(uint32_t tile) noexcept
+{
+	const auto tileX0 = (tile % tilesX) * tileWidth;
+	const auto tileY0 = (tile / tilesX) * tileHeight;
+	auto& depth = levels[0].maxDepth;
+	for (auto y = tileY0; y < tileY0 + tileHeight; y++)
+	{
+		std::fill_n(depth.begin() + size_t(y) * width + tileX0, tileWidth, 1.0f);
+	}
+
+	const auto zero = dx::XMVectorZero();
+	const auto laneOffsets = dx::XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	for (const auto i : bins[tile])
+	{
+		const auto& t = triangles[i];
+		// start on a multiple of 4 so spans stay inside the tile, the edge tests mask the extra lanes
+		const auto xBegin = std::max(t.minX, tileX0) & ~3u;
+		const auto xEnd = std::min(t.maxX, tileX0 + tileWidth - 1u);
+		const auto yBegin = std::max(t.minY, tileY0);
+		const auto yEnd = std::min(t.maxY, tileY0 + tileHeight - 1u);
+		const auto a0 = dx::XMVectorReplicate(t.a[0]);
+		const auto a1 = dx::XMVectorReplicate(t.a[1]);
+		const auto a2 = dx::XMVectorReplicate(t.a[2]);
+		const auto zx = dx::XMVectorReplicate(t.zx);
+		for (auto y = yBegin; y <= yEnd; y++)
+		{
+			const auto py = float(y) + 0.5f;
+			const auto c0 = dx::XMVectorReplicate(t.b[0] * py + t.c[0]);
+			const auto c1 = dx::XMVectorReplicate(t.b[1] * py + t.c[1]);
+			const auto c2 = dx::XMVectorReplicate(t.b[2] * py + t.c[2]);
+			const auto cz = dx::XMVectorReplicate(t.zy * py + t.z0);
+			auto pRow = depth.data() + size_t(y) * width;
+			for (auto x = xBegin; x <= xEnd; x += 4u)
+			{
+				const auto px = dx::XMVectorAdd(dx::XMVectorReplicate(float(x)), laneOffsets);
+				const auto inside = dx::XMVectorAndInt(
+					dx::XMVectorAndInt(
+						dx::XMVectorGreaterOrEqual(dx::XMVectorMultiplyAdd(a0, px, c0), zero),
+						dx::XMVectorGreaterOrEqual(dx::XMVectorMultiplyAdd(a1, px, c1), zero)),
+					dx::XMVectorGreaterOrEqual(dx::XMVectorMultiplyAdd(a2, px, c2), zero));
+				const auto z = dx::XMVectorMultiplyAdd(zx, px, cz);
+				const auto pDepth = reinterpret_cast<dx::XMFLOAT4*>(pRow + x);
+				const auto current = dx::XMLoadFloat4(pDepth);
+				dx::XMStoreFloat4(pDepth, dx::XMVectorSelect(current, dx::XMVectorMin(current, z), inside));
+			}
+		}
+	}
+}
+
+void OcclusionBuffer::BuildPyramid() noexcept
+{
+	for (size_t level = 1u; level < levels.size(); level++)
+	{
+		const auto& src = levels[level - 1u];
+		auto& dst = levels[level];
+		const auto pSrcMin = level == 1u ? src.maxDepth.data() : src.minDepth.data();
+		const auto pSrcMax = src.maxDepth.data();
+		for (uint32_t y = 0; y < dst.height; y++)
+		{
+			// odd sizes repeat the last row/column
+			const auto row0 = size_t(2u * y) * src.width;
+			const auto row1 = size_t(std::min(2u * y + 1u, src.height - 1u)) * src.width;
+			for (uint32_t x = 0; x < dst.width; x++)
+			{
+				const auto col0 = 2u * x;
+				const auto col1 = std::min(2u * x + 1u, src.width - 1u);
+				dst.minDepth[size_t(y) * dst.width + x] = std::min({ pSrcMin[row0 + col0],pSrcMin[row0 + col1],pSrcMin[row1 + col0],pSrcMin[row1 + col1] });
+				dst.maxDepth[size_t(y) * dst.width + x] = std::max({ pSrcMax[row0 + col0],pSrcMax[row0 + col1],pSrcMax[row1 + col0],pSrcMax[row1 + col1] });
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::IsRegionOccluded(size_t level, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, float depth) const noexcept
+{
+	const auto& l = levels[level];
+	const auto pMax = l.maxDepth.data();
+	const auto pMin = level == 0u ? pMax : l.minDepth.data();
+	for (auto ty = y0 >> level; ty <= y1 >> level; ty++)
+	{
+		for (auto tx = x0 >> level; tx <= x1 >> level; tx++)
+		{
+			const auto i = size_t(ty) * l.width + tx;
+			// everything drawn in this texel is in front of the box
+			if (depth > pMax[i])
+			{
+				continue;
+			}
+			// the box's nearest point is in front of something here
+			if (level == 0u || depth <= pMin[i])
+			{
+				return false;
+			}
+			// in between, decide on the finer texels the box covers
+			if (!IsRegionOccluded(level - 1u,
+				std::max(x0, tx << level), std::max(y0, ty << level),
+				std::min(x1, ((tx + 1u) << level) - 1u), std::min(y1, ((ty + 1u) << level) - 1u), depth))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
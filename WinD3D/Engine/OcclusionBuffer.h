@@ -0,0 +1,123 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <Framework/WorkerPool.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdint>
+
+// low resolution, depth-only software rasterizer: occluders are drawn tile by tile on worker
+// threads, the depth is reduced into a min/max pyramid, and boxes are tested against that
+// before their meshes get submitted. the threads are started with the buffer and parked between
+// frames. nothing here touches the device, so it also runs headless
+class OcclusionBuffer
+{
+public:
+	struct Stats
+	{
+		size_t occluders = 0u;
+		// occluder triangles handed in and those left after clipping and backface culling
+		size_t triangles = 0u;
+		size_t rasterized = 0u;
+		size_t tested = 0u;
+		size_t occluded = 0u;
+	};
+public:
+	static constexpr uint32_t width = 320u;
+	static constexpr uint32_t height = 192u;
+	// tiles are the unit of work of the rasterizer threads, widths are kept multiples of 4 for SIMD
+	static constexpr uint32_t tileWidth = 32u;
+	static constexpr uint32_t tileHeight = 32u;
+public:
+	OcclusionBuffer();
+	OcclusionBuffer(const OcclusionBuffer&) = delete;
+	OcclusionBuffer& operator=(const OcclusionBuffer&) = delete;
+	~OcclusionBuffer();
+public:
+	// starts over for a frame seen through viewProj (view * projection)
+	void Begin(DirectX::FXMMATRIX viewProj);
+	// geometry is referenced, not copied, it has to stay alive until Resolve
+	void AddOccluder(DirectX::FXMMATRIX world, const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices);
+	// starts rasterizing the occluders on worker threads and returns right away
+	void Rasterize();
+	// waits for rasterization to finish, boxes can be tested after this; rethrows what it threw
+	void Resolve();
+	// true only if the world space box is certainly hidden behind the occluders
+	bool IsOccluded(const DirectX::BoundingBox& box) noexcept;
+	const Stats& GetStats() const noexcept;
+	// level 0 is the full resolution depth buffer, each level above halves it rounding up;
+	// depth is post-projection z, 1 where nothing was drawn
+	size_t GetLevelCount() const noexcept;
+	uint32_t GetLevelWidth(size_t level) const noexcept;
+	uint32_t GetLevelHeight(size_t level) const noexcept;
+	const float* GetMinDepth(size_t level) const noexcept;
+	const float* GetMaxDepth(size_t level) const noexcept;
+private:
+	struct Occluder
+	{
+		DirectX::XMFLOAT4X4 world;
+		const std::vector<DirectX::XMFLOAT3>* pPositions;
+		const std::vector<uint32_t>* pIndices;
+	};
+	struct Triangle
+	{
+		// edge functions a * x + b * y + c, all three >= 0 inside
+		float a[3];
+		float b[3];
+		float c[3];
+		// depth plane z = zx * x + zy * y + z0
+		float zx;
+		float zy;
+		float z0;
+		// covered pixels, inclusive
+		uint32_t minX;
+		uint32_t minY;
+		uint32_t maxX;
+		uint32_t maxY;
+	};
+	struct Level
+	{
+		uint32_t width;
+		uint32_t height;
+		// level 0 only fills maxDepth, with one sample per texel min and max are the same
+		std::vector<float> minDepth;
+		std::vector<float> maxDepth;
+	};
+private:
+	// the rasterizing thread: waits for Rasterize, then sets up, bins and hands the tiles out to
+	// itself and the pool's helpers
+	void Loop() noexcept;
+	void Setup();
+	void SetupTriangle(const DirectX::XMFLOAT4* clip) noexcept;
+	void RasterizeTile(uint32_t tile) noexcept;
+	void BuildPyramid() noexcept;
+	bool IsRegionOccluded(size_t level, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, float depth) const noexcept;
+private:
+	static constexpr uint32_t tilesX = width / tileWidth;
+	static constexpr uint32_t tilesY = height / tileHeight;
+	static_assert(width % tileWidth == 0u && height % tileHeight == 0u, "tiles must cover the buffer exactly");
+	static_assert(tileWidth % 4u == 0u, "tile rows are rasterized 4 pixels at a time");
+	DirectX::XMFLOAT4X4 viewProj;
+	std::vector<Occluder> occluders;
+	std::vector<Triangle> triangles;
+	// triangle indices overlapping each tile
+	std::vector<std::vector<uint32_t>> bins;
+	std::vector<Level> levels;
+	// set once a rasterization has finished, until the next Begin
+	bool ready = false;
+	Stats stats;
+	// a few helpers are plenty for a buffer this small
+	WorkerPool pool;
+	std::mutex mtx;
+	std::condition_variable signal;
+	// between Rasterize and Resolve
+	bool pending = false;
+	bool finished = false;
+	bool stopping = false;
+	std::exception_ptr pError;
+	// last, it starts running once everything it touches is there
+	std::thread rasterizer;
+};
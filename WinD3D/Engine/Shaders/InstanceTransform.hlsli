@@ -0,0 +1,11 @@
+struct InstanceTransform
+{
+    matrix modelView;
+    matrix modelViewProj;
+};
+
+// size must match InstanceCbuf::maxInstances
+cbuffer InstanceCBuf
+{
+    InstanceTransform instances[256];
+};
@@ -0,0 +1 @@
+#include "PhongDifNrm_Inst_VS.hlsl"
\ No newline at end of file
@@ -0,0 +1,28 @@
+#include "InstanceTransform.hlsli"
+#include "VertexDecode.hlsli"
+
+struct VSOut
+{
+    float3 viewPos : Position;
+    float3 viewNormal : Normal;
+    float3 tan : Tangent;
+    float3 bitan : Bitangent;
+    float2 tc : Texcoord;
+    float4 pos : SV_Position;
+};
+
+VSOut main(float3 pos : Position, float2 octN : Normal, float2 tc : Texcoord, float4 octTan : Tangent, uint instance : SV_InstanceID)
+{
+    const float3 n = DecodeOctahedral(octN);
+    float3 tan, bitan;
+    DecodeTangentFrame(n, octTan, tan, bitan);
+    const InstanceTransform tf = instances[instance];
+    VSOut vso;
+    vso.viewPos = (float3) mul(float4(pos, 1.0f), tf.modelView);
+    vso.viewNormal = mul(n, (float3x3) tf.modelView);
+    vso.tan = mul(tan, (float3x3) tf.modelView);
+    vso.bitan = mul(bitan, (float3x3) tf.modelView);
+    vso.pos = mul(float4(pos, 1.0f), tf.modelViewProj);
+    vso.tc = tc;
+    return vso;
+}
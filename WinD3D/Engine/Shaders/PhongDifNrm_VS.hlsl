@@ -1,3 +1,5 @@
+#include "VertexDecode.hlsli"
+
 cbuffer CBuf
 {
     matrix modelView;
@@ -14,8 +16,11 @@ struct VSOut
     float4 pos : SV_Position;
 };
 
-VSOut main(float3 pos : Position, float3 n : Normal, float2 tc : Texcoord, float3 tan : Tangent, float3 bitan : Bitangent)
+VSOut main(float3 pos : Position, float2 octN : Normal, float2 tc : Texcoord, float4 octTan : Tangent)
 {
+    const float3 n = DecodeOctahedral(octN);
+    float3 tan, bitan;
+    DecodeTangentFrame(n, octTan, tan, bitan);
     VSOut vso;
     vso.viewPos = (float3) mul(float4(pos, 1.0f), modelView);
     vso.viewNormal = mul(n, (float3x3) modelView);
@@ -0,0 +1 @@
+#include "PhongDif_Inst_VS.hlsl"
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include "VertexDecode.hlsli"
+
 cbuffer TransformCBuf
 {
     matrix modelView;
@@ -12,8 +14,9 @@ struct VSOut
     float4 pos : SV_Position;
 };
 
-VSOut main(float3 pos : Position, float3 n : Normal, float2 tc : Texcoord)
+VSOut main(float3 pos : Position, float2 octN : Normal, float2 tc : Texcoord)
 {
+    const float3 n = DecodeOctahedral(octN);
     VSOut vso;
     vso.viewPos = (float3) mul(float4(pos, 1.0f), modelView);
     vso.viewNormal = mul(n, (float3x3) modelView);
@@ -0,0 +1,20 @@
+#include "InstanceTransform.hlsli"
+#include "VertexDecode.hlsli"
+
+struct VSOut
+{
+    float3 viewPos : Position;
+    float3 viewNormal : Normal;
+    float4 pos : SV_Position;
+};
+
+VSOut main(float3 pos : Position, float2 octN : Normal, uint instance : SV_InstanceID)
+{
+    const float3 n = DecodeOctahedral(octN);
+    const InstanceTransform tf = instances[instance];
+    VSOut vso;
+    vso.viewPos = (float3) mul(float4(pos, 1.0f), tf.modelView);
+    vso.viewNormal = mul(n, (float3x3) tf.modelView);
+    vso.pos = mul(float4(pos, 1.0f), tf.modelViewProj);
+    return vso;
+}
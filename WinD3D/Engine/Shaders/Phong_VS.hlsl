@@ -1,3 +1,5 @@
+#include "VertexDecode.hlsli"
+
 cbuffer CBuf
 {
     matrix modelView;
@@ -11,8 +13,9 @@ struct VSOut
     float4 pos : SV_Position;
 };
 
-VSOut main(float3 pos : Position, float3 n : Normal)
+VSOut main(float3 pos : Position, float2 octN : Normal)
 {
+    const float3 n = DecodeOctahedral(octN);
     VSOut vso;
     vso.viewPos = (float3) mul(float4(pos, 1.0f), modelView);
     vso.viewNormal = mul(n, (float3x3) modelView);
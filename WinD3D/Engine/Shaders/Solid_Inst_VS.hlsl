@@ -0,0 +1,6 @@
+#include "InstanceTransform.hlsli"
+
+float4 main(float3 pos : POSITION, uint instance : SV_InstanceID) : SV_POSITION
+{
+    return mul(float4(pos, 1.0f), instances[instance].modelViewProj);
+}
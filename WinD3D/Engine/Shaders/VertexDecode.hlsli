@@ -0,0 +1,19 @@
+// decoding of the compressed vertex elements, see DV::VertexLayout::Map
+// quantized positions need none here, the transforms take them to the mesh's space
+
+// inverse of DV::EncodeOctahedral
+float3 DecodeOctahedral(const in float2 e)
+{
+    float3 v = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    // unfold the lower half from the corners of the square
+    const float fold = saturate(-v.z);
+    v.xy += v.xy >= 0.0f ? -fold : fold;
+    return normalize(v);
+}
+
+// tangent of an OctTangent element, the bitangent from the handedness in its w
+void DecodeTangentFrame(const in float3 n, const in float4 packedTan, out float3 tan, out float3 bitan)
+{
+    tan = DecodeOctahedral(packedTan.xy * 2.0f - 1.0f);
+    bitan = cross(n, tan) * (packedTan.w * 2.0f - 1.0f);
+}
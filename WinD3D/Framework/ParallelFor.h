@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+// true on a thread while it runs work for a ParallelFor, the calling thread included
+inline bool& IsInParallelFor() noexcept
+{
+	thread_local bool inside = false;
+	return inside;
+}
+
+// calls work(i) for every i in [0, count) on the calling thread and up to threadCount - 1
+// helpers, indices handed out one at a time from a shared counter; results stay deterministic
+// as long as work(i) only writes what belongs to i. rethrows the first exception a thread threw.
+// nested in another ParallelFor it runs serially: the outer one already keeps every core busy,
+// splitting again would start threadCount helpers for each of its indices
+template<typename F>
+void ParallelFor(size_t count, F&& work, unsigned threadCount = std::thread::hardware_concurrency())
+{
+	if (IsInParallelFor())
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			work(i);
+		}
+		return;
+	}
+	std::atomic<size_t> next = 0u;
+	const auto run = [&]
+	{
+		// async may hand out pooled threads, the flag must not outlive the work
+		auto& inside = IsInParallelFor();
+		inside = true;
+		try
+		{
+			for (auto i = next++; i < count; i = next++)
+			{
+				work(i);
+			}
+		}
+		catch (...)
+		{
+			inside = false;
+			throw;
+		}
+		inside = false;
+	};
+	const auto helperCount = size_t(std::max(threadCount, 1u) - 1u);
+	std::vector<std::future<void>> helpers;
+	for (size_t i = 0; i < std::min(helperCount, count); i++)
+	{
+		helpers.push_back(std::async(std::launch::async, run));
+	}
+	run();
+	for (auto& h : helpers)
+	{
+		h.get();
+	}
+}
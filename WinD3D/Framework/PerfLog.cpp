@@ -0,0 +1,227 @@
+#include "PerfLog.h"
+#include <atomic>
+#include <array>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+	struct Ring
+	{
+		std::array<PerfLog::Event, PerfLog::ringSize> events;
+		// events ever written, only the owning thread stores to it
+		std::atomic<uint64_t> head{ 0u };
+		// guarded by the registry mutex
+		bool leased = false;
+	};
+	struct Registry
+	{
+		std::mutex mtx;
+		std::vector<std::unique_ptr<Ring>> rings;
+		std::atomic<uint32_t> frame{ 0u };
+		// start of frame f lives in slot f % frameHistory
+		std::array<std::atomic<uint64_t>, PerfLog::frameHistory> frameStarts = {};
+		const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	};
+	Registry& GetRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	// a thread holds its ring for as long as it lives; rings of exited threads go to new
+	// ones, so the per-frame recording workers don't grow the registry, and the ring index
+	// doubles as a stable lane id in the trace
+	class RingLease
+	{
+	public:
+		RingLease()
+		{
+			auto& reg = GetRegistry();
+			std::lock_guard<std::mutex> lock(reg.mtx);
+			for (size_t i = 0; i < reg.rings.size(); i++)
+			{
+				if (!reg.rings[i]->leased)
+				{
+					pRing = reg.rings[i].get();
+					lane = uint32_t(i);
+					break;
+				}
+			}
+			if (pRing == nullptr)
+			{
+				lane = uint32_t(reg.rings.size());
+				pRing = reg.rings.emplace_back(std::make_unique<Ring>()).get();
+			}
+			pRing->leased = true;
+		}
+		~RingLease()
+		{
+			std::lock_guard<std::mutex> lock(GetRegistry().mtx);
+			pRing->leased = false;
+		}
+	public:
+		Ring* pRing = nullptr;
+		uint32_t lane = 0u;
+	};
+	RingLease& GetLease()
+	{
+		thread_local RingLease lease;
+		return lease;
+	}
+
+	void WriteEscaped(std::ofstream& file, const char* str)
+	{
+		for (; *str != '\0'; str++)
+		{
+			if (*str == '"' || *str == '\\')
+			{
+				file << '\\';
+			}
+			file << *str;
+		}
+	}
+}
+
+PerfLog::Scope::Scope(const char* name, const char* category) noexcept
+	:
+	name(name),
+	category(category),
+	begin(Now())
+{}
+PerfLog::Scope::~Scope()
+{
+	End();
+}
+void PerfLog::Scope::End() noexcept
+{
+	if (!ended)
+	{
+		ended = true;
+		Record({ name, category, begin, Now(), 0u, GetRegistry().frame.load(std::memory_order_relaxed) });
+	}
+}
+
+void PerfLog::NextFrame() noexcept
+{
+	auto& reg = GetRegistry();
+	const auto next = reg.frame.load(std::memory_order_relaxed) + 1u;
+	reg.frameStarts[next % frameHistory].store(Now(), std::memory_order_relaxed);
+	reg.frame.store(next, std::memory_order_release);
+}
+
+std::vector<float> PerfLog::GetFrameTimes()
+{
+	auto& reg = GetRegistry();
+	const auto current = reg.frame.load(std::memory_order_acquire);
+	// frame 0 has no recorded start, and the current frame isn't finished
+	const auto count = std::min<size_t>(current > 0u ? current - 1u : 0u, frameHistory - 1u);
+	std::vector<float> times;
+	times.reserve(count);
+	for (auto f = current - uint32_t(count); f < current; f++)
+	{
+		const auto begin = reg.frameStarts[f % frameHistory].load(std::memory_order_relaxed);
+		const auto end = reg.frameStarts[(f + 1u) % frameHistory].load(std::memory_order_relaxed);
+		times.push_back(float(end - begin) / 1e6f);
+	}
+	return times;
+}
+
+PerfLog::FrameStats PerfLog::GetFrameStats()
+{
+	auto times = GetFrameTimes();
+	FrameStats stats;
+	stats.frames = times.size();
+	if (times.empty())
+	{
+		return stats;
+	}
+	std::sort(times.begin(), times.end());
+	const auto last = times.size() - 1u;
+	stats.p50 = times[last / 2u];
+	stats.p99 = times[size_t(float(last) * 0.99f)];
+	stats.worst = times.back();
+	return stats;
+}
+
+std::vector<PerfLog::Event> PerfLog::GetEvents(size_t frames)
+{
+	auto& reg = GetRegistry();
+	const auto current = reg.frame.load(std::memory_order_acquire);
+	std::vector<Event> events;
+	std::vector<Event> scratch;
+	std::lock_guard<std::mutex> lock(reg.mtx);
+	for (size_t lane = 0; lane < reg.rings.size(); lane++)
+	{
+		const auto& ring = *reg.rings[lane];
+		const auto head = ring.head.load(std::memory_order_acquire);
+		const auto first = head > ringSize ? head - ringSize : 0u;
+		scratch.clear();
+		for (auto i = first; i < head; i++)
+		{
+			scratch.push_back(ring.events[i % ringSize]);
+		}
+		// slots the writer got to lap while we were copying may be torn, skip them
+		const auto headAfter = ring.head.load(std::memory_order_acquire);
+		const auto valid = headAfter >= ringSize ? headAfter - ringSize + 1u : 0u;
+		for (auto i = std::max(first, valid); i < head; i++)
+		{
+			auto e = scratch[size_t(i - first)];
+			if (e.frame < current && e.frame + frames >= current)
+			{
+				e.thread = uint32_t(lane);
+				events.push_back(e);
+			}
+		}
+	}
+	std::sort(events.begin(), events.end(), [](const Event& a, const Event& b)
+	{
+		return a.begin < b.begin;
+	});
+	return events;
+}
+
+bool PerfLog::DumpChromeTrace(const std::string& path, size_t frames)
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		return false;
+	}
+	const auto events = GetEvents(frames);
+	file.setf(std::ios::fixed);
+	file.precision(3);
+	file << "{\"traceEvents\":[";
+	for (size_t i = 0; i < events.size(); i++)
+	{
+		const auto& e = events[i];
+		file << (i == 0u ? "\n" : ",\n") << "{\"name\":\"";
+		WriteEscaped(file, e.name);
+		file << "\",\"cat\":\"";
+		WriteEscaped(file, e.category);
+		// trace_event timestamps are microseconds
+		file << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread
+			<< ",\"ts\":" << double(e.begin) / 1e3
+			<< ",\"dur\":" << double(e.end - e.begin) / 1e3
+			<< ",\"args\":{\"frame\":" << e.frame << "}}";
+	}
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return bool(file);
+}
+
+uint64_t PerfLog::Now() noexcept
+{
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - GetRegistry().epoch).count());
+}
+
+void PerfLog::Record(const Event& e) noexcept
+{
+	auto& ring = *GetLease().pRing;
+	const auto head = ring.head.load(std::memory_order_relaxed);
+	ring.events[head % ringSize] = e;
+	ring.head.store(head + 1u, std::memory_order_release);
+}
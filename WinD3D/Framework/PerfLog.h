@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+// times the rest of the enclosing scope; name and category must outlive the log (literals, pass names)
+#define PERF_SCOPE(name) PerfLog::Scope PERF_CONCAT(perfScope, __LINE__){ name }
+#define PERF_SCOPE_CAT(name, category) PerfLog::Scope PERF_CONCAT(perfScope, __LINE__){ name, category }
+
+// CPU frame profiler: scoped timers are written into a ring owned by the recording thread,
+// so recording takes no lock; readers copy out what has been published and drop anything
+// the writer may have lapped meanwhile
+class PerfLog
+{
+public:
+	struct Event
+	{
+		const char* name;
+		const char* category;
+		// nanoseconds since the log started
+		uint64_t begin;
+		uint64_t end;
+		uint32_t thread;
+		uint32_t frame;
+	};
+	struct FrameStats
+	{
+		size_t frames = 0u;
+		float p50 = 0.0f;
+		float p99 = 0.0f;
+		float worst = 0.0f;
+	};
+	class Scope
+	{
+	public:
+		Scope(const char* name, const char* category = "cpu") noexcept;
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		~Scope();
+		// closes the scope early, for spans that don't match a C++ block
+		void End() noexcept;
+	private:
+		const char* name;
+		const char* category;
+		uint64_t begin;
+		bool ended = false;
+	};
+public:
+	// marks the start of a new frame, call once per frame from the main thread
+	static void NextFrame() noexcept;
+	// milliseconds, oldest first, at most the frame history
+	static std::vector<float> GetFrameTimes();
+	static FrameStats GetFrameStats();
+	// events of the last `frames` completed frames, oldest first
+	static std::vector<Event> GetEvents(size_t frames);
+	// writes the last `frames` frames as chrome://tracing (trace_event) json, false if the file can't be written
+	static bool DumpChromeTrace(const std::string& path, size_t frames);
+public:
+	// events kept per thread and frame durations kept, both powers of 2
+	static constexpr size_t ringSize = 16384u;
+	static constexpr size_t frameHistory = 512u;
+private:
+	static uint64_t Now() noexcept;
+	static void Record(const Event& e) noexcept;
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// helper threads started once and parked between calls, for work issued every frame where
+// ParallelFor would launch its helpers anew each time. Run has the same contract as ParallelFor:
+// work(i) for every i in [0, count) on the calling thread and the helpers, first exception
+// rethrown. one Run at a time, it is not meant to be shared between callers
+class WorkerPool
+{
+public:
+	explicit WorkerPool(unsigned helperCount)
+	{
+		for (unsigned i = 0; i < helperCount; i++)
+		{
+			threads.emplace_back([this] { Loop(); });
+		}
+	}
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& t : threads)
+		{
+			t.join();
+		}
+	}
+	template<typename F>
+	void Run(size_t count, F&& work)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			pWork = const_cast<void*>(static_cast<const void*>(std::addressof(work)));
+			pInvoke = [](void* p, size_t i)
+			{
+				(*static_cast<std::remove_reference_t<F>*>(p))(i);
+			};
+			workCount = count;
+			next = 0u;
+			busy = threads.size();
+			generation++;
+		}
+		wake.notify_all();
+		Work();
+		std::unique_lock<std::mutex> lock(mtx);
+		done.wait(lock, [this] { return busy == 0u; });
+		if (pError)
+		{
+			std::rethrow_exception(std::exchange(pError, nullptr));
+		}
+	}
+	unsigned GetHelperCount() const noexcept
+	{
+		return unsigned(threads.size());
+	}
+private:
+	void Loop() noexcept
+	{
+		uint64_t seen = 0u;
+		std::unique_lock<std::mutex> lock(mtx);
+		while (true)
+		{
+			wake.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping)
+			{
+				return;
+			}
+			seen = generation;
+			lock.unlock();
+			Work();
+			lock.lock();
+			if (--busy == 0u)
+			{
+				done.notify_one();
+			}
+		}
+	}
+	// the job fields are only written under the lock before helpers are woken, read-only after
+	void Work() noexcept
+	{
+		try
+		{
+			for (auto i = next++; i < workCount; i = next++)
+			{
+				pInvoke(pWork, i);
+			}
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (!pError)
+			{
+				pError = std::current_exception();
+			}
+			// hand out no more indices, the others finish what they hold
+			next = workCount;
+		}
+	}
+private:
+	std::vector<std::thread> threads;
+	std::mutex mtx;
+	std::condition_variable wake;
+	std::condition_variable done;
+	bool stopping = false;
+	uint64_t generation = 0u;
+	size_t busy = 0u;
+	void* pWork = nullptr;
+	void (*pInvoke)(void*, size_t) = nullptr;
+	size_t workCount = 0u;
+	std::atomic<size_t> next{ 0u };
+	std::exception_ptr pError;
+};
@@ -55,7 +55,7 @@ public:
 		{
 			ReVertices[j++] = temp.vertices[i];
 		}
-		std::vector<unsigned short> ReIndices(temp.indices.size());
+		std::vector<uint32_t> ReIndices(temp.indices.size());
 		std::iota(ReIndices.begin(), ReIndices.end(), 0);
 
 		return{ std::move(ReVertices), std::move(ReIndices) };
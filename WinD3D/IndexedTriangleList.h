@@ -1,26 +1,30 @@
 #pragma once
 #include <Engine/Architecture/VertexLayout.h>
+#include <Engine/Entities/MeshOptimizer.h>
 #include <DirectXMath.h>
+#include <cstdint>
 
 class IndexedTriangleList
 {
 public:
 	IndexedTriangleList() = default;
-	IndexedTriangleList(DV::VertexBuffer verts, std::vector<unsigned short> inds)
+	IndexedTriangleList(DV::VertexBuffer verts, std::vector<uint32_t> inds)
 		:
 		vertices(std::move(verts)),
 		indices(std::move(inds))
 	{
 		assert(vertices.Count() > 2);
 		assert(indices.size() % 3 == 0);
+		MeshOptimizer::Optimize(vertices, indices);
 	}
 public:
 	void Deform(DirectX::FXMMATRIX matrix)
 	{
 		using Type = DV::VertexLayout::ElementType;
-		for (int i = 0; i < vertices.Count(); i++)
+		const auto positions = vertices.Span<Type::Position3D>();
+		for (size_t i = 0; i < positions.Count(); i++)
 		{
-			auto& pos = vertices[i].Attr<Type::Position3D>();
+			auto& pos = positions[i];
 			DirectX::XMStoreFloat3(
 				&pos,
 				DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&pos), matrix)
@@ -31,24 +35,27 @@ public:
 	{
 		using namespace DirectX;
 		using Type = DV::VertexLayout::ElementType;
+		const auto positions = vertices.Span<Type::Position3D>();
+		const auto normals = vertices.Span<Type::Normal>();
 		for (size_t i = 0; i < indices.size(); i += 3)
 		{
-			auto v0 = vertices[indices[i]];
-			auto v1 = vertices[indices[i + 1]];
-			auto v2 = vertices[indices[i + 2]];
-			const auto p0 = XMLoadFloat3(&v0.Attr<Type::Position3D>());
-			const auto p1 = XMLoadFloat3(&v1.Attr<Type::Position3D>());
-			const auto p2 = XMLoadFloat3(&v2.Attr<Type::Position3D>());
+			const auto i0 = indices[i];
+			const auto i1 = indices[i + 1];
+			const auto i2 = indices[i + 2];
+			const auto p0 = XMLoadFloat3(&positions[i0]);
+			const auto p1 = XMLoadFloat3(&positions[i1]);
+			const auto p2 = XMLoadFloat3(&positions[i2]);
 
 			const auto n = XMVector3Normalize(XMVector3Cross((p1 - p0), (p2 - p0)));
 
-			XMStoreFloat3(&v0.Attr<Type::Normal>(), n);
-			XMStoreFloat3(&v1.Attr<Type::Normal>(), n);
-			XMStoreFloat3(&v2.Attr<Type::Normal>(), n);
+			XMStoreFloat3(&normals[i0], n);
+			XMStoreFloat3(&normals[i1], n);
+			XMStoreFloat3(&normals[i2], n);
 		}
 	}
 
 public:
 	DV::VertexBuffer vertices;
-	std::vector<unsigned short> indices;
+	// the index buffer narrows these to 16 bit when they fit
+	std::vector<uint32_t> indices;
 };
\ No newline at end of file
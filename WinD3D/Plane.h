@@ -48,7 +48,7 @@ public:
 		}
 
 		//arrange Indicies
-		std::vector<unsigned short> indices(divX * divY * divX * divY * 6);
+		std::vector<uint32_t> indices(divX * divY * divX * divY * 6);
 		{
 			const auto vxy2i = [nVertX](size_t x, size_t y)
 			{
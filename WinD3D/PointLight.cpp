@@ -58,6 +58,8 @@ void PointLight::Bind(Graphics& gfx, DirectX::FXMMATRIX view) const noexcept
 	auto dataCopy = cbData;
 	const auto pos = DirectX::XMLoadFloat3A(&cbData.pos);
 	DirectX::XMStoreFloat3A(&dataCopy.pos, DirectX::XMVector3Transform(pos, view));
-	cbuf.Update(gfx, dataCopy);
-	cbuf.Bind(gfx);
+	CommandStream cmd;
+	cbuf.Update(cmd, dataCopy);
+	cbuf.Bind(gfx, cmd);
+	gfx.Execute(cmd);
 }
\ No newline at end of file
@@ -47,7 +47,7 @@ public:
 		}
 
 		// side indices
-		std::vector<unsigned short> indices;
+		std::vector<uint32_t> indices;
 		for (unsigned short iLong = 0; iLong < longDiv; iLong++)
 		{
 			const auto i = iLong * 2;
@@ -23,7 +23,7 @@ TestCube::TestCube(Graphics& gfx, float size)
 	{
 		Technique shade("Shade");
 		{
-			Step only(0);
+			Step only("phong");
 
 			only.AddBindable(Texture::Resolve(gfx, "Materials\\crate_diffuse.png"));
 			only.AddBindable(Sampler::Resolve(gfx));
@@ -56,7 +56,7 @@ TestCube::TestCube(Graphics& gfx, float size)
 	{
 		Technique outline("Outline");
 		{
-			Step mask(1);
+			Step mask("outlineMask");
 
 			auto pvs = VertexShader::Resolve(gfx, "SolidVS.cso");
 			auto pvsbc = pvs->GetBytecode();
@@ -71,7 +71,7 @@ TestCube::TestCube(Graphics& gfx, float size)
 			outline.AddStep(std::move(mask));
 		}
 		{
-			Step draw(2);
+			Step draw("outlineDraw");
 
 			// these can be pass-constant (tricky due to layout issues)
 			auto pvs = VertexShader::Resolve(gfx, "SolidVS.cso");
@@ -105,14 +105,15 @@ TestCube::TestCube(Graphics& gfx, float size)
 				{
 					probe.VisitBuffer(buf);
 				}
-				void Bind(Graphics& gfx) noexcept override
+				using TransformCbuf::Bind;
+				void Bind(Graphics& gfx, CommandStream& cmd, DirectX::FXMMATRIX world) noexcept override
 				{
 					const float scale = buf["scale"];
 					const auto scaleMatrix = dx::XMMatrixScaling(scale, scale, scale);
-					auto xf = GetTransforms(gfx);
+					auto xf = GetTransforms(gfx, world);
 					xf.modelView = xf.modelView * scaleMatrix;
 					xf.modelViewProj = xf.modelViewProj * scaleMatrix;
-					UpdateBindImpl(gfx, xf);
+					UpdateBindImpl(gfx, cmd, xf);
 				}
 			private:
 				static DC::RawLayout MakeLayout()
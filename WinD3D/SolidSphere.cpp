@@ -15,11 +15,12 @@ SolidSphere::SolidSphere(Graphics& gfx, float radius, DirectX::XMFLOAT3 color)
 
 	{
 		Technique solid;
-		Step only(0);
+		Step only("phong");
 
 		auto pvs = VertexShader::Resolve(gfx, "SolidVS.cso");
 		auto pvsbc = pvs->GetBytecode();
 		only.AddBindable(std::move(pvs));
+		only.EnableInstancing(gfx, "Solid_Inst_VS.cso");
 
 		only.AddBindable(PixelShader::Resolve(gfx, "SolidPS.cso"));
 
@@ -52,7 +52,7 @@ public:
 
 		const auto calcIdx = [latDiv, longDiv](unsigned short iLat, unsigned short iLong)
 		{ return iLat * longDiv + iLong; };
-		std::vector<unsigned short> indices;
+		std::vector<uint32_t> indices;
 		for (unsigned short iLat = 0; iLat < latDiv - 2; iLat++)
 		{
 			for (unsigned short iLong = 0; iLong < longDiv - 1; iLong++)